@@ -0,0 +1,211 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Convergence.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 26, 2026, 4:10 PM
+ */
+
+#include "Convergence.h"
+
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+Convergence::Convergence(double tolerance, Norm norm, bool relative) :
+tolerance_(tolerance), norm_(norm), relative_(relative) {
+    if (tolerance_ < 0.0) {
+        throw runtime_error("Error: The tolerance can't be negative.");
+    }
+}
+
+Convergence::~Convergence() {
+}
+
+double
+Convergence::tolerance() const {
+    return (tolerance_);
+}
+
+Convergence::Norm
+Convergence::norm() const {
+    return (norm_);
+}
+
+bool
+Convergence::relative() const {
+    return (relative_);
+}
+
+void
+Convergence::setStagnation(size_t checks, double factor) {
+    if (factor <= 0.0 || factor > 1.0) {
+        throw runtime_error("Error: The stagnation factor should be in (0, 1].");
+    }
+    stagnation_checks_ = checks;
+    stagnation_factor_ = factor;
+}
+
+size_t
+Convergence::stagnationChecks() const {
+    return (stagnation_checks_);
+}
+
+double
+Convergence::stagnationFactor() const {
+    return (stagnation_factor_);
+}
+
+void
+Convergence::setDivergence(double factor) {
+    if (factor < 0.0) {
+        throw runtime_error("Error: The divergence factor can't be negative.");
+    }
+    divergence_factor_ = factor;
+}
+
+double
+Convergence::divergenceFactor() const {
+    return (divergence_factor_);
+}
+
+double
+Convergence::accumulate(const double * r, size_t n, size_t stride) const {
+    double partial = 0.0;
+
+    if (norm_ == L1) {
+        for (size_t i = 0; i < n; i++) partial += abs(r[i * stride]);
+    } else if (norm_ == L2) {
+        for (size_t i = 0; i < n; i++) partial += r[i * stride] * r[i * stride];
+    } else {
+        for (size_t i = 0; i < n; i++) partial = max(partial, abs(r[i * stride]));
+    }
+
+    return (partial);
+}
+
+double
+Convergence::combine(double lhs, double rhs) const {
+    return (norm_ == LINF ? max(lhs, rhs) : lhs + rhs);
+}
+
+double
+Convergence::finish(double partial) const {
+    return (norm_ == L2 ? sqrt(partial) : partial);
+}
+
+double
+Convergence::measure(const Vector & r) const {
+    return (finish(accumulate(r.data(), r.size())));
+}
+
+double
+Convergence::threshold(double b_norm) const {
+    return (relative_ ? tolerance_ * b_norm : tolerance_);
+}
+
+bool
+Convergence::satisfied(const Vector & r, const Vector & b) const {
+    return (measure(r) <= threshold(relative_ ? measure(b) : 0.0));
+}
+
+string
+Convergence::name(Norm norm) {
+    switch (norm) {
+        case L1:
+            return ("l1");
+        case L2:
+            return ("l2");
+        default:
+            return ("inf");
+    }
+}
+
+Convergence::Norm
+Convergence::norm(const string & name) {
+    string lower(name);
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    if (lower == "l1") return (L1);
+    if (lower == "l2") return (L2);
+    if (lower == "inf" || lower == "linf") return (LINF);
+
+    throw runtime_error("Error: Unknown norm " + name + ". Please use l1, l2, or inf.");
+}
+
+string
+Convergence::name(Status status) {
+    switch (status) {
+        case CONVERGED:
+            return ("converged");
+        case STAGNATED:
+            return ("stagnated");
+        case DIVERGED:
+            return ("diverged");
+        default:
+            return ("did not converge");
+    }
+}
+
+Convergence::Status
+Convergence::worst(Status lhs, Status rhs) {
+    static const int ranks[] = {1, 0, 2, 3};
+    return (ranks[lhs] >= ranks[rhs] ? lhs : rhs);
+}
+
+ConvergenceMonitor::ConvergenceMonitor(const Convergence & criterion, double b_norm) :
+criterion_(criterion), threshold_(criterion.threshold(b_norm)) {
+}
+
+ConvergenceMonitor::~ConvergenceMonitor() {
+}
+
+Convergence::Status
+ConvergenceMonitor::check(double resid) {
+    if (!std::isfinite(resid)) {
+        status_ = Convergence::DIVERGED;
+        return (status_);
+    }
+
+    if (resid <= threshold_) {
+        status_ = Convergence::CONVERGED;
+        return (status_);
+    }
+
+    if (first_ < 0.0) first_ = resid;
+
+    double divergence = criterion_.divergenceFactor();
+    if (divergence > 0.0 && resid > divergence * first_) {
+        status_ = Convergence::DIVERGED;
+        return (status_);
+    }
+
+    // Progress is a residual below the factor of the smallest one so far
+    if (best_ < 0.0 || resid < criterion_.stagnationFactor() * best_) {
+        best_ = resid;
+        since_best_ = 0;
+    } else {
+        since_best_++;
+        if (criterion_.stagnationChecks() > 0 &&
+                since_best_ >= criterion_.stagnationChecks()) {
+            status_ = Convergence::STAGNATED;
+            return (status_);
+        }
+    }
+
+    status_ = Convergence::ITERATING;
+    return (status_);
+}
+
+Convergence::Status
+ConvergenceMonitor::status() const {
+    return (status_);
+}
+
+double
+ConvergenceMonitor::threshold() const {
+    return (threshold_);
+}
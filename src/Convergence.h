@@ -0,0 +1,141 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Convergence.h
+ * Author: Weiming Hu
+ *
+ * Created on October 26, 2026, 4:10 PM
+ */
+
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include "Vector.h"
+
+#include <string>
+
+// The default tolerance on the L1 norm of the residual
+#ifndef CONVERGENCE_TOLERANCE
+#define CONVERGENCE_TOLERANCE 1.0e-3
+#endif
+
+// A residual that is not smaller than this factor times the smallest
+// residual so far does not count as progress for the stagnation test
+//
+#ifndef CONVERGENCE_STAGNATION_FACTOR
+#define CONVERGENCE_STAGNATION_FACTOR 0.99
+#endif
+
+// The convergence criterion of the iterative solvers
+//
+// A solve has converged when ||r|| <= tolerance, or ||r|| <= tolerance *
+// ||b|| with a relative tolerance, in the L1, L2, or L-inf norm. The
+// default is the absolute L1 norm. Optionally, a solve stops early when
+// the residual stagnates or diverges.
+//
+// The norm of a vector that is split between threads or processes is
+// computed in parts with accumulate(), which are combined with combine()
+// (or MPI_SUM and MPI_MAX for the L-inf norm) and then finish().
+//
+class Convergence {
+public:
+
+    enum Norm {
+        L1,
+        L2,
+        LINF
+    };
+
+    // ITERATING is also the status of a solve that reached max_it
+    enum Status {
+        ITERATING,
+        CONVERGED,
+        STAGNATED,
+        DIVERGED
+    };
+
+    explicit Convergence(double tolerance = CONVERGENCE_TOLERANCE,
+            Norm norm = L1, bool relative = false);
+    virtual ~Convergence();
+
+    double tolerance() const;
+    Norm norm() const;
+    bool relative() const;
+
+    // Stop when the residual has not become smaller than factor times the
+    // smallest residual in the given number of checks. 0 checks, which is
+    // the default, never stops.
+    //
+    void setStagnation(std::size_t checks,
+            double factor = CONVERGENCE_STAGNATION_FACTOR);
+    std::size_t stagnationChecks() const;
+    double stagnationFactor() const;
+
+    // Stop when the residual is larger than factor times the first one.
+    // 0, which is the default, never stops. A residual that is not finite
+    // always stops.
+    //
+    void setDivergence(double factor);
+    double divergenceFactor() const;
+
+    // The norm of n values with the given stride in parts
+    double accumulate(const double * r, std::size_t n,
+            std::size_t stride = 1) const;
+    double combine(double lhs, double rhs) const;
+    double finish(double partial) const;
+
+    // The norm of a vector
+    double measure(const Vector & r) const;
+
+    // The largest norm of the residual that has converged for the norm of b
+    double threshold(double b_norm) const;
+
+    // Check the residual r of Ax = b
+    bool satisfied(const Vector & r, const Vector & b) const;
+
+    // The name of a norm (l1, l2, or inf), and the norm of a name, which is
+    // case insensitive. An exception is thrown for an unknown name.
+    //
+    static std::string name(Norm norm);
+    static Norm norm(const std::string & name);
+
+    static std::string name(Status status);
+
+    // The worse of two statuses, e.g. for a batch of solves, in the order
+    // CONVERGED, ITERATING, STAGNATED, DIVERGED
+    //
+    static Status worst(Status lhs, Status rhs);
+
+private:
+    double tolerance_;
+    Norm norm_;
+    bool relative_;
+
+    std::size_t stagnation_checks_ = 0;
+    double stagnation_factor_ = CONVERGENCE_STAGNATION_FACTOR;
+    double divergence_factor_ = 0.0;
+};
+
+// The state of the convergence test during one solve
+class ConvergenceMonitor {
+public:
+
+    // b_norm is the norm of b in the norm of the criterion
+    ConvergenceMonitor(const Convergence & criterion, double b_norm);
+    virtual ~ConvergenceMonitor();
+
+    // Check the norm of the residual of an iteration
+    Convergence::Status check(double resid);
+
+    Convergence::Status status() const;
+    double threshold() const;
+
+private:
+    Convergence criterion_;
+    double threshold_;
+    double first_ = -1.0;
+    double best_ = -1.0;
+    std::size_t since_best_ = 0;
+    Convergence::Status status_ = Convergence::ITERATING;
+};
+
+#endif /* CONVERGENCE_H */
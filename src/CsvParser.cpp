@@ -0,0 +1,164 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   CsvParser.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 20, 2026, 10:05 AM
+ */
+
+#include "CsvParser.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Exact powers of 10 for the fast path of parseDouble
+static const double _POWERS_OF_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool
+isBlank(char c) {
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+// Numbers with at most 19 significant digits, a mantissa up to 2^53, and a
+// decimal exponent within [-22, 22] are converted exactly with a single
+// multiplication or division. Other numbers fall back to strtod.
+//
+const char *
+parseDouble(const char *p, const char *end, double & value) {
+    const char *start = p;
+    bool negative = false, any_digit = false, truncated = false;
+    uint64_t mantissa = 0;
+    int ndigits = 0, exponent = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        any_digit = true;
+        if (mantissa == 0 && *p == '0') continue;
+        if (ndigits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            ndigits++;
+        } else {
+            exponent++;
+            truncated = true;
+        }
+    }
+
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            any_digit = true;
+            if (mantissa == 0 && *p == '0') {
+                exponent--;
+            } else if (ndigits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                ndigits++;
+                exponent--;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+
+    if (any_digit && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool exponent_negative = false;
+        int exponent_value = 0;
+
+        if (q < end && (*q == '-' || *q == '+')) {
+            exponent_negative = (*q == '-');
+            q++;
+        }
+
+        if (q < end && *q >= '0' && *q <= '9') {
+            for (; q < end && *q >= '0' && *q <= '9'; q++) {
+                if (exponent_value < 100000) exponent_value = exponent_value * 10 + (*q - '0');
+            }
+            exponent += (exponent_negative ? -exponent_value : exponent_value);
+            p = q;
+        } else {
+            // The exponent has no digits
+            return (nullptr);
+        }
+    }
+
+    if (any_digit && !truncated && mantissa <= (1ULL << 53) &&
+            exponent >= -22 && exponent <= 22) {
+        value = (double) mantissa;
+        value = (exponent < 0 ? value / _POWERS_OF_10[-exponent] : value * _POWERS_OF_10[exponent]);
+        if (negative) value = -value;
+        return (p);
+    }
+
+    // Fall back to strtod for the remaining cases, e.g. inf and nan
+    if (!any_digit) {
+        p = start;
+        while (p < end && *p != ',' && *p != '\n' && !isBlank(*p)) p++;
+        if (p == start) return (nullptr);
+    }
+
+    char buffer[128];
+    string long_buffer;
+    const char *token = buffer;
+    size_t length = p - start;
+
+    if (length < sizeof (buffer)) {
+        memcpy(buffer, start, length);
+        buffer[length] = '\0';
+    } else {
+        long_buffer.assign(start, length);
+        token = long_buffer.c_str();
+    }
+
+    char *token_end = nullptr;
+    value = strtod(token, &token_end);
+    if (token_end != token + length) return (nullptr);
+
+    return (p);
+}
+
+bool
+parseLine(const char *p, const char *end, double *row, size_t ncols, size_t & count) {
+    count = 0;
+
+    while (true) {
+        while (p < end && isBlank(*p)) p++;
+        if (p == end) return (count > 0);
+
+        double value;
+        p = parseDouble(p, end, value);
+        if (p == nullptr) return (false);
+
+        if (row && count < ncols) row[count] = value;
+        count++;
+
+        while (p < end && isBlank(*p)) p++;
+        if (p == end) return (true);
+        if (*p != ',') return (false);
+        p++;
+    }
+}
+
+bool
+isEmptyLine(const char *p, const char *end) {
+    for (; p < end; p++) {
+        if (!isBlank(*p)) return (false);
+    }
+    return (true);
+}
+
+size_t
+lineStart(const char *text, size_t length, size_t pos) {
+    if (pos == 0) return (0);
+    const char *p = static_cast<const char *> (memchr(text + pos - 1, '\n', length - pos + 1));
+    return (p ? p - text + 1 : length);
+}
@@ -0,0 +1,35 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   CsvParser.h
+ * Author: Weiming Hu
+ *
+ * Created on October 20, 2026, 10:05 AM
+ */
+
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <cstddef>
+
+// Helpers to parse csv files that are mapped into memory. They are shared
+// by the readers of the dense and the sparse matrices.
+
+// Parse a double from [p, end). The pointer after the number is returned,
+// or nullptr when no number can be parsed.
+//
+const char * parseDouble(const char *p, const char *end, double & value);
+
+// Parse comma separated values in the line [p, end). At most ncols values
+// are written to row when it is not nullptr. The number of values in
+// the line is stored in count.
+//
+bool parseLine(const char *p, const char *end, double *row,
+        std::size_t ncols, std::size_t & count);
+
+// Whether the line [p, end) has anything other than blanks
+bool isEmptyLine(const char *p, const char *end);
+
+// The beginning of the first line that starts at or after pos
+std::size_t lineStart(const char *text, std::size_t length, std::size_t pos);
+
+#endif /* CSVPARSER_H */
@@ -0,0 +1,334 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedJacobi.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 18, 2026, 10:40 AM
+ */
+
+#include "DistributedJacobi.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <memory>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+DistributedJacobi::DistributedJacobi(const Matrix & A, const Vector & b,
+        MPI_Comm comm, int root, int nprows, int npcols) :
+A_(A, comm, root, nprows, npcols) {
+
+    // The length of b is broadcast so that all ranks throw together
+    unsigned long long length = b.size();
+    MPI_Bcast(&length, 1, MPI_UNSIGNED_LONG_LONG, root, comm);
+
+    if (length != A_.grid().rows().nrows()) {
+        throw runtime_error("Matrix and vector do not have correct shapes.");
+    }
+
+    A_.scatter(b, b_own_, root);
+    setUp();
+}
+
+DistributedJacobi::DistributedJacobi(const ProcessGrid & grid,
+        const Matrix & A_block, const Vector & b_rows) :
+A_(grid, A_block) {
+
+    if (b_rows.size() != grid.rows().size()) {
+        throw runtime_error("Local blocks do not match the process grid.");
+    }
+
+    size_t offset = grid.ownBegin() - grid.rows().begin();
+    b_own_.resize(grid.ownSize());
+    copy(b_rows.data() + offset, b_rows.data() + offset + b_own_.size(), b_own_.data());
+
+    setUp();
+}
+
+DistributedJacobi::DistributedJacobi(const ProcessGrid & grid,
+        const FunctionOperator::EntryFunction & entry, const Vector & b_rows) :
+A_(grid, entry) {
+
+    if (b_rows.size() != grid.rows().size()) {
+        throw runtime_error("Local blocks do not match the process grid.");
+    }
+
+    size_t offset = grid.ownBegin() - grid.rows().begin();
+    b_own_.resize(grid.ownSize());
+    copy(b_rows.data() + offset, b_rows.data() + offset + b_own_.size(), b_own_.data());
+
+    setUp();
+}
+
+DistributedJacobi::~DistributedJacobi() {
+}
+
+void
+DistributedJacobi::setUp() {
+    const ProcessGrid & grid = A_.grid();
+    size_t own_begin = grid.ownBegin(), own_size = grid.ownSize();
+
+    D_inv_own_.resize(own_size);
+    x_own_.resize(own_size);
+    x_next_.resize(own_size);
+    sums_own_.resize(own_size);
+
+    // All ranks have to agree before anyone throws, otherwise the others
+    // would wait forever in the next collective call.
+    //
+    long long bad_row = -1;
+    for (size_t k = 0; k < own_size; k++) {
+        double diag = A_.diagonal(k);
+        if (abs(diag) < _ZERO_LIMIT) {
+            bad_row = own_begin + k;
+            break;
+        }
+        D_inv_own_[k] = 1.0 / diag;
+    }
+
+    long long first_bad = -1;
+    MPI_Allreduce(&bad_row, &first_bad, 1, MPI_LONG_LONG, MPI_MAX, grid.comm());
+
+    if (first_bad >= 0) {
+        ostringstream message;
+        message << "Error: 0 occurs on the diagonal at row " << first_bad << ".";
+        throw runtime_error(message.str());
+    }
+}
+
+double
+DistributedJacobi::update(double omega) {
+    long own_size = x_own_.size();
+    double local_metric = 0.0;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(own_size);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(own_size, omega) reduction(+:local_metric)
+#endif
+    for (long k = 0; k < own_size; k++) {
+        double r = b_own_[k] - sums_own_[k];
+        double dx = D_inv_own_[k] * r;
+
+        local_metric += abs(metric_ == RESIDUAL ? r : dx);
+
+        if (omega == 1.0) {
+            x_next_[k] = x_own_[k] + dx;
+        } else {
+            x_next_[k] += omega * (x_own_[k] + dx - x_next_[k]);
+        }
+    }
+
+    return (local_metric);
+}
+
+double
+DistributedJacobi::sweep(double omega) {
+    A_.multiply(x_own_, sums_own_);
+    double local_metric = update(omega), metric = 0.0;
+    x_own_.swap(x_next_);
+
+    MPI_Allreduce(&local_metric, &metric, 1, MPI_DOUBLE, MPI_SUM, A_.grid().comm());
+    return (metric);
+}
+
+double
+DistributedJacobi::solve(Vector & x, size_t max_it,
+        double small_resid, int verbose) {
+
+    const ProcessGrid & grid = A_.grid();
+    if (pipelined_ && grid.npcols() != 1) {
+        throw runtime_error("Error: The pipelined mode needs one process column.");
+    }
+
+    // The estimate uses the buffers of x, so it comes first
+    double rho = (chebyshev_ ? spectralRadius() : 0.0);
+    bool accelerate = (chebyshev_ && rho >= 0.0 && rho < 1.0);
+    ChebyshevWeights weights(rho);
+
+    x.resize(grid.rows().nrows());
+    A_.scatter(x, x_own_, 0);
+
+    double resid = 999;
+
+    if (pipelined_) {
+        resid = solvePipelined(max_it, small_resid, verbose, weights, accelerate);
+    } else {
+        for (size_t i_it = 0; i_it < max_it && resid > small_resid; i_it++) {
+            resid = sweep(accelerate ? weights.next() : 1.0);
+
+            if (verbose >= 2 && grid.rank() == 0) {
+                cout << "Iteration " << i_it + 1 << " residual: " << resid << endl;
+            }
+        }
+    }
+
+    A_.allgather(x_own_, x);
+    return (resid);
+}
+
+double
+DistributedJacobi::solvePipelined(size_t max_it, double small_resid, int verbose,
+        ChebyshevWeights & weights, bool accelerate) {
+
+    const ProcessGrid & grid = A_.grid();
+    const double *x_cols = A_.columns().data();
+    size_t n = A_.columns().size(), begin = grid.ownBegin(), end = grid.ownEnd();
+    MPI_Request gather = MPI_REQUEST_NULL, reduce = MPI_REQUEST_NULL;
+
+    // The metric of the previous iteration, which is being reduced
+    double local_metric = 0.0, resid = 999;
+
+    // x_own_ always holds the newest local part of the solution. It is also
+    // the send buffer of the gather, which may be read while the gather is
+    // in progress.
+    //
+    A_.gatherColumns(x_own_);
+
+    size_t i_it = 0;
+    for (; i_it < max_it; i_it++) {
+
+        // The diagonal block only needs the local part of x
+        A_.accumulate(begin, end, x_own_.data());
+
+        // The remote parts of x are needed for the rest of the columns
+        MPI_Wait(&gather, MPI_STATUS_IGNORE);
+        A_.accumulate(0, begin, x_cols);
+        A_.accumulate(end, n, x_cols + end);
+        A_.reduceSums(sums_own_);
+        double next_metric = update(accelerate ? weights.next() : 1.0);
+
+        // Check the residual of the previous iteration. If it has
+        // converged, x is already the solution of that iteration and the
+        // update just computed is discarded.
+        //
+        if (i_it > 0) {
+            MPI_Wait(&reduce, MPI_STATUS_IGNORE);
+
+            if (verbose >= 2 && grid.rank() == 0) {
+                cout << "Iteration " << i_it << " residual: " << resid << endl;
+            }
+
+            if (resid <= small_resid) return (resid);
+        }
+
+        local_metric = next_metric;
+        x_own_.swap(x_next_);
+
+        MPI_Iallreduce(&local_metric, &resid, 1, MPI_DOUBLE, MPI_SUM, grid.comm(), &reduce);
+        A_.igatherColumns(x_own_, &gather);
+    }
+
+    MPI_Wait(&gather, MPI_STATUS_IGNORE);
+    if (i_it > 0) {
+        MPI_Wait(&reduce, MPI_STATUS_IGNORE);
+
+        if (verbose >= 2 && grid.rank() == 0) {
+            cout << "Iteration " << i_it << " residual: " << resid << endl;
+        }
+    }
+
+    return (resid);
+}
+
+void
+DistributedJacobi::setMetric(Metric metric) {
+    metric_ = metric;
+}
+
+DistributedJacobi::Metric
+DistributedJacobi::metric() const {
+    return (metric_);
+}
+
+void
+DistributedJacobi::setPipelined(bool pipelined) {
+    pipelined_ = pipelined;
+}
+
+bool
+DistributedJacobi::pipelined() const {
+    return (pipelined_);
+}
+
+void
+DistributedJacobi::setChebyshev(bool chebyshev) {
+    chebyshev_ = chebyshev;
+}
+
+bool
+DistributedJacobi::chebyshev() const {
+    return (chebyshev_);
+}
+
+void
+DistributedJacobi::setSpectralRadius(double rho) {
+    rho_ = rho;
+}
+
+double
+DistributedJacobi::spectralRadius() {
+    if (rho_ >= 0.0) return (rho_);
+
+    // The power iterations of jacobiRadius() on the parts of the vectors.
+    // x_own is v, and x_next is G * v.
+    //
+    const ProcessGrid & grid = A_.grid();
+    size_t own_begin = grid.ownBegin(), own_size = x_own_.size();
+
+    for (size_t k = 0; k < own_size; k++) {
+        x_own_[k] = 1.0 + (double) ((own_begin + k) % 10) / 10.0;
+    }
+
+    double local_norm = 0.0, v_norm = 0.0, rho = 0.0;
+    for (size_t k = 0; k < own_size; k++) local_norm += x_own_[k] * x_own_[k];
+    MPI_Allreduce(&local_norm, &v_norm, 1, MPI_DOUBLE, MPI_SUM, grid.comm());
+    v_norm = sqrt(v_norm);
+
+    for (size_t i_it = 0; i_it < CHEBYSHEV_POWER_STEPS; i_it++) {
+        A_.multiply(x_own_, sums_own_);
+
+        local_norm = 0.0;
+        for (size_t k = 0; k < own_size; k++) {
+            x_next_[k] = x_own_[k] - D_inv_own_[k] * sums_own_[k];
+            local_norm += x_next_[k] * x_next_[k];
+        }
+
+        double w_norm = 0.0;
+        MPI_Allreduce(&local_norm, &w_norm, 1, MPI_DOUBLE, MPI_SUM, grid.comm());
+        w_norm = sqrt(w_norm);
+
+        rho = w_norm / v_norm;
+        if (w_norm == 0.0 || !std::isfinite(w_norm)) break;
+
+        for (size_t k = 0; k < own_size; k++) x_own_[k] = x_next_[k] / w_norm;
+        v_norm = 1.0;
+    }
+
+    rho_ = CHEBYSHEV_RADIUS_FACTOR * rho;
+    return (rho_);
+}
+
+const ProcessGrid &
+DistributedJacobi::grid() const {
+    return (A_.grid());
+}
+
+const DistributedMatrix &
+DistributedJacobi::matrix() const {
+    return (A_);
+}
+
+const Matrix &
+DistributedJacobi::localMatrix() const {
+    return (A_.localMatrix());
+}
+
+const Vector &
+DistributedJacobi::localInverseDiagonal() const {
+    return (D_inv_own_);
+}
@@ -0,0 +1,152 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedJacobi.h
+ * Author: Weiming Hu
+ *
+ * Created on October 18, 2026, 10:40 AM
+ */
+
+#ifndef DISTRIBUTEDJACOBI_H
+#define DISTRIBUTEDJACOBI_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "DistributedMatrix.h"
+#include "Jacobi.h"
+
+#include <vector>
+#include <mpi.h>
+
+// Jacobi Method distributed over a process grid
+//
+// Each rank owns a block of A, b and D^-1 of the rows of its part of the
+// solution, and that part. One iteration assembles x_k(cols(c)) along the
+// grid column with one MPI_Allgatherv, computes the partial products
+// A(rows(r), cols(c)) * x_k(cols(c)), adds them up along the grid row with
+// one MPI_Reduce_scatter so that every rank receives the rows of its part
+// of the solution (see DistributedMatrix), updates
+//
+//   x_k+1(own) = x_k(own) + D^-1(own) * (b(own) - (A * x_k)(own))
+//
+// and adds up the L1 norm of the residual with one MPI_Allreduce. Every
+// rank only sends and receives O(N / sqrt(P)) values on a square grid.
+//
+// With one grid column, the row decomposition, there is nothing to reduce
+// along the grid row and x is gathered on all ranks.
+//
+// In the pipelined mode, which needs the row decomposition, both
+// collectives are non-blocking. The product with the diagonal block, for
+// which only the local part of x is needed, is computed while the rest of
+// x is still being gathered. The residual is only checked one iteration
+// later so that the reduction never stalls the iterations. The solution
+// and the number of iterations are the same as in the blocking mode.
+//
+// Both modes can be accelerated with the Chebyshev semi-iteration (see
+// ChebyshevWeights in Jacobi.h). Every rank computes the same weights, so
+// the iterations have the same communication as without it. Only the
+// estimate of the spectral radius before the first solve takes one
+// MPI_Allreduce per power iteration.
+//
+class DistributedJacobi {
+public:
+
+    // The vector whose L1 norm is checked for convergence
+    enum Metric {
+        // b - A * x
+        RESIDUAL,
+
+        // D^-1 * (b - A * x), which is the change of the solution
+        CORRECTION
+    };
+
+    // Send the blocks of A and b from the root rank. A and b are only read
+    // on root. The grid is nprows x npcols as in ProcessGrid. The default is
+    // the row decomposition.
+    //
+    DistributedJacobi(const Matrix & A, const Vector & b,
+            MPI_Comm comm = MPI_COMM_WORLD, int root = 0,
+            int nprows = 0, int npcols = 1);
+
+    // Use the blocks that are already distributed, for example read with
+    // hyperslabs. A_block is A(rows(r), cols(c)) and b_rows is b(rows(r)).
+    //
+    DistributedJacobi(const ProcessGrid & grid,
+            const Matrix & A_block, const Vector & b_rows);
+
+    // Compute the block of A of every rank from the entries a_ij as in
+    // DistributedMatrix. b_rows is b(rows(r)).
+    //
+    DistributedJacobi(const ProcessGrid & grid,
+            const FunctionOperator::EntryFunction & entry, const Vector & b_rows);
+
+    virtual ~DistributedJacobi();
+
+    // Iterate until the L1 norm of the residual is not larger than
+    // small_resid or max_it is reached. x is the initial guess on rank 0
+    // of the communicator and the solution on all ranks afterwards. The
+    // L1 norm of the last residual is returned.
+    //
+    double solve(Vector & x, std::size_t max_it,
+            double small_resid, int verbose = 0);
+
+    void setMetric(Metric metric);
+    Metric metric() const;
+
+    // Overlap communication with computation in solve()
+    void setPipelined(bool pipelined);
+    bool pipelined() const;
+
+    // Accelerate solve() with the Chebyshev semi-iteration. When the
+    // spectral radius is not at least 0 and smaller than 1, the iterations
+    // are not accelerated. The default is off.
+    //
+    void setChebyshev(bool chebyshev);
+    bool chebyshev() const;
+
+    // The spectral radius of I - D^-1 * A for the Chebyshev semi-iteration.
+    // Unless it is set, it is estimated with CHEBYSHEV_POWER_STEPS power
+    // iterations the first time it is needed, which all ranks have to call.
+    //
+    void setSpectralRadius(double rho);
+    double spectralRadius();
+
+    const ProcessGrid & grid() const;
+    const DistributedMatrix & matrix() const;
+    const Matrix & localMatrix() const;
+    const Vector & localInverseDiagonal() const;
+
+private:
+    DistributedMatrix A_;
+
+    // b and D^-1 of the rows owned by this rank
+    Vector b_own_;
+    Vector D_inv_own_;
+
+    // The newest and the next values of x(own)
+    Vector x_own_;
+    Vector x_next_;
+
+    // The products of the rows owned by this rank
+    Vector sums_own_;
+
+    Metric metric_ = RESIDUAL;
+    bool pipelined_ = false;
+    bool chebyshev_ = false;
+    double rho_ = -1.0;
+
+    void setUp();
+
+    // Compute x_next from sums_own with the weight omega of the Chebyshev
+    // semi-iteration, which is 1 without it. Otherwise, x_next holds the
+    // previous x(own). The local part of the convergence metric is returned.
+    //
+    double update(double omega);
+
+    // One blocking iteration. The global metric is returned.
+    double sweep(double omega);
+
+    double solvePipelined(std::size_t max_it, double small_resid, int verbose,
+            ChebyshevWeights & weights, bool accelerate);
+};
+
+#endif /* DISTRIBUTEDJACOBI_H */
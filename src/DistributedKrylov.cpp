@@ -0,0 +1,73 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedKrylov.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 4:30 PM
+ */
+
+#include "DistributedKrylov.h"
+
+#include <stdexcept>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+DistributedKrylov::DistributedKrylov(const DistributedMatrix & A,
+        Method method, size_t restart) : Krylov(A, method, restart), A_(A) {
+}
+
+DistributedKrylov::~DistributedKrylov() {
+}
+
+double
+DistributedKrylov::solve(const Vector & b_own, Vector & x_own, size_t max_it,
+        double small_resid, int verbose) const {
+    return (Krylov::solve(b_own, x_own, max_it, small_resid,
+            A_.grid().rank() == 0 ? verbose : 0));
+}
+
+double
+DistributedKrylov::solve(const Vector & b_own, Vector & x_own, size_t max_it,
+        const Convergence & criterion, int verbose) const {
+    return (Krylov::solve(b_own, x_own, max_it, criterion,
+            A_.grid().rank() == 0 ? verbose : 0));
+}
+
+void
+DistributedKrylov::reduce(double * values, size_t count) const {
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, A_.grid().comm());
+}
+
+void
+DistributedKrylov::reduceMax(double * values, size_t count) const {
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_MAX, A_.grid().comm());
+}
+
+unique_ptr<Preconditioner>
+makeDistributedPreconditioner(const string & name,
+        const DistributedMatrix & A, size_t block_size) {
+
+    unique_ptr<Preconditioner> M;
+    string message;
+
+    try {
+        M = makePreconditioner(name, A.diagonalBlock(), block_size);
+    } catch (const exception & e) {
+        message = e.what();
+    }
+
+    // The rank with the smallest number reports its error
+    int rank = A.grid().rank(), nranks = 0, failed = 0;
+    MPI_Comm_size(A.grid().comm(), &nranks);
+
+    int mine = (message.empty() ? nranks : rank);
+    MPI_Allreduce(&mine, &failed, 1, MPI_INT, MPI_MIN, A.grid().comm());
+
+    if (failed < nranks) {
+        if (rank == failed) throw runtime_error(message);
+        throw runtime_error("Error: The preconditioner fails on rank " + to_string(failed) + ".");
+    }
+
+    return (M);
+}
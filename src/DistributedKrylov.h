@@ -0,0 +1,60 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedKrylov.h
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 4:30 PM
+ */
+
+#ifndef DISTRIBUTEDKRYLOV_H
+#define DISTRIBUTEDKRYLOV_H
+
+#include "Krylov.h"
+#include "DistributedMatrix.h"
+#include "Preconditioner.h"
+
+#include <string>
+#include <memory>
+#include <mpi.h>
+
+// Krylov subspace methods distributed over a process grid
+//
+// The vectors are the parts x(own) owned by the ranks, and the products
+// with A are those of DistributedMatrix. The inner products and norms of
+// an iteration are added up over all ranks with one MPI_Allreduce, so a
+// CG iteration needs two reductions and a BiCGSTAB iteration three. The
+// small systems of GMRES are solved redundantly on every rank.
+//
+class DistributedKrylov : public Krylov {
+public:
+    DistributedKrylov(const DistributedMatrix & A, Method method,
+            std::size_t restart = KRYLOV_RESTART);
+    virtual ~DistributedKrylov();
+
+    // Solve with the parts b(own) and x(own), which can be scattered and
+    // gathered with DistributedMatrix. The iterations are only printed on
+    // rank 0 of the grid.
+    //
+    double solve(const Vector & b_own, Vector & x_own, std::size_t max_it,
+            double small_resid, int verbose = 0) const;
+    double solve(const Vector & b_own, Vector & x_own, std::size_t max_it,
+            const Convergence & criterion, int verbose = 0) const;
+
+protected:
+    void reduce(double * values, std::size_t count) const override;
+    void reduceMax(double * values, std::size_t count) const override;
+
+private:
+    const DistributedMatrix & A_;
+};
+
+// Create a preconditioner by its name as makePreconditioner() on the
+// diagonal block A(own, own) of every rank, so that applying it needs no
+// communication. With a block_size of 0, block-Jacobi has one block per
+// rank. When the setup fails on any rank, all ranks throw together.
+//
+std::unique_ptr<Preconditioner> makeDistributedPreconditioner(
+        const std::string & name, const DistributedMatrix & A,
+        std::size_t block_size = 0);
+
+#endif /* DISTRIBUTEDKRYLOV_H */
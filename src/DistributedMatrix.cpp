@@ -0,0 +1,524 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedMatrix.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 9:10 AM
+ */
+
+#include "DistributedMatrix.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <memory>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+RowPartition::RowPartition() {
+}
+
+RowPartition::RowPartition(size_t nrows, MPI_Comm comm) :
+comm_(comm), nrows_(nrows) {
+    int nranks = 0;
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &nranks);
+
+    counts_.resize(nranks);
+    displs_.resize(nranks);
+
+    size_t base = nrows / nranks, extra = nrows % nranks;
+    for (int i = 0, displ = 0; i < nranks; i++) {
+        counts_[i] = base + (i < (int) extra ? 1 : 0);
+        displs_[i] = displ;
+        displ += counts_[i];
+    }
+}
+
+RowPartition::~RowPartition() {
+}
+
+MPI_Comm
+RowPartition::comm() const {
+    return (comm_);
+}
+
+int
+RowPartition::rank() const {
+    return (rank_);
+}
+
+int
+RowPartition::nranks() const {
+    return (counts_.size());
+}
+
+size_t
+RowPartition::nrows() const {
+    return (nrows_);
+}
+
+size_t
+RowPartition::begin() const {
+    return (displs_[rank_]);
+}
+
+size_t
+RowPartition::end() const {
+    return (displs_[rank_] + counts_[rank_]);
+}
+
+size_t
+RowPartition::size() const {
+    return (counts_[rank_]);
+}
+
+const vector<int> &
+RowPartition::counts() const {
+    return (counts_);
+}
+
+const vector<int> &
+RowPartition::displs() const {
+    return (displs_);
+}
+
+// Free a communicator unless MPI has already been finalized
+static void
+freeComm(MPI_Comm * comm) {
+    if (*comm != MPI_COMM_NULL) {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (!finalized) MPI_Comm_free(comm);
+    }
+    delete comm;
+}
+
+ProcessGrid::ProcessGrid() {
+}
+
+ProcessGrid::ProcessGrid(size_t n, int nprows, int npcols, MPI_Comm comm) :
+comm_(comm) {
+    int nranks = 0;
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &nranks);
+
+    if (nprows < 0 || npcols < 0 ||
+            (nprows > 0 && nranks % nprows != 0) ||
+            (npcols > 0 && nranks % npcols != 0) ||
+            (nprows > 0 && npcols > 0 && nprows * npcols != nranks)) {
+        ostringstream message;
+        message << "Error: A " << nprows << " x " << npcols
+                << " process grid does not match " << nranks << " processes.";
+        throw runtime_error(message.str());
+    }
+
+    int dims[2] = {nprows, npcols};
+    MPI_Dims_create(nranks, 2, dims);
+    nprows_ = dims[0];
+    npcols_ = dims[1];
+
+    // Ranks are placed on the grid row by row
+    int grid_row = rank_ / npcols_, grid_col = rank_ % npcols_;
+
+    row_comm_ = shared_ptr<MPI_Comm>(new MPI_Comm(MPI_COMM_NULL), freeComm);
+    col_comm_ = shared_ptr<MPI_Comm>(new MPI_Comm(MPI_COMM_NULL), freeComm);
+    MPI_Comm_split(comm_, grid_row, grid_col, row_comm_.get());
+    MPI_Comm_split(comm_, grid_col, grid_row, col_comm_.get());
+
+    rows_ = RowPartition(n, *col_comm_);
+    cols_ = RowPartition(n, *row_comm_);
+}
+
+ProcessGrid::~ProcessGrid() {
+}
+
+MPI_Comm
+ProcessGrid::comm() const {
+    return (comm_);
+}
+
+MPI_Comm
+ProcessGrid::rowComm() const {
+    return (*row_comm_);
+}
+
+MPI_Comm
+ProcessGrid::colComm() const {
+    return (*col_comm_);
+}
+
+int
+ProcessGrid::rank() const {
+    return (rank_);
+}
+
+int
+ProcessGrid::nprows() const {
+    return (nprows_);
+}
+
+int
+ProcessGrid::npcols() const {
+    return (npcols_);
+}
+
+const RowPartition &
+ProcessGrid::rows() const {
+    return (rows_);
+}
+
+const RowPartition &
+ProcessGrid::cols() const {
+    return (cols_);
+}
+
+size_t
+ProcessGrid::ownBegin() const {
+    return (max(rows_.begin(), cols_.begin()));
+}
+
+size_t
+ProcessGrid::ownEnd() const {
+    return (max(ownBegin(), min(rows_.end(), cols_.end())));
+}
+
+size_t
+ProcessGrid::ownSize() const {
+    return (ownEnd() - ownBegin());
+}
+
+DistributedMatrix::DistributedMatrix() {
+}
+
+DistributedMatrix::DistributedMatrix(const Matrix & A, MPI_Comm comm,
+        int root, int nprows, int npcols) {
+
+    int rank = -1, nranks = 0;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nranks);
+
+    // The shape is broadcast so that all ranks throw together
+    unsigned long long dims[2] = {A.nrows(), A.ncols()};
+    MPI_Bcast(dims, 2, MPI_UNSIGNED_LONG_LONG, root, comm);
+
+    if (dims[0] != dims[1]) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    grid_ = ProcessGrid(dims[0], nprows, npcols, comm);
+    const RowPartition & rows = grid_.rows(), & cols = grid_.cols();
+    A_block_.resize(rows.size(), cols.size());
+
+    if (rank == root) {
+
+        // Pack and send the block of every rank. The rank in grid row r and
+        // grid column c is r * npcols + c.
+        //
+        Matrix block;
+        for (int dest = 0; dest < nranks; dest++) {
+            int r = dest / grid_.npcols(), c = dest % grid_.npcols();
+            size_t r0 = rows.displs()[r], c0 = cols.displs()[c];
+
+            block.resize(rows.counts()[r], cols.counts()[c]);
+            for (size_t i = 0; i < block.nrows(); i++) {
+                copy(A[r0 + i] + c0, A[r0 + i] + c0 + block.ncols(), block[i]);
+            }
+
+            if (dest == rank) {
+                A_block_ = block;
+            } else {
+                MPI_Send(block.data(), block.nrows() * block.ncols(), MPI_DOUBLE,
+                        dest, 0, comm);
+            }
+        }
+
+    } else {
+        MPI_Recv(A_block_.data(), A_block_.nrows() * A_block_.ncols(), MPI_DOUBLE,
+                root, 0, comm, MPI_STATUS_IGNORE);
+    }
+
+    setUp();
+}
+
+DistributedMatrix::DistributedMatrix(const ProcessGrid & grid, const Matrix & A_block) :
+grid_(grid) {
+
+    if (A_block.nrows() != grid_.rows().size() || A_block.ncols() != grid_.cols().size()) {
+        throw runtime_error("Local blocks do not match the process grid.");
+    }
+
+    // The rows are copied by the threads that multiply them later, so
+    // that their pages are placed on the NUMA node of these threads
+    //
+    A_block_.resize(A_block.nrows(), A_block.ncols());
+    long nrows = A_block.nrows();
+    size_t ncols = A_block.ncols();
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows * ncols);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) shared(A_block, nrows, ncols)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        copy(A_block[i], A_block[i] + ncols, A_block_[i]);
+    }
+
+    setUp();
+}
+
+DistributedMatrix::DistributedMatrix(const ProcessGrid & grid,
+        const FunctionOperator::EntryFunction & entry) :
+grid_(grid) {
+
+    if (!entry) {
+        throw runtime_error("Error: The entry function is empty.");
+    }
+
+    // As above, the rows are computed by the threads that multiply them
+    const RowPartition & rows = grid_.rows(), & cols = grid_.cols();
+    A_block_.resize(rows.size(), cols.size());
+    long nrows = rows.size();
+    size_t ncols = cols.size(), r0 = rows.begin(), c0 = cols.begin();
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows * ncols);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(entry, nrows, ncols, r0, c0)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        for (size_t j = 0; j < ncols; j++) A_block_[i][j] = entry(r0 + i, c0 + j);
+    }
+
+    setUp();
+}
+
+DistributedMatrix::~DistributedMatrix() {
+}
+
+void
+DistributedMatrix::setUp() {
+    const RowPartition & rows = grid_.rows(), & cols = grid_.cols();
+
+    x_cols_.resize(cols.size());
+    sums_.resize(rows.size());
+
+    // The rows of the grid row are split by the owners along the grid row
+    reduce_counts_.resize(grid_.npcols());
+    for (int c = 0; c < grid_.npcols(); c++) {
+        size_t begin = max(rows.begin(), (size_t) cols.displs()[c]);
+        size_t end = min(rows.end(), (size_t) cols.displs()[c] + cols.counts()[c]);
+        reduce_counts_[c] = (end > begin ? end - begin : 0);
+    }
+
+    // The columns of the grid column are assembled from the owners along
+    // the grid column
+    //
+    gather_counts_.resize(grid_.nprows());
+    gather_displs_.resize(grid_.nprows());
+    for (int r = 0; r < grid_.nprows(); r++) {
+        size_t begin = max(cols.begin(), (size_t) rows.displs()[r]);
+        size_t end = min(cols.end(), (size_t) rows.displs()[r] + rows.counts()[r]);
+        gather_counts_[r] = (end > begin ? end - begin : 0);
+        gather_displs_[r] = begin - cols.begin();
+    }
+
+    int own[2] = {(int) grid_.ownSize(), (int) grid_.ownBegin()}, nranks = 0;
+    MPI_Comm_size(grid_.comm(), &nranks);
+    vector<int> owns(2 * nranks);
+    MPI_Allgather(own, 2, MPI_INT, owns.data(), 2, MPI_INT, grid_.comm());
+
+    own_counts_.resize(nranks);
+    own_displs_.resize(nranks);
+    for (int i = 0; i < nranks; i++) {
+        own_counts_[i] = owns[2 * i];
+        own_displs_[i] = owns[2 * i + 1];
+    }
+}
+
+const ProcessGrid &
+DistributedMatrix::grid() const {
+    return (grid_);
+}
+
+const Matrix &
+DistributedMatrix::localMatrix() const {
+    return (A_block_);
+}
+
+Matrix
+DistributedMatrix::diagonalBlock() const {
+    size_t own_size = grid_.ownSize();
+    size_t r0 = grid_.ownBegin() - grid_.rows().begin();
+    size_t c0 = grid_.ownBegin() - grid_.cols().begin();
+
+    Matrix block(own_size, own_size);
+    for (size_t i = 0; i < own_size; i++) {
+        copy(A_block_[r0 + i] + c0, A_block_[r0 + i] + c0 + own_size, block[i]);
+    }
+
+    return (block);
+}
+
+size_t
+DistributedMatrix::nrows() const {
+    return (grid_.ownSize());
+}
+
+size_t
+DistributedMatrix::ncols() const {
+    return (grid_.ownSize());
+}
+
+void
+DistributedMatrix::multiply(const Vector & x_own, Vector & y_own) const {
+
+    if (x_own.size() != grid_.ownSize()) {
+        throw runtime_error("Matrix and vector do not have correct shapes.");
+    }
+
+    gatherColumns(x_own);
+
+    size_t ncols = A_block_.ncols();
+    if (grid_.ownSize() == 0) {
+        accumulate(0, ncols, x_cols_.data());
+    } else {
+
+        // The columns of the diagonal block come first as in the pipelined
+        // Jacobi iterations
+        //
+        size_t c0 = grid_.ownBegin() - grid_.cols().begin(), c1 = c0 + grid_.ownSize();
+        accumulate(c0, c1, x_cols_.data() + c0);
+        accumulate(0, c0, x_cols_.data());
+        accumulate(c1, ncols, x_cols_.data() + c1);
+    }
+
+    reduceSums(y_own);
+}
+
+double
+DistributedMatrix::rowProduct(size_t, const double *) const {
+    throw runtime_error("Error: Rows of a distributed matrix are split over the process grid.");
+}
+
+double
+DistributedMatrix::diagonal(size_t i) const {
+    size_t row = grid_.ownBegin() + i;
+    return (A_block_[row - grid_.rows().begin()][row - grid_.cols().begin()]);
+}
+
+bool
+DistributedMatrix::checkDominant() const {
+    const RowPartition & rows = grid_.rows(), & cols = grid_.cols();
+
+    // Add up |a_ij| of the off-diagonal values of every row along the grid
+    // row, and check the rows owned by this rank
+    //
+    Vector off(rows.size()), off_own(grid_.ownSize());
+    for (size_t i = 0; i < A_block_.nrows(); i++) {
+        size_t row = rows.begin() + i;
+        for (size_t j = 0; j < A_block_.ncols(); j++) {
+            if (cols.begin() + j != row) off[i] += abs(A_block_[i][j]);
+        }
+    }
+
+    if (grid_.npcols() == 1) {
+        off_own.swap(off);
+    } else {
+        MPI_Reduce_scatter(off.data(), off_own.data(), reduce_counts_.data(),
+                MPI_DOUBLE, MPI_SUM, grid_.rowComm());
+    }
+
+    int dominant = 1, all_dominant = 0;
+    for (size_t k = 0; k < off_own.size(); k++) {
+        if (abs(diagonal(k)) < off_own[k]) {
+            dominant = 0;
+            break;
+        }
+    }
+
+    MPI_Allreduce(&dominant, &all_dominant, 1, MPI_INT, MPI_MIN, grid_.comm());
+    return (all_dominant == 1);
+}
+
+void
+DistributedMatrix::print(ostream & os) const {
+    os << "Block of rows [" << grid_.rows().begin() << ", " << grid_.rows().end()
+            << ") and columns [" << grid_.cols().begin() << ", " << grid_.cols().end()
+            << ")" << endl << A_block_;
+}
+
+void
+DistributedMatrix::scatter(const Vector & x, Vector & x_own, int root) const {
+    x_own.resize(grid_.ownSize());
+    MPI_Scatterv(x.data(), own_counts_.data(), own_displs_.data(), MPI_DOUBLE,
+            x_own.data(), x_own.size(), MPI_DOUBLE, root, grid_.comm());
+}
+
+void
+DistributedMatrix::allgather(const Vector & x_own, Vector & x) const {
+    x.resize(grid_.rows().nrows());
+    MPI_Allgatherv(x_own.data(), x_own.size(), MPI_DOUBLE, x.data(),
+            own_counts_.data(), own_displs_.data(), MPI_DOUBLE, grid_.comm());
+}
+
+const Vector &
+DistributedMatrix::columns() const {
+    return (x_cols_);
+}
+
+void
+DistributedMatrix::gatherColumns(const Vector & x_own) const {
+    MPI_Allgatherv(x_own.data(), x_own.size(), MPI_DOUBLE, x_cols_.data(),
+            gather_counts_.data(), gather_displs_.data(), MPI_DOUBLE, grid_.colComm());
+}
+
+void
+DistributedMatrix::igatherColumns(const Vector & x_own, MPI_Request * request) const {
+    MPI_Iallgatherv(x_own.data(), x_own.size(), MPI_DOUBLE, x_cols_.data(),
+            gather_counts_.data(), gather_displs_.data(),
+            MPI_DOUBLE, grid_.colComm(), request);
+}
+
+void
+DistributedMatrix::accumulate(size_t c0, size_t c1, const double *px) const {
+    long nrows = A_block_.nrows();
+    size_t len = c1 - c0;
+
+    // The rows are split among the threads in the same way as they are
+    // first touched
+    //
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(A_block_.nrows() * A_block_.ncols());
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) shared(nrows, len, c0, px)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        const double *a = A_block_[i] + c0;
+        double sum = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+        for (size_t j = 0; j < len; j++) {
+            sum += a[j] * px[j];
+        }
+
+        sums_[i] += sum;
+    }
+}
+
+void
+DistributedMatrix::reduceSums(Vector & y_own) const {
+    y_own.resize(grid_.ownSize());
+
+    if (grid_.npcols() == 1) {
+        y_own.swap(sums_);
+    } else {
+        MPI_Reduce_scatter(sums_.data(), y_own.data(), reduce_counts_.data(),
+                MPI_DOUBLE, MPI_SUM, grid_.rowComm());
+    }
+
+    sums_.fill(0.0);
+}
@@ -0,0 +1,218 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   DistributedMatrix.h
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 9:10 AM
+ */
+
+#ifndef DISTRIBUTEDMATRIX_H
+#define DISTRIBUTEDMATRIX_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+#include "FunctionOperator.h"
+
+#include <vector>
+#include <memory>
+#include <mpi.h>
+
+// Partition of rows into contiguous blocks, one block per rank. The first
+// (nrows % nranks) ranks own one more row than the others.
+//
+class RowPartition {
+public:
+    RowPartition();
+    RowPartition(std::size_t nrows, MPI_Comm comm);
+    virtual ~RowPartition();
+
+    MPI_Comm comm() const;
+    int rank() const;
+    int nranks() const;
+
+    // The total number of rows
+    std::size_t nrows() const;
+
+    // Rows [begin(), end()) are owned by this rank
+    std::size_t begin() const;
+    std::size_t end() const;
+    std::size_t size() const;
+
+    // The number of rows and the first row of every rank, in the form
+    // expected by MPI_Scatterv and MPI_Allgatherv
+    //
+    const std::vector<int> & counts() const;
+    const std::vector<int> & displs() const;
+
+private:
+    MPI_Comm comm_ = MPI_COMM_NULL;
+    int rank_ = 0;
+    std::size_t nrows_ = 0;
+    std::vector<int> counts_;
+    std::vector<int> displs_;
+};
+
+// Decomposition of an N x N matrix over a grid of nprows x npcols ranks
+//
+// The rank in grid row r and grid column c owns the block
+// A(rows(r), cols(c)), where rows and columns are both split into
+// contiguous blocks. The ranks in the same grid row share rowComm(), and
+// the ranks in the same grid column share colComm().
+//
+// Each rank also owns the part of the solution x(rows(r) ∩ cols(c)).
+// These parts do not overlap and together they cover all of x. With one
+// grid column, this is the row decomposition.
+//
+class ProcessGrid {
+public:
+    ProcessGrid();
+
+    // nprows * npcols has to be the number of ranks in comm. A dimension
+    // that is 0 is chosen with MPI_Dims_create, so (0, 1) is the row
+    // decomposition and (0, 0) is a grid that is as square as possible.
+    //
+    ProcessGrid(std::size_t n, int nprows, int npcols, MPI_Comm comm = MPI_COMM_WORLD);
+    virtual ~ProcessGrid();
+
+    MPI_Comm comm() const;
+    MPI_Comm rowComm() const;
+    MPI_Comm colComm() const;
+
+    int rank() const;
+    int nprows() const;
+    int npcols() const;
+
+    // The partition of the rows over a grid column, and the partition of
+    // the columns over a grid row
+    //
+    const RowPartition & rows() const;
+    const RowPartition & cols() const;
+
+    // The part of the solution [ownBegin(), ownEnd()) owned by this rank
+    std::size_t ownBegin() const;
+    std::size_t ownEnd() const;
+    std::size_t ownSize() const;
+
+private:
+    MPI_Comm comm_ = MPI_COMM_NULL;
+    int rank_ = 0;
+    int nprows_ = 0;
+    int npcols_ = 0;
+
+    // The communicators are freed when the last copy of the grid is gone
+    std::shared_ptr<MPI_Comm> row_comm_;
+    std::shared_ptr<MPI_Comm> col_comm_;
+
+    RowPartition rows_;
+    RowPartition cols_;
+};
+
+// Square matrix distributed over a process grid
+//
+// Each rank owns the block A(rows(r), cols(c)) of ProcessGrid. As a
+// LinearOperator, the matrix acts on the parts of the vectors owned by the
+// ranks, x(own), so nrows() and ncols() are both grid().ownSize() and
+// multiply() is collective over the grid. rowProduct() is not available
+// because a row is split over the grid row.
+//
+// multiply() assembles x(cols(c)) along the grid column with one
+// MPI_Allgatherv, computes the partial products of the local block, and
+// adds them up along the grid row with one MPI_Reduce_scatter so that every
+// rank receives (A * x)(own). With one grid column, there is nothing to
+// reduce. The steps are also public so that solvers can overlap them with
+// their own work.
+//
+class DistributedMatrix : public LinearOperator {
+public:
+    DistributedMatrix();
+
+    // Send the blocks of A from the root rank. A is only read on root. The
+    // grid is nprows x npcols as in ProcessGrid. The default is the row
+    // decomposition.
+    //
+    DistributedMatrix(const Matrix & A, MPI_Comm comm = MPI_COMM_WORLD,
+            int root = 0, int nprows = 0, int npcols = 1);
+
+    // Use the block that is already distributed, for example read with
+    // hyperslabs. A_block is A(rows(r), cols(c)).
+    //
+    DistributedMatrix(const ProcessGrid & grid, const Matrix & A_block);
+
+    // Compute the block A(rows(r), cols(c)) of every rank from the entries
+    // a_ij, so that A is never stored or sent as a whole. entry is called
+    // by the threads of the rank at the same time.
+    //
+    DistributedMatrix(const ProcessGrid & grid,
+            const FunctionOperator::EntryFunction & entry);
+
+    virtual ~DistributedMatrix();
+
+    const ProcessGrid & grid() const;
+    const Matrix & localMatrix() const;
+
+    // The diagonal block A(own, own) of the part owned by this rank
+    Matrix diagonalBlock() const;
+
+    std::size_t nrows() const override;
+    std::size_t ncols() const override;
+
+    // y(own) = (A * x)(own)
+    void multiply(const Vector & x_own, Vector & y_own) const override;
+
+    // Throws because the rows are split over the grid row
+    double rowProduct(std::size_t i, const double * x) const override;
+
+    // The value a_ii of the i-th row of the part owned by this rank
+    double diagonal(std::size_t i) const override;
+
+    // Collective over the grid. All ranks return the same value.
+    bool checkDominant() const override;
+
+    // Print the local block
+    void print(std::ostream &) const override;
+
+    // The part x(own) of x on the root rank, and all of x from the parts
+    // x(own) of all ranks
+    //
+    void scatter(const Vector & x, Vector & x_own, int root = 0) const;
+    void allgather(const Vector & x_own, Vector & x) const;
+
+    // The steps of multiply()
+    //
+    // columns() is x(cols(c)), which is assembled by gatherColumns() or
+    // igatherColumns() and is the input of the local product.
+    // accumulate(c0, c1, px) adds A_block(:, [c0, c1)) * x([c0, c1)) to
+    // the partial products, where the columns are relative to the block and
+    // px points to the value of column c0. reduceSums() adds up the partial
+    // products along the grid row into y(own) and clears them.
+    //
+    const Vector & columns() const;
+    void gatherColumns(const Vector & x_own) const;
+    void igatherColumns(const Vector & x_own, MPI_Request * request) const;
+    void accumulate(std::size_t c0, std::size_t c1, const double * px) const;
+    void reduceSums(Vector & y_own) const;
+
+private:
+    ProcessGrid grid_;
+    Matrix A_block_;
+
+    // The work space of the products
+    mutable Vector x_cols_;
+    mutable Vector sums_;
+
+    // Counts and displacements of the reduction along the grid row, and
+    // the gather along the grid column
+    //
+    std::vector<int> reduce_counts_;
+    std::vector<int> gather_counts_;
+    std::vector<int> gather_displs_;
+
+    // Counts and displacements of x(own) of all ranks
+    std::vector<int> own_counts_;
+    std::vector<int> own_displs_;
+
+    void setUp();
+};
+
+#endif /* DISTRIBUTEDMATRIX_H */
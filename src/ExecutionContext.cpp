@@ -0,0 +1,63 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   ExecutionContext.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 25, 2026, 3:30 PM
+ */
+
+#include "ExecutionContext.h"
+
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+static ExecutionContext _current_context;
+
+ExecutionContext::ExecutionContext(int nthreads, size_t min_work) :
+nthreads_(nthreads), min_work_(min_work) {
+    if (nthreads_ < 0) {
+        throw runtime_error("Error: The number of threads can't be negative.");
+    }
+}
+
+ExecutionContext::~ExecutionContext() {
+}
+
+int
+ExecutionContext::nthreads() const {
+#if defined(_OPENMP)
+    return (nthreads_ == 0 ? omp_get_max_threads() : nthreads_);
+#else
+    return (1);
+#endif
+}
+
+size_t
+ExecutionContext::minWork() const {
+    return (min_work_);
+}
+
+int
+ExecutionContext::threads(size_t work) const {
+#if defined(_OPENMP)
+    if (omp_in_parallel() || work < min_work_) return (1);
+#else
+    (void) work;
+#endif
+    return (nthreads());
+}
+
+const ExecutionContext &
+ExecutionContext::current() {
+    return (_current_context);
+}
+
+void
+ExecutionContext::setCurrent(const ExecutionContext & context) {
+    _current_context = context;
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   ExecutionContext.h
+ * Author: Weiming Hu
+ *
+ * Created on October 25, 2026, 3:30 PM
+ */
+
+#ifndef EXECUTIONCONTEXT_H
+#define EXECUTIONCONTEXT_H
+
+#include <cstddef>
+
+// Operations below which a dense kernel runs on one thread, where the
+// threads would cost more than they save
+//
+#ifndef EXECUTION_MIN_WORK
+#define EXECUTION_MIN_WORK 65536
+#endif
+
+// The threading policy of the dense kernels
+//
+// The kernels of Matrix and Gemm.h, i.e. the element-wise operators, the
+// products, and the first touch of new storage in Matrix::resize(), open
+// their own parallel regions over tiles of rows with the number of threads
+// of threads(). A kernel that is called within a parallel region runs on
+// the calling thread only, so it is never split between the threads of
+// the caller.
+//
+// The first touch places the pages of a matrix on the NUMA nodes of the
+// threads that zero them. With the same context and static schedules, the
+// kernels later work on the rows from the same threads.
+//
+class ExecutionContext {
+public:
+
+    // nthreads 0 is the number of threads of OpenMP, e.g. OMP_NUM_THREADS
+    ExecutionContext(int nthreads = 0, std::size_t min_work = EXECUTION_MIN_WORK);
+    virtual ~ExecutionContext();
+
+    // The number of threads of the kernels, which is 1 without OpenMP
+    int nthreads() const;
+    std::size_t minWork() const;
+
+    // The number of threads for a kernel of the given operations
+    int threads(std::size_t work) const;
+
+    // The context that the kernels use. It should only be changed outside
+    // of the kernels, e.g. when a program starts.
+    //
+    static const ExecutionContext & current();
+    static void setCurrent(const ExecutionContext & context);
+
+private:
+    int nthreads_;
+    std::size_t min_work_;
+};
+
+#endif /* EXECUTIONCONTEXT_H */
@@ -0,0 +1,710 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Factorization.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 17, 2026, 9:15 AM
+ */
+
+#include "Factorization.h"
+#include "Gemm.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+// Solve LX = B in place where L is the lower triangle of the matrix. The
+// diagonal is treated as 1 when unit is true.
+//
+static void
+forwardSubstitution(const Matrix & L, bool unit, double *B, size_t nrhs, size_t ldb) {
+    size_t n = L.nrows();
+
+    for (size_t i = 0; i < n; i++) {
+        const double *li = L[i];
+        double *bi = B + i * ldb;
+
+        if (nrhs == 1 && ldb == 1) {
+            double sum = 0.0;
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+            for (size_t j = 0; j < i; j++) sum += li[j] * B[j];
+            bi[0] -= sum;
+        } else {
+            for (size_t j = 0; j < i; j++) {
+                double l = li[j];
+                if (l == 0.0) continue;
+                const double *bj = B + j * ldb;
+                for (size_t c = 0; c < nrhs; c++) bi[c] -= l * bj[c];
+            }
+        }
+
+        if (!unit) {
+            for (size_t c = 0; c < nrhs; c++) bi[c] /= li[i];
+        }
+    }
+}
+
+// Solve UX = B in place where U is the upper triangle of the leading
+// square block of the matrix
+//
+static void
+backwardSubstitution(const Matrix & U, double *B, size_t nrhs, size_t ldb) {
+    size_t n = U.ncols();
+
+    for (size_t i = n; i-- > 0;) {
+        const double *ui = U[i];
+        double *bi = B + i * ldb;
+
+        if (nrhs == 1 && ldb == 1) {
+            double sum = 0.0;
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+            for (size_t j = i + 1; j < n; j++) sum += ui[j] * B[j];
+            bi[0] -= sum;
+        } else {
+            for (size_t j = i + 1; j < n; j++) {
+                double u = ui[j];
+                if (u == 0.0) continue;
+                const double *bj = B + j * ldb;
+                for (size_t c = 0; c < nrhs; c++) bi[c] -= u * bj[c];
+            }
+        }
+
+        for (size_t c = 0; c < nrhs; c++) bi[c] /= ui[i];
+    }
+}
+
+// Solve L^T X = B in place where L is the lower triangle of the matrix.
+// The rows of L are accessed contiguously.
+//
+static void
+transposedBackwardSubstitution(const Matrix & L, double *B, size_t nrhs, size_t ldb) {
+    size_t n = L.nrows();
+
+    for (size_t i = n; i-- > 0;) {
+        const double *li = L[i];
+        double *bi = B + i * ldb;
+
+        for (size_t c = 0; c < nrhs; c++) bi[c] /= li[i];
+
+        for (size_t j = 0; j < i; j++) {
+            double l = li[j];
+            if (l == 0.0) continue;
+            double *bj = B + j * ldb;
+            for (size_t c = 0; c < nrhs; c++) bj[c] -= l * bi[c];
+        }
+    }
+}
+
+// Solve U^T X = B in place where U is the upper triangle of the leading
+// square block of the matrix. The rows of U are accessed contiguously.
+//
+static void
+transposedForwardSubstitution(const Matrix & U, double *B, size_t nrhs, size_t ldb) {
+    size_t n = U.ncols();
+
+    for (size_t i = 0; i < n; i++) {
+        const double *ui = U[i];
+        double *bi = B + i * ldb;
+
+        for (size_t c = 0; c < nrhs; c++) bi[c] /= ui[i];
+
+        for (size_t j = i + 1; j < n; j++) {
+            double u = ui[j];
+            if (u == 0.0) continue;
+            double *bj = B + j * ldb;
+            for (size_t c = 0; c < nrhs; c++) bj[c] -= u * bi[c];
+        }
+    }
+}
+
+// B = (I - tau * v * v^t) B where v is the Householder vector stored below
+// the diagonal in column j of QR
+//
+static void
+applyReflector(const Matrix & QR, size_t j, double tau,
+        double *B, size_t nrhs, size_t ldb) {
+    if (tau == 0.0) return;
+
+    vector<double> w(B + j * ldb, B + j * ldb + nrhs);
+    for (size_t i = j + 1; i < QR.nrows(); i++) {
+        double v = QR[i][j];
+        const double *bi = B + i * ldb;
+        for (size_t c = 0; c < nrhs; c++) w[c] += v * bi[c];
+    }
+
+    for (size_t c = 0; c < nrhs; c++) B[j * ldb + c] -= tau * w[c];
+    for (size_t i = j + 1; i < QR.nrows(); i++) {
+        double v = tau * QR[i][j];
+        double *bi = B + i * ldb;
+        for (size_t c = 0; c < nrhs; c++) bi[c] -= v * w[c];
+    }
+}
+
+// Factorize the panel of columns [k0, k1) of LU with partial pivoting. Rows
+// are swapped only within the panel. The column of the first zero pivot is
+// returned, or the size of the matrix if there is none.
+//
+static size_t
+factorizePanel(Matrix & LU, vector<size_t> & pivots, size_t k0, size_t k1) {
+    size_t n = LU.nrows();
+
+    for (size_t j = k0; j < k1; j++) {
+        size_t p = j;
+        for (size_t i = j + 1; i < n; i++) {
+            if (abs(LU[i][j]) > abs(LU[p][j])) p = i;
+        }
+
+        pivots[j] = p;
+        if (p != j) swap_ranges(LU[j] + k0, LU[j] + k1, LU[p] + k0);
+
+        if (abs(LU[j][j]) < _ZERO_LIMIT) return (j);
+
+        double pivot = LU[j][j];
+        const double *row_j = LU[j];
+        for (size_t i = j + 1; i < n; i++) {
+            double *row = LU[i];
+            double l = (row[j] /= pivot);
+            if (l == 0.0) continue;
+
+            for (size_t c = j + 1; c < k1; c++) row[c] -= l * row_j[c];
+        }
+    }
+
+    return (n);
+}
+
+// Apply the row swaps of the panel [k0, k1) to the columns [c0, c1)
+static void
+swapRows(Matrix & LU, const vector<size_t> & pivots,
+        size_t k0, size_t k1, size_t c0, size_t c1) {
+    for (size_t j = k0; j < k1; j++) {
+        size_t p = pivots[j];
+        if (p != j) swap_ranges(LU[j] + c0, LU[j] + c1, LU[p] + c0);
+    }
+}
+
+// Update the columns [c0, c1) on the right of the panel [k0, k1)
+//
+//  U12 = L11^-1 * A12
+//  A22 = A22 - L21 * U12
+//
+static void
+updateTile(Matrix & LU, const vector<size_t> & pivots,
+        size_t k0, size_t k1, size_t c0, size_t c1) {
+    size_t n = LU.nrows();
+
+    swapRows(LU, pivots, k0, k1, c0, c1);
+
+    for (size_t i = k0 + 1; i < k1; i++) {
+        double *row = LU[i];
+        for (size_t j = k0; j < i; j++) {
+            double l = row[j];
+            if (l == 0.0) continue;
+
+            const double *row_j = LU[j];
+            for (size_t c = c0; c < c1; c++) row[c] -= l * row_j[c];
+        }
+    }
+
+    if (k1 < n) {
+        gemm(n - k1, c1 - c0, k1 - k0, -1.0, LU[k1] + k0, LU.stride(),
+                LU[k0] + c0, LU.stride(), 1.0, LU[k1] + c0, LU.stride());
+    }
+}
+
+LUFactorization::LUFactorization() {
+}
+
+LUFactorization::LUFactorization(const Matrix & A) {
+    factorize(A);
+}
+
+LUFactorization::~LUFactorization() {
+}
+
+void
+LUFactorization::factorize(const Matrix & A) {
+    if (A.nrows() != A.ncols())
+        throw runtime_error("Matrix should be square!");
+
+    size_t n = A.nrows();
+    LU_ = A;
+    pivots_.resize(n);
+
+    // The matrix is split into column tiles of FACTORIZATION_NB. Step k
+    // factorizes the panel of tile k, then updates every tile on its right
+    // and permutes the rows of the tiles on its left. The tasks are
+    // ordered only by the tiles they read and write, so the panel of step
+    // k + 1 starts as soon as its own tile is updated while the rest of
+    // the trailing update of step k is still running.
+    //
+    size_t ntiles = (n + FACTORIZATION_NB - 1) / FACTORIZATION_NB;
+    vector<char> tiles(ntiles);
+
+    // The tiles are only used in the depend clauses, which do not count as
+    // uses for the compiler, and not at all without OpenMP
+    //
+    char *dep = tiles.data();
+    (void) dep;
+
+    // An exception cannot be thrown inside a task. The column of the first
+    // zero pivot is recorded instead, and the remaining tasks are skipped.
+    //
+    size_t singular = n;
+    double singular_value = 0.0;
+
+    Matrix & LU = LU_;
+    vector<size_t> & pivots = pivots_;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(n * n * n);
+#pragma omp parallel num_threads(nthreads) default(none) \
+shared(n, ntiles, dep, singular, singular_value, LU, pivots)
+#pragma omp single
+#endif
+    for (size_t k = 0; k < ntiles; k++) {
+        size_t k0 = k * FACTORIZATION_NB, k1 = min(n, k0 + FACTORIZATION_NB);
+
+#if defined(_OPENMP)
+#pragma omp task default(none) firstprivate(k0, k1) depend(inout: dep[k]) \
+shared(n, singular, singular_value, LU, pivots)
+#endif
+        {
+            size_t failed;
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+            failed = singular;
+
+            if (failed == n) {
+                size_t column = factorizePanel(LU, pivots, k0, k1);
+                if (column != n) {
+                    singular_value = LU[column][column];
+#if defined(_OPENMP)
+#pragma omp atomic write
+#endif
+                    singular = column;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < k; i++) {
+#if defined(_OPENMP)
+#pragma omp task default(none) firstprivate(k0, k1, i) \
+depend(in: dep[k]) depend(inout: dep[i]) shared(n, singular, LU, pivots)
+#endif
+            {
+                size_t failed;
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+                failed = singular;
+
+                size_t c0 = i * FACTORIZATION_NB, c1 = min(n, c0 + FACTORIZATION_NB);
+                if (failed == n) swapRows(LU, pivots, k0, k1, c0, c1);
+            }
+        }
+
+        for (size_t j = k + 1; j < ntiles; j++) {
+#if defined(_OPENMP)
+#pragma omp task default(none) firstprivate(k0, k1, j) \
+depend(in: dep[k]) depend(inout: dep[j]) shared(n, singular, LU, pivots)
+#endif
+            {
+                size_t failed;
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+                failed = singular;
+
+                size_t c0 = j * FACTORIZATION_NB, c1 = min(n, c0 + FACTORIZATION_NB);
+                if (failed == n) updateTile(LU, pivots, k0, k1, c0, c1);
+            }
+        }
+    }
+
+    if (singular != n) {
+        ostringstream message;
+        message << "Error: Matrix is singular. The pivot at column "
+                << singular << " is " << singular_value << ".";
+        throw runtime_error(message.str());
+    }
+}
+
+Vector
+LUFactorization::solve(const Vector & b) const {
+    if (b.size() != size())
+        throw runtime_error("Matrix and vector do not have correct shapes.");
+
+    Vector x(b);
+    solveInPlace(x.data(), 1, 1);
+    return (x);
+}
+
+Matrix
+LUFactorization::solve(const Matrix & B) const {
+    if (B.nrows() != size())
+        throw runtime_error("Matrices do not have the correct shape.");
+
+    Matrix X(B);
+    solveInPlace(X.data(), X.ncols(), X.stride());
+    return (X);
+}
+
+void
+LUFactorization::solveInPlace(double *B, size_t nrhs, size_t ldb) const {
+    size_t n = size();
+
+    // Apply the row permutation
+    for (size_t i = 0; i < n; i++) {
+        if (pivots_[i] != i) {
+            swap_ranges(B + i * ldb, B + i * ldb + nrhs, B + pivots_[i] * ldb);
+        }
+    }
+
+    forwardSubstitution(LU_, true, B, nrhs, ldb);
+    backwardSubstitution(LU_, B, nrhs, ldb);
+}
+
+size_t
+LUFactorization::size() const {
+    return (LU_.nrows());
+}
+
+const Matrix &
+LUFactorization::factors() const {
+    return (LU_);
+}
+
+const vector<size_t> &
+LUFactorization::pivots() const {
+    return (pivots_);
+}
+
+CholeskyFactorization::CholeskyFactorization() {
+}
+
+CholeskyFactorization::CholeskyFactorization(const Matrix & A) {
+    factorize(A);
+}
+
+CholeskyFactorization::~CholeskyFactorization() {
+}
+
+void
+CholeskyFactorization::factorize(const Matrix & A) {
+    if (A.nrows() != A.ncols())
+        throw runtime_error("Matrix should be square!");
+
+    size_t n = A.nrows();
+    L_ = A;
+
+    // Scratch space for the transpose of L21
+    Matrix L21_t;
+
+    for (size_t k0 = 0; k0 < n; k0 += FACTORIZATION_NB) {
+        size_t kend = min(n, k0 + FACTORIZATION_NB);
+
+        // Factorize the diagonal block, and compute L21 = A21 * L11^-T.
+        // Both only need dot products between rows.
+        //
+        for (size_t j = k0; j < kend; j++) {
+            const double *row_j = L_[j];
+
+            double d = row_j[j];
+            for (size_t p = k0; p < j; p++) d -= row_j[p] * row_j[p];
+
+            if (d <= 0.0 || std::isnan(d)) {
+                ostringstream message;
+                message << "Error: Matrix is not positive definite at column " << j << ".";
+                throw runtime_error(message.str());
+            }
+
+            L_[j][j] = sqrt(d);
+
+            for (size_t i = j + 1; i < n; i++) {
+                double *row_i = L_[i];
+                double sum = row_i[j];
+                for (size_t p = k0; p < j; p++) sum -= row_i[p] * row_j[p];
+                row_i[j] = sum / L_[j][j];
+            }
+        }
+
+        if (kend == n) break;
+
+        // A22 = A22 - L21 * L21^T. Only the lower triangle is updated, one
+        // block row at a time.
+        //
+        size_t m = n - kend, kb = kend - k0;
+        L21_t.resize(kb, m);
+        for (size_t i = 0; i < m; i++) {
+            for (size_t p = 0; p < kb; p++) L21_t[p][i] = L_[kend + i][k0 + p];
+        }
+
+        for (size_t r0 = 0; r0 < m; r0 += FACTORIZATION_NB) {
+            size_t rb = min(m - r0, (size_t) FACTORIZATION_NB);
+            gemm(rb, r0 + rb, kb, -1.0, L_[kend + r0] + k0, L_.stride(),
+                    L21_t.data(), L21_t.stride(), 1.0, L_[kend + r0] + kend, L_.stride());
+        }
+    }
+
+    // Clear the strict upper triangle
+    for (size_t i = 0; i < n; i++) {
+        fill(L_[i] + i + 1, L_[i] + n, 0.0);
+    }
+}
+
+Vector
+CholeskyFactorization::solve(const Vector & b) const {
+    if (b.size() != size())
+        throw runtime_error("Matrix and vector do not have correct shapes.");
+
+    Vector x(b);
+    solveInPlace(x.data(), 1, 1);
+    return (x);
+}
+
+Matrix
+CholeskyFactorization::solve(const Matrix & B) const {
+    if (B.nrows() != size())
+        throw runtime_error("Matrices do not have the correct shape.");
+
+    Matrix X(B);
+    solveInPlace(X.data(), X.ncols(), X.stride());
+    return (X);
+}
+
+void
+CholeskyFactorization::solveInPlace(double *B, size_t nrhs, size_t ldb) const {
+    forwardSubstitution(L_, false, B, nrhs, ldb);
+    transposedBackwardSubstitution(L_, B, nrhs, ldb);
+}
+
+size_t
+CholeskyFactorization::size() const {
+    return (L_.nrows());
+}
+
+const Matrix &
+CholeskyFactorization::factors() const {
+    return (L_);
+}
+
+QRFactorization::QRFactorization() {
+}
+
+QRFactorization::QRFactorization(const Matrix & A) {
+    factorize(A);
+}
+
+QRFactorization::~QRFactorization() {
+}
+
+void
+QRFactorization::factorize(const Matrix & A) {
+    transposed_ = A.nrows() < A.ncols();
+    if (transposed_) QR_ = A.transpose();
+    else QR_ = A;
+
+    size_t m = QR_.nrows(), n = QR_.ncols();
+    tau_ = Vector(n, 0.0);
+
+    for (size_t k0 = 0; k0 < n; k0 += FACTORIZATION_NB) {
+        size_t kend = min(n, k0 + FACTORIZATION_NB);
+
+        // Factorize the panel of columns [k0, kend)
+        for (size_t j = k0; j < kend; j++) householder(j, kend);
+
+        if (kend == n) break;
+
+        size_t mp = m - k0, kb = kend - k0, n2 = n - kend;
+
+        // The Householder vectors with a unit diagonal
+        Matrix V(mp, kb);
+        for (size_t r = 0; r < mp; r++) {
+            for (size_t p = 0; p < kb && p <= r; p++) {
+                V[r][p] = (p == r ? 1.0 : QR_[k0 + r][k0 + p]);
+            }
+        }
+        Matrix V_t = V.transpose();
+
+        // The upper triangular T of the compact WY representation
+        //
+        //  T(0:i, i) = -tau_i * T(0:i, 0:i) * V(:, 0:i)^t * v_i
+        //
+        Matrix T(kb, kb);
+        Vector z(kb);
+        for (size_t i = 0; i < kb; i++) {
+            double tau_i = tau_[k0 + i];
+            T[i][i] = tau_i;
+
+            for (size_t p = 0; p < i; p++) {
+                double sum = 0.0;
+                for (size_t r = i; r < mp; r++) sum += V_t[p][r] * V_t[i][r];
+                z[p] = sum;
+            }
+
+            for (size_t p = 0; p < i; p++) {
+                double sum = 0.0;
+                for (size_t q = p; q < i; q++) sum += T[p][q] * z[q];
+                T[p][i] = -tau_i * sum;
+            }
+        }
+
+        // A2 = (I - V T V^t)^t A2 = A2 - V (T^t (V^t A2))
+        Matrix W(kb, n2);
+        double *A2 = QR_[k0] + kend;
+        gemm(kb, n2, mp, 1.0, V_t.data(), V_t.stride(), A2, QR_.stride(),
+                0.0, W.data(), W.stride());
+
+        // W = T^t W. Rows are updated from the bottom so that the rows
+        // still needed are not overwritten.
+        //
+        for (size_t i = kb; i-- > 0;) {
+            double *wi = W[i];
+            for (size_t c = 0; c < n2; c++) wi[c] *= T[i][i];
+            for (size_t p = 0; p < i; p++) {
+                double t = T[p][i];
+                if (t == 0.0) continue;
+                const double *wp = W[p];
+                for (size_t c = 0; c < n2; c++) wi[c] += t * wp[c];
+            }
+        }
+
+        gemm(mp, n2, kb, -1.0, V.data(), V.stride(), W.data(), W.stride(),
+                1.0, A2, QR_.stride());
+    }
+}
+
+void
+QRFactorization::householder(size_t j, size_t end) {
+    size_t m = QR_.nrows();
+
+    // Generate the reflector H = I - tau * v * v^t that zeros the column
+    // below the diagonal. v(0) is 1 and is not stored.
+    //
+    double alpha = QR_[j][j], sigma = 0.0;
+    for (size_t i = j + 1; i < m; i++) sigma += QR_[i][j] * QR_[i][j];
+
+    double beta = alpha, tau = 0.0;
+    if (sigma != 0.0) {
+        beta = -copysign(sqrt(alpha * alpha + sigma), alpha);
+        tau = (beta - alpha) / beta;
+
+        double scale = 1.0 / (alpha - beta);
+        for (size_t i = j + 1; i < m; i++) QR_[i][j] *= scale;
+    }
+
+    if (abs(beta) < _ZERO_LIMIT) {
+        ostringstream message;
+        message << "Error: Matrix is rank deficient at column " << j << ".";
+        throw runtime_error(message.str());
+    }
+
+    QR_[j][j] = beta;
+    tau_[j] = tau;
+    if (tau == 0.0 || j + 1 == end) return;
+
+    // Apply the reflector to the rest of the panel
+    vector<double> w(QR_[j] + j + 1, QR_[j] + end);
+    for (size_t i = j + 1; i < m; i++) {
+        double v = QR_[i][j];
+        const double *row = QR_[i];
+        for (size_t c = j + 1; c < end; c++) w[c - j - 1] += v * row[c];
+    }
+
+    for (size_t c = j + 1; c < end; c++) QR_[j][c] -= tau * w[c - j - 1];
+    for (size_t i = j + 1; i < m; i++) {
+        double v = tau * QR_[i][j];
+        double *row = QR_[i];
+        for (size_t c = j + 1; c < end; c++) row[c] -= v * w[c - j - 1];
+    }
+}
+
+void
+QRFactorization::applyQt(double *B, size_t nrhs, size_t ldb) const {
+    for (size_t j = 0; j < QR_.ncols(); j++) {
+        applyReflector(QR_, j, tau_[j], B, nrhs, ldb);
+    }
+}
+
+void
+QRFactorization::applyQ(double *B, size_t nrhs, size_t ldb) const {
+    for (size_t j = QR_.ncols(); j-- > 0;) {
+        applyReflector(QR_, j, tau_[j], B, nrhs, ldb);
+    }
+}
+
+Vector
+QRFactorization::solve(const Vector & b) const {
+    if (b.size() != nrows())
+        throw runtime_error("Matrix and vector do not have correct shapes.");
+
+    Vector work(QR_.nrows());
+    copy(b.data(), b.data() + b.size(), work.data());
+    solveInPlace(work.data(), 1, 1);
+    work.resize(ncols());
+    return (work);
+}
+
+Matrix
+QRFactorization::solve(const Matrix & B) const {
+    if (B.nrows() != nrows())
+        throw runtime_error("Matrices do not have the correct shape.");
+
+    Matrix work(B);
+    work.resize(QR_.nrows(), B.ncols());
+    solveInPlace(work.data(), work.ncols(), work.stride());
+    work.resize(ncols(), B.ncols());
+    return (work);
+}
+
+void
+QRFactorization::solveInPlace(double *B, size_t nrhs, size_t ldb) const {
+    if (transposed_) {
+
+        // A = R^t Q^t, so x = Q [R^-t b; 0]
+        size_t n = QR_.ncols();
+        for (size_t i = n; i < QR_.nrows(); i++) {
+            fill(B + i * ldb, B + i * ldb + nrhs, 0.0);
+        }
+        transposedForwardSubstitution(QR_, B, nrhs, ldb);
+        applyQ(B, nrhs, ldb);
+
+    } else {
+
+        // x = R^-1 (Q^t b)(0:n)
+        applyQt(B, nrhs, ldb);
+        backwardSubstitution(QR_, B, nrhs, ldb);
+    }
+}
+
+size_t
+QRFactorization::nrows() const {
+    return (transposed_ ? QR_.ncols() : QR_.nrows());
+}
+
+size_t
+QRFactorization::ncols() const {
+    return (transposed_ ? QR_.nrows() : QR_.ncols());
+}
+
+const Matrix &
+QRFactorization::factors() const {
+    return (QR_);
+}
+
+const Vector &
+QRFactorization::tau() const {
+    return (tau_);
+}
@@ -0,0 +1,146 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Factorization.h
+ * Author: Weiming Hu
+ *
+ * Created on October 17, 2026, 9:15 AM
+ */
+
+#ifndef FACTORIZATION_H
+#define FACTORIZATION_H
+
+#include "Matrix.h"
+#include "Vector.h"
+
+#include <vector>
+
+// Block size of the blocked factorizations. The trailing updates are
+// carried out with gemm on blocks of this width.
+//
+#ifndef FACTORIZATION_NB
+#define FACTORIZATION_NB 64
+#endif
+
+// LU factorization with partial pivoting, PA = LU
+//
+// The factorization is computed once with the blocked right-looking
+// algorithm, and each solve afterwards only needs the O(N^2) triangular
+// solves. L has a unit diagonal and both L and U are stored in factors().
+//
+class LUFactorization {
+public:
+    LUFactorization();
+    LUFactorization(const Matrix & A);
+    virtual ~LUFactorization();
+
+    // Factorize a square matrix. An exception is thrown when the matrix
+    // is singular.
+    //
+    void factorize(const Matrix & A);
+
+    // Solve Ax = b or AX = B with the factors
+    Vector solve(const Vector & b) const;
+    Matrix solve(const Matrix & B) const;
+
+    // Solve in place for nrhs right-hand sides stored row by row in B
+    // with the leading dimension ldb
+    //
+    void solveInPlace(double *B, std::size_t nrhs, std::size_t ldb) const;
+
+    std::size_t size() const;
+    const Matrix & factors() const;
+
+    // Row i was swapped with row pivots()[i] at step i
+    const std::vector<std::size_t> & pivots() const;
+
+private:
+    Matrix LU_;
+    std::vector<std::size_t> pivots_;
+};
+
+// Cholesky factorization of a symmetric positive definite matrix, A = LL^T
+//
+// Only the lower triangle of A is used. It is about twice as fast as the
+// LU factorization and needs no pivoting, e.g. for A * A^T.
+//
+class CholeskyFactorization {
+public:
+    CholeskyFactorization();
+    CholeskyFactorization(const Matrix & A);
+    virtual ~CholeskyFactorization();
+
+    // Factorize a symmetric matrix. An exception is thrown when the
+    // matrix is not positive definite.
+    //
+    void factorize(const Matrix & A);
+
+    // Solve Ax = b or AX = B with the factors
+    Vector solve(const Vector & b) const;
+    Matrix solve(const Matrix & B) const;
+
+    // Solve in place for nrhs right-hand sides stored row by row in B
+    // with the leading dimension ldb
+    //
+    void solveInPlace(double *B, std::size_t nrhs, std::size_t ldb) const;
+
+    std::size_t size() const;
+
+    // The lower triangle is L. The strict upper triangle is not used.
+    const Matrix & factors() const;
+
+private:
+    Matrix L_;
+};
+
+// Householder QR factorization for least-squares problems, A = QR
+//
+// Blocks of reflectors are applied to the trailing columns with the compact
+// WY representation, Q = I - V T V^t, so the updates go through gemm. When
+// A has fewer rows than columns, A^t is factorized instead and solve()
+// returns the minimum norm solution. The condition number is not squared
+// as in the normal equation.
+//
+class QRFactorization {
+public:
+    QRFactorization();
+    QRFactorization(const Matrix & A);
+    virtual ~QRFactorization();
+
+    // Factorize a matrix of full rank. An exception is thrown when the
+    // matrix is rank deficient.
+    //
+    void factorize(const Matrix & A);
+
+    // Minimize ||Ax - b|| or ||AX - B|| with the factors
+    Vector solve(const Vector & b) const;
+    Matrix solve(const Matrix & B) const;
+
+    // Solve in place for nrhs right-hand sides stored row by row in B with
+    // the leading dimension ldb. B must have max(nrows(), ncols()) rows.
+    // The right-hand sides are read from the first nrows() rows and the
+    // solutions are written to the first ncols() rows.
+    //
+    void solveInPlace(double *B, std::size_t nrhs, std::size_t ldb) const;
+
+    // Shape of the factorized matrix A
+    std::size_t nrows() const;
+    std::size_t ncols() const;
+
+    // R is in the upper triangle and the Householder vectors are below the
+    // diagonal, with the scaling factors in tau(). These are the factors
+    // of A^t when A has fewer rows than columns.
+    //
+    const Matrix & factors() const;
+    const Vector & tau() const;
+
+private:
+    Matrix QR_;
+    Vector tau_;
+    bool transposed_ = false;
+
+    void householder(std::size_t j, std::size_t end);
+    void applyQt(double *B, std::size_t nrhs, std::size_t ldb) const;
+    void applyQ(double *B, std::size_t nrhs, std::size_t ldb) const;
+};
+
+#endif /* FACTORIZATION_H */
@@ -0,0 +1,149 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   FunctionOperator.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 27, 2026, 2:30 PM
+ */
+
+#include "FunctionOperator.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+FunctionOperator::FunctionOperator() {
+}
+
+FunctionOperator::FunctionOperator(size_t nrows, size_t ncols,
+        const EntryFunction & entry) :
+nrows_(nrows), ncols_(ncols), entry_(entry) {
+    if (!entry_) {
+        throw runtime_error("Error: The entry function is empty.");
+    }
+}
+
+FunctionOperator::FunctionOperator(size_t nrows, size_t ncols,
+        const RowsFunction & rows, const DiagonalFunction & diagonal,
+        bool dominant) :
+nrows_(nrows), ncols_(ncols), rows_(rows), diagonal_(diagonal),
+dominant_(dominant ? 1 : 0) {
+    if (!rows_ || !diagonal_) {
+        throw runtime_error("Error: The row or diagonal function is empty.");
+    }
+}
+
+FunctionOperator::~FunctionOperator() {
+}
+
+size_t
+FunctionOperator::nrows() const {
+    return (nrows_);
+}
+
+size_t
+FunctionOperator::ncols() const {
+    return (ncols_);
+}
+
+void
+FunctionOperator::multiply(const Vector & x, Vector & y) const {
+    if (x.size() != ncols_) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    y.resize(nrows_);
+
+    const double *px = x.data();
+    double *py = y.data();
+
+    // Every thread computes one contiguous block of rows, so that a row
+    // function sees as many rows as possible at once
+    //
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel num_threads(nthreads) default(none) shared(px, py)
+#endif
+    {
+        int tid = 0, team = 1;
+#if defined(_OPENMP)
+        tid = omp_get_thread_num();
+        team = omp_get_num_threads();
+#endif
+        multiplyRows(nrows_ * tid / team, nrows_ * (tid + 1) / team, px, py);
+    }
+}
+
+double
+FunctionOperator::rowProduct(size_t i, const double * x) const {
+    double y = 0.0;
+
+    if (rows_) {
+        rows_(i, i + 1, x, &y);
+    } else {
+        for (size_t j = 0; j < ncols_; j++) y += entry_(i, j) * x[j];
+    }
+
+    return (y);
+}
+
+void
+FunctionOperator::multiplyRows(size_t begin, size_t end,
+        const double * x, double * y) const {
+    if (begin >= end) return;
+
+    if (rows_) {
+        rows_(begin, end, x, y + begin);
+        return;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        double sum = 0.0;
+        for (size_t j = 0; j < ncols_; j++) sum += entry_(i, j) * x[j];
+        y[i] = sum;
+    }
+}
+
+double
+FunctionOperator::diagonal(size_t i) const {
+    return (diagonal_ ? diagonal_(i) : entry_(i, i));
+}
+
+bool
+FunctionOperator::checkDominant() const {
+    if (dominant_ >= 0) return (dominant_ == 1);
+
+    long nrows = nrows_;
+    size_t ncols = ncols_;
+    bool dominant = true;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(nrows, ncols) reduction(&&: dominant)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        double sum = 0.0, diag = 0.0;
+        for (size_t j = 0; j < ncols; j++) {
+            double value = entry_(i, j);
+            sum += abs(value);
+            if ((size_t) i == j) diag = value;
+        }
+        dominant = dominant && !(diag < sum - diag);
+    }
+
+    dominant_ = (dominant ? 1 : 0);
+    return (dominant);
+}
+
+void
+FunctionOperator::print(ostream & os) const {
+    os << "FunctionOperator [" << nrows_ << "][" << ncols_ << "]" << endl << endl;
+}
@@ -0,0 +1,88 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   FunctionOperator.h
+ * Author: Weiming Hu
+ *
+ * Created on October 27, 2026, 2:30 PM
+ */
+
+#ifndef FUNCTIONOPERATOR_H
+#define FUNCTIONOPERATOR_H
+
+#include "Vector.h"
+#include "LinearOperator.h"
+
+#include <iostream>
+#include <functional>
+
+// A matrix-free linear operator that is given by functions
+//
+// A is never stored. Either the entries a_ij are computed on the fly
+// within the products, so the assembly of a row is fused with its product
+// with x, or the products of blocks of rows are computed by a function,
+// e.g. for a stencil, together with the diagonal.
+//
+// The functions are called by the threads of the solvers at the same
+// time, each for its own rows, so they have to be thread-safe. The
+// products use the threads of ExecutionContext::current().
+//
+class FunctionOperator : public LinearOperator {
+public:
+
+    // The entry a_ij
+    typedef std::function<double(std::size_t i, std::size_t j)> EntryFunction;
+
+    // y[i - begin] = A(i, :) * x for begin <= i < end, where x points to
+    // ncols() values and y to (end - begin) values
+    //
+    typedef std::function<void(std::size_t begin, std::size_t end,
+            const double * x, double * y)> RowsFunction;
+
+    // The value a_ii
+    typedef std::function<double(std::size_t i)> DiagonalFunction;
+
+    FunctionOperator();
+
+    // An nrows x ncols matrix of the entries. checkDominant() computes all
+    // entries once.
+    //
+    FunctionOperator(std::size_t nrows, std::size_t ncols,
+            const EntryFunction & entry);
+
+    // An nrows x ncols matrix of the row products and the diagonal. Without
+    // the entries, the diagonal dominance can't be checked, so it has to
+    // be given.
+    //
+    FunctionOperator(std::size_t nrows, std::size_t ncols,
+            const RowsFunction & rows, const DiagonalFunction & diagonal,
+            bool dominant = false);
+
+    virtual ~FunctionOperator();
+
+    std::size_t nrows() const override;
+    std::size_t ncols() const override;
+
+    // The interface of the iterative solvers. Please see LinearOperator.h.
+    void multiply(const Vector & x, Vector & y) const override;
+    double rowProduct(std::size_t i, const double * x) const override;
+    void multiplyRows(std::size_t begin, std::size_t end,
+            const double * x, double * y) const override;
+    double diagonal(std::size_t i) const override;
+    bool checkDominant() const override;
+
+    // Print the shape. The entries are not printed.
+    void print(std::ostream &) const override;
+
+private:
+    std::size_t nrows_ = 0;
+    std::size_t ncols_ = 0;
+
+    EntryFunction entry_;
+    RowsFunction rows_;
+    DiagonalFunction diagonal_;
+
+    // -1 until the dominance of the entries is checked
+    mutable int dominant_ = -1;
+};
+
+#endif /* FUNCTIONOPERATOR_H */
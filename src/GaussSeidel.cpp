@@ -0,0 +1,228 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   GaussSeidel.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 15, 2026, 9:40 AM
+ */
+
+#include "GaussSeidel.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+GaussSeidel::GaussSeidel(const LinearOperator & A, double omega,
+        bool symmetric, size_t ncolors) :
+A_(A), omega_(omega), symmetric_(symmetric) {
+
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    if (omega <= 0 || omega >= 2) {
+        throw runtime_error("Error: The relaxation factor should be within (0, 2).");
+    }
+
+    diag_.resize(A.nrows());
+    for (size_t i = 0; i < A.nrows(); i++) {
+        diag_[i] = A.diagonal(i);
+        if (abs(diag_[i]) < _ZERO_LIMIT) {
+            ostringstream message;
+            message << "Error: 0 occurs (" << diag_[i] << ") on the diagonal at row " << i << ".";
+            throw runtime_error(message.str());
+        }
+    }
+
+    if (ncolors > 1) color(ncolors);
+
+    row_resids_.resize(A.nrows());
+}
+
+void
+GaussSeidel::color(size_t max_colors) {
+
+    // Every row gets the smallest color that none of the coupled rows
+    // before it has. The colors of the rows after it are not known yet,
+    // so every row passes its color on to the rows after it in its
+    // pattern, and they are forgotten once these rows are colored.
+    //
+    size_t n = A_.nrows();
+    vector<size_t> row_color(n), cols, taken;
+    vector< vector<size_t> > passed(n);
+    vector<char> used(max_colors, 0);
+
+    colors_.clear();
+    color_work_.clear();
+
+    for (size_t i = 0; i < n; i++) {
+        if (!A_.rowPattern(i, cols)) {
+            colors_.clear();
+            return;
+        }
+
+        taken.swap(passed[i]);
+        vector<size_t>().swap(passed[i]);
+        for (size_t j : cols) {
+            if (j < i) taken.push_back(row_color[j]);
+        }
+
+        for (size_t c : taken) used[c] = 1;
+        size_t c = 0;
+        while (c < max_colors && used[c]) c++;
+        for (size_t t : taken) used[t] = 0;
+        taken.clear();
+
+        if (c == max_colors) {
+            colors_.clear();
+            return;
+        }
+
+        row_color[i] = c;
+        for (size_t j : cols) {
+            if (j > i && j < n) passed[j].push_back(c);
+        }
+
+        if (c == colors_.size()) {
+            colors_.push_back(vector<size_t>());
+            color_work_.push_back(0);
+        }
+        colors_[c].push_back(i);
+        color_work_[c] += cols.size();
+    }
+}
+
+GaussSeidel::~GaussSeidel() {
+}
+
+double
+GaussSeidel::omega() const {
+    return (omega_);
+}
+
+bool
+GaussSeidel::symmetric() const {
+    return (symmetric_);
+}
+
+size_t
+GaussSeidel::ncolors() const {
+    return (colors_.empty() ? 1 : colors_.size());
+}
+
+void
+GaussSeidel::sweep(const Vector & b, Vector & x) const {
+    if (b.size() != A_.nrows() || x.size() != A_.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    if (colors_.empty()) {
+        forwardSweep(b, x);
+        if (symmetric_) backwardSweep(b, x);
+    } else {
+        for (size_t c = 0; c < colors_.size(); c++) colorSweep(c, b, x);
+        if (symmetric_) {
+            for (size_t c = colors_.size(); c > 0; c--) colorSweep(c - 1, b, x);
+        }
+    }
+}
+
+double
+GaussSeidel::solve(const Vector & b, Vector & x, size_t max_it,
+        double small_resid, int verbose) const {
+
+    return (solve(b, x, max_it, Convergence(small_resid), verbose));
+}
+
+double
+GaussSeidel::solve(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, int verbose) const {
+
+    Vector resids;
+    ConvergenceMonitor monitor(criterion, criterion.measure(b));
+    double resid_metric = 999;
+    bool exact = false;
+
+    for (size_t i_it = 0; i_it < max_it; i_it++) {
+        sweep(b, x);
+
+        // The residuals of the rows when they were updated come with the
+        // sweep. Only a small enough estimate is confirmed with A * x.
+        //
+        resid_metric = criterion.measure(row_resids_);
+        exact = false;
+
+        if (resid_metric <= monitor.threshold()) {
+            residual(A_, x, b, resids);
+            resid_metric = criterion.measure(resids);
+            exact = true;
+        }
+
+        if (verbose >= 2) {
+            cout << "Iteration " << i_it + 1 << " residual: " << resid_metric << endl;
+        }
+
+        if (monitor.check(resid_metric) != Convergence::ITERATING) break;
+    }
+
+    if (!exact) {
+        residual(A_, x, b, resids);
+        resid_metric = criterion.measure(resids);
+    }
+
+    status_ = monitor.status();
+    return (resid_metric);
+}
+
+Convergence::Status
+GaussSeidel::status() const {
+    return (status_);
+}
+
+double
+GaussSeidel::update(size_t i, const Vector & b, const Vector & x) const {
+    const double *px = x.data();
+    double resid = b[i] - A_.rowProduct(i, px);
+    row_resids_[i] = resid;
+
+    // The sum includes a_ii * x_i, so the update is written as a correction
+    return (px[i] + omega_ * resid / diag_[i]);
+}
+
+void
+GaussSeidel::forwardSweep(const Vector & b, Vector & x) const {
+    for (size_t i = 0; i < A_.nrows(); i++) {
+        x[i] = update(i, b, x);
+    }
+}
+
+void
+GaussSeidel::backwardSweep(const Vector & b, Vector & x) const {
+    for (size_t i = A_.nrows(); i > 0; i--) {
+        x[i - 1] = update(i - 1, b, x);
+    }
+}
+
+void
+GaussSeidel::colorSweep(size_t color, const Vector & b, Vector & x) const {
+    const vector<size_t> & rows = colors_[color];
+    long nrows = rows.size();
+
+    // The rows of a color are not coupled, so they are updated in place
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(color_work_[color]);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(rows, nrows, b, x)
+#endif
+    for (long k = 0; k < nrows; k++) {
+        x[rows[k]] = update(rows[k], b, x);
+    }
+}
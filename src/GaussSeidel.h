@@ -0,0 +1,105 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   GaussSeidel.h
+ * Author: Weiming Hu
+ *
+ * Created on October 15, 2026, 9:40 AM
+ */
+
+#ifndef GAUSSSEIDEL_H
+#define GAUSSSEIDEL_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+#include "Convergence.h"
+
+#include <vector>
+
+// Gauss-Seidel Method
+//
+// For the linear system Ax = b, each sweep updates x in place row by row
+//
+//   x_i = (1 - w) * x_i + w * (b_i - sum_{j != i} a_ij * x_j) / a_ii
+//
+// where w is the relaxation factor. w = 1 is the Gauss-Seidel method and
+// 1 < w < 2 is successive over-relaxation (SOR). The symmetric variant
+// (SSOR) follows each forward sweep with a backward sweep.
+//
+// With more than one color, the rows are colored greedily from the
+// sparsity pattern (see LinearOperator::rowPattern), so that no two rows
+// of the same color are coupled by a_ij or a_ji. Colors are visited one
+// after another and the rows of the same color are updated in place
+// together using OpenMP, which is the Gauss-Seidel method in the order of
+// the colors. A 5-point stencil on a 2-D grid in the natural order gets
+// the red-black ordering.
+//
+// ncolors is the largest number of colors. When the coloring needs more,
+// or the pattern is not known, e.g. for a dense matrix, the rows are swept
+// one after another. A can be dense or sparse.
+//
+class GaussSeidel {
+public:
+    GaussSeidel(const LinearOperator & A, double omega = 1.0,
+            bool symmetric = false, std::size_t ncolors = 1);
+    virtual ~GaussSeidel();
+
+    // Carry out one sweep in place
+    void sweep(const Vector & b, Vector & x) const;
+
+    // Iterate until the L1 norm of the residual is not larger than
+    // small_resid or max_it is reached. The L1 norm of the final residual
+    // is returned.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            double small_resid, int verbose = 0) const;
+
+    // Iterate until the criterion stops. The residual of an iteration is
+    // estimated from the residuals of the rows when the sweep updated
+    // them, which needs no extra product with A. The residual of x is only
+    // computed to confirm an estimate that has converged and after the
+    // last iteration. Its norm is returned.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, int verbose = 0) const;
+
+    // The status of the last solve
+    Convergence::Status status() const;
+
+    double omega() const;
+    bool symmetric() const;
+
+    // The number of colors of the sweeps, which is 1 for the sweeps of
+    // the rows one after another
+    //
+    std::size_t ncolors() const;
+
+private:
+    void forwardSweep(const Vector & b, Vector & x) const;
+    void backwardSweep(const Vector & b, Vector & x) const;
+    void colorSweep(std::size_t color, const Vector & b, Vector & x) const;
+
+    // Color the rows with at most max_colors colors. colors_ stays empty
+    // when this is not possible.
+    //
+    void color(std::size_t max_colors);
+
+    // Relaxed update for row i given the current values of x. The residual
+    // of the row is kept in row_resids_.
+    double update(std::size_t i, const Vector & b, const Vector & x) const;
+
+    const LinearOperator & A_;
+    Vector diag_;
+    double omega_;
+    bool symmetric_;
+
+    // Row indices of each color, and the stored values of their rows
+    std::vector< std::vector<std::size_t> > colors_;
+    std::vector<std::size_t> color_work_;
+
+    // The residual of every row at its last update in a sweep
+    mutable Vector row_resids_;
+    mutable Convergence::Status status_ = Convergence::ITERATING;
+};
+
+#endif /* GAUSSSEIDEL_H */
@@ -0,0 +1,385 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Gemm.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 14, 2026, 10:12 AM
+ */
+
+#include "Gemm.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Register tile of the micro-kernel. MR rows of A are multiplied with NR
+// columns of B and the MR x NR results are kept in registers.
+//
+#if defined(__AVX512F__)
+#define GEMM_MR 8
+#define GEMM_NR 16
+#elif defined(__AVX2__) && defined(__FMA__)
+#define GEMM_MR 6
+#define GEMM_NR 8
+#else
+#define GEMM_MR 4
+#define GEMM_NR 4
+#endif
+
+// Cache blocking sizes. GEMM_MC should be a multiple of GEMM_MR and
+// GEMM_NC should be a multiple of GEMM_NR.
+//
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+
+#ifndef GEMM_MC
+#define GEMM_MC 120
+#endif
+
+#ifndef GEMM_NC
+#define GEMM_NC 2048
+#endif
+
+// Products with fewer multiply-adds than this skip packing
+#ifndef GEMM_SMALL
+#define GEMM_SMALL 32768
+#endif
+
+#define GEMM_ALIGNMENT 64
+
+static double *
+allocatePanel(size_t length) {
+    void *p = nullptr;
+    if (posix_memalign(&p, GEMM_ALIGNMENT, length * sizeof(double)) != 0) {
+        throw runtime_error("Error: Failed to allocate memory for gemm.");
+    }
+    return (static_cast<double *> (p));
+}
+
+// Compute the MR x NR tile AB = Ap * Bp, where Ap is a packed micro-panel
+// of A (kc x MR, column by column) and Bp is a packed micro-panel of B
+// (kc x NR, row by row).
+//
+static void
+microKernel(size_t kc, const double * Ap, const double * Bp, double * AB) {
+
+#if defined(__AVX512F__)
+    __m512d c[GEMM_MR][2];
+    for (size_t r = 0; r < GEMM_MR; r++) {
+        c[r][0] = _mm512_setzero_pd();
+        c[r][1] = _mm512_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_load_pd(Bp);
+        __m512d b1 = _mm512_load_pd(Bp + 8);
+        for (size_t r = 0; r < GEMM_MR; r++) {
+            __m512d a = _mm512_set1_pd(Ap[r]);
+            c[r][0] = _mm512_fmadd_pd(a, b0, c[r][0]);
+            c[r][1] = _mm512_fmadd_pd(a, b1, c[r][1]);
+        }
+        Ap += GEMM_MR;
+        Bp += GEMM_NR;
+    }
+
+    for (size_t r = 0; r < GEMM_MR; r++) {
+        _mm512_store_pd(AB + r * GEMM_NR, c[r][0]);
+        _mm512_store_pd(AB + r * GEMM_NR + 8, c[r][1]);
+    }
+
+#elif defined(__AVX2__) && defined(__FMA__)
+    __m256d c[GEMM_MR][2];
+    for (size_t r = 0; r < GEMM_MR; r++) {
+        c[r][0] = _mm256_setzero_pd();
+        c[r][1] = _mm256_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_load_pd(Bp);
+        __m256d b1 = _mm256_load_pd(Bp + 4);
+        for (size_t r = 0; r < GEMM_MR; r++) {
+            __m256d a = _mm256_broadcast_sd(Ap + r);
+            c[r][0] = _mm256_fmadd_pd(a, b0, c[r][0]);
+            c[r][1] = _mm256_fmadd_pd(a, b1, c[r][1]);
+        }
+        Ap += GEMM_MR;
+        Bp += GEMM_NR;
+    }
+
+    for (size_t r = 0; r < GEMM_MR; r++) {
+        _mm256_store_pd(AB + r * GEMM_NR, c[r][0]);
+        _mm256_store_pd(AB + r * GEMM_NR + 4, c[r][1]);
+    }
+
+#else
+    double c[GEMM_MR][GEMM_NR] = {};
+
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t r = 0; r < GEMM_MR; r++) {
+            for (size_t j = 0; j < GEMM_NR; j++) {
+                c[r][j] += Ap[r] * Bp[j];
+            }
+        }
+        Ap += GEMM_MR;
+        Bp += GEMM_NR;
+    }
+
+    for (size_t r = 0; r < GEMM_MR; r++) {
+        for (size_t j = 0; j < GEMM_NR; j++) {
+            AB[r * GEMM_NR + j] = c[r][j];
+        }
+    }
+#endif
+
+    return;
+}
+
+// Pack the mc x kc block of A into micro-panels of GEMM_MR rows. Rows
+// beyond mc are padded with 0.
+//
+static void
+packA(size_t mc, size_t kc, const double *A, size_t lda, double *Ap) {
+    for (size_t ir = 0; ir < mc; ir += GEMM_MR) {
+        size_t mr = min((size_t) GEMM_MR, mc - ir);
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t r = 0; r < mr; r++) {
+                Ap[r] = A[(ir + r) * lda + p];
+            }
+            for (size_t r = mr; r < GEMM_MR; r++) {
+                Ap[r] = 0.0;
+            }
+            Ap += GEMM_MR;
+        }
+    }
+}
+
+// Pack the kc x nc block of B into micro-panels of GEMM_NR columns.
+// Columns beyond nc are padded with 0.
+//
+static void
+packB(size_t kc, size_t nc, const double *B, size_t ldb, double *Bp) {
+    for (size_t jr = 0; jr < nc; jr += GEMM_NR) {
+        size_t nr = min((size_t) GEMM_NR, nc - jr);
+        for (size_t p = 0; p < kc; p++) {
+            const double *b = B + p * ldb + jr;
+            for (size_t j = 0; j < nr; j++) {
+                Bp[j] = b[j];
+            }
+            for (size_t j = nr; j < GEMM_NR; j++) {
+                Bp[j] = 0.0;
+            }
+            Bp += GEMM_NR;
+        }
+    }
+}
+
+// C = alpha * AB + beta * C for the valid mr x nr part of a tile
+static void
+updateTile(size_t mr, size_t nr, double alpha, const double *AB,
+        double beta, double *C, size_t ldc) {
+    for (size_t r = 0; r < mr; r++) {
+        double *c = C + r * ldc;
+        const double *ab = AB + r * GEMM_NR;
+
+        if (beta == 0.0) {
+            for (size_t j = 0; j < nr; j++) c[j] = alpha * ab[j];
+        } else {
+            for (size_t j = 0; j < nr; j++) c[j] = alpha * ab[j] + beta * c[j];
+        }
+    }
+}
+
+// Scale C by beta. C is set to 0 without being read when beta is 0.
+static void
+scaleC(size_t m, size_t n, double beta, double *C, size_t ldc) {
+    for (size_t i = 0; i < m; i++) {
+        double *c = C + i * ldc;
+        if (beta == 0.0) {
+            fill(c, c + n, 0.0);
+        } else if (beta != 1.0) {
+            for (size_t j = 0; j < n; j++) c[j] *= beta;
+        }
+    }
+}
+
+void
+gemm(size_t m, size_t n, size_t k, double alpha,
+        const double *A, size_t lda, const double *B, size_t ldb,
+        double beta, double *C, size_t ldc, const ExecutionContext & context) {
+
+    if (m == 0 || n == 0) return;
+
+    if (k == 0 || alpha == 0.0) {
+        scaleC(m, n, beta, C, ldc);
+        return;
+    }
+
+    if (m * n * k <= GEMM_SMALL) {
+        // Small products are computed row by row in the i-k-j order so
+        // that both B and C are accessed contiguously.
+        //
+        scaleC(m, n, beta, C, ldc);
+        for (size_t i = 0; i < m; i++) {
+            double *c = C + i * ldc;
+            for (size_t p = 0; p < k; p++) {
+                double a = alpha * A[i * lda + p];
+                const double *b = B + p * ldb;
+                for (size_t j = 0; j < n; j++) {
+                    c[j] += a * b[j];
+                }
+            }
+        }
+        return;
+    }
+
+    // The packed panel of B is shared, and the threads work on the blocks
+    // of MC rows with their own packed blocks of A
+    //
+    double *Bp = allocatePanel(GEMM_KC * GEMM_NC);
+    long nblocks = (m + GEMM_MC - 1) / GEMM_MC;
+
+#if defined(_OPENMP)
+    int nthreads = context.threads(m * n * k);
+#pragma omp parallel num_threads(nthreads) default(none) \
+shared(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, Bp, nblocks)
+#else
+    (void) context;
+#endif
+    {
+        double *Ap = allocatePanel(GEMM_MC * GEMM_KC);
+        double AB[GEMM_MR * GEMM_NR] __attribute__((aligned(GEMM_ALIGNMENT)));
+
+        for (size_t jc = 0; jc < n; jc += GEMM_NC) {
+            size_t nc = min((size_t) GEMM_NC, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+                size_t kc = min((size_t) GEMM_KC, k - pc);
+
+                // Only the first panel of the depth dimension applies beta
+                double beta_panel = (pc == 0 ? beta : 1.0);
+
+                // The barriers of single and for keep Bp from being
+                // packed again while it is used
+                //
+#if defined(_OPENMP)
+#pragma omp single
+#endif
+                packB(kc, nc, B + pc * ldb + jc, ldb, Bp);
+
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+                for (long block = 0; block < nblocks; block++) {
+                    size_t ic = block * GEMM_MC;
+                    size_t mc = min((size_t) GEMM_MC, m - ic);
+
+                    packA(mc, kc, A + ic * lda + pc, lda, Ap);
+
+                    for (size_t jr = 0; jr < nc; jr += GEMM_NR) {
+                        size_t nr = min((size_t) GEMM_NR, nc - jr);
+
+                        for (size_t ir = 0; ir < mc; ir += GEMM_MR) {
+                            size_t mr = min((size_t) GEMM_MR, mc - ir);
+
+                            microKernel(kc, Ap + ir * kc, Bp + jr * kc, AB);
+                            updateTile(mr, nr, alpha, AB, beta_panel,
+                                    C + (ic + ir) * ldc + jc + jr, ldc);
+                        }
+                    }
+                }
+            }
+        }
+
+        free(Ap);
+    }
+
+    free(Bp);
+    return;
+}
+
+void
+gemv(size_t m, size_t n, double alpha,
+        const double *A, size_t lda, const double *x, size_t incx,
+        double beta, double *y, size_t incy, const ExecutionContext & context) {
+
+    if (m == 0) return;
+
+    // Make x continuous so that the inner products can be vectorized
+    double *x_copy = nullptr;
+    if (incx != 1) {
+        x_copy = allocatePanel(n);
+        for (size_t j = 0; j < n; j++) x_copy[j] = x[j * incx];
+        x = x_copy;
+    }
+
+    // Four rows are processed together to reuse the loaded values of x.
+    // The groups of rows are divided between the threads.
+    //
+    long ngroups = m / 4;
+
+#if defined(_OPENMP)
+    int nthreads = context.threads(m * n);
+#pragma omp parallel for num_threads(nthreads) schedule(static) default(none) \
+shared(n, alpha, A, lda, x, beta, y, incy, ngroups)
+#else
+    (void) context;
+#endif
+    for (long group = 0; group < ngroups; group++) {
+        size_t i = group * 4;
+        const double *a0 = A + i * lda, *a1 = a0 + lda,
+                *a2 = a1 + lda, *a3 = a2 + lda;
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:s0,s1,s2,s3)
+#endif
+        for (size_t j = 0; j < n; j++) {
+            s0 += a0[j] * x[j];
+            s1 += a1[j] * x[j];
+            s2 += a2[j] * x[j];
+            s3 += a3[j] * x[j];
+        }
+
+        double s[4] = {s0, s1, s2, s3};
+        for (size_t r = 0; r < 4; r++) {
+            double *yi = y + (i + r) * incy;
+            *yi = (beta == 0.0 ? alpha * s[r] : alpha * s[r] + beta * (*yi));
+        }
+    }
+
+    for (size_t i = ngroups * 4; i < m; i++) {
+        const double *a = A + i * lda;
+        double s = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:s)
+#endif
+        for (size_t j = 0; j < n; j++) {
+            s += a[j] * x[j];
+        }
+
+        double *yi = y + i * incy;
+        *yi = (beta == 0.0 ? alpha * s : alpha * s + beta * (*yi));
+    }
+
+    free(x_copy);
+    return;
+}
+
+const char *
+gemmKernelName() {
+#if defined(__AVX512F__)
+    return ("AVX-512 8x16");
+#elif defined(__AVX2__) && defined(__FMA__)
+    return ("AVX2 6x8");
+#else
+    return ("generic 4x4");
+#endif
+}
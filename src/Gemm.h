@@ -0,0 +1,50 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Gemm.h
+ * Author: Weiming Hu
+ *
+ * Created on October 14, 2026, 10:12 AM
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "ExecutionContext.h"
+
+#include <cstddef>
+
+// Dense kernels for row-major matrices. The element (i, j) of a matrix
+// with the leading dimension ld is located at p[i * ld + j].
+//
+// The cache blocking sizes of the matrix-matrix product can be changed
+// at compile time, e.g. -DGEMM_KC=384.
+//
+//   GEMM_KC: depth of the packed panels. A micro-panel of B (KC x NR)
+//            should stay in L1.
+//   GEMM_MC: rows of the packed block of A (MC x KC), which should stay in L2.
+//   GEMM_NC: columns of the packed block of B (KC x NC), which should stay in L3.
+//
+
+// C = alpha * A * B + beta * C, where A is m x k, B is k x n, and C is m x n.
+// C is not read when beta is 0. The blocks of MC rows are divided between
+// the threads of the context (see ExecutionContext.h).
+//
+void gemm(std::size_t m, std::size_t n, std::size_t k, double alpha,
+        const double *A, std::size_t lda, const double *B, std::size_t ldb,
+        double beta, double *C, std::size_t ldc,
+        const ExecutionContext & context = ExecutionContext::current());
+
+// y = alpha * A * x + beta * y, where A is m x n. The vectors can be strided
+// with incx and incy, for example, when they are columns of a matrix.
+// y is not read when beta is 0. The groups of four rows are divided between
+// the threads of the context.
+//
+void gemv(std::size_t m, std::size_t n, double alpha,
+        const double *A, std::size_t lda, const double *x, std::size_t incx,
+        double beta, double *y, std::size_t incy,
+        const ExecutionContext & context = ExecutionContext::current());
+
+// The name of the micro-kernel selected at compile time
+const char * gemmKernelName();
+
+#endif /* GEMM_H */
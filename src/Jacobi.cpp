@@ -0,0 +1,432 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Jacobi.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 15, 2026, 3:05 PM
+ */
+
+#include "Jacobi.h"
+#include "ExecutionContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+Vector
+inverseDiagonal(const LinearOperator & A) {
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    Vector D_inv(A.nrows());
+    for (size_t i = 0; i < A.nrows(); i++) {
+        double diag = A.diagonal(i);
+        if (abs(diag) < _ZERO_LIMIT) {
+            ostringstream message;
+            message << "Error: 0 occurs (" << diag << ") on the diagonal at row " << i << ".";
+            throw runtime_error(message.str());
+        }
+        D_inv[i] = 1.0 / diag;
+    }
+
+    return (D_inv);
+}
+
+double
+jacobiRadius(const LinearOperator & A, const Vector & D_inv, size_t steps) {
+    size_t n = A.nrows();
+    if (n == 0) return (0.0);
+
+    // The start vector is not constant, which could be orthogonal to the
+    // dominant eigenvector, e.g. when the rows of A add up to 0
+    //
+    Vector v(n), w(n);
+    for (size_t i = 0; i < n; i++) v[i] = 1.0 + (double) (i % 10) / 10.0;
+
+    double v_norm = norm2(v), rho = 0.0;
+    for (size_t k = 0; k < steps; k++) {
+
+        // w = G * v = v - D^-1 * A * v
+        A.multiply(v, w);
+        for (size_t i = 0; i < n; i++) w[i] = v[i] - D_inv[i] * w[i];
+
+        double w_norm = norm2(w);
+        rho = w_norm / v_norm;
+        if (w_norm == 0.0 || !std::isfinite(w_norm)) break;
+
+        // v is scaled to the unit norm
+        for (size_t i = 0; i < n; i++) v[i] = w[i] / w_norm;
+        v_norm = 1.0;
+    }
+
+    return (rho);
+}
+
+ChebyshevWeights::ChebyshevWeights(double rho) : rho_(rho) {
+}
+
+ChebyshevWeights::~ChebyshevWeights() {
+}
+
+double
+ChebyshevWeights::next() {
+    double rho2 = rho_ * rho_;
+
+    if (omega_ == 0.0) {
+        omega_ = 1.0;
+    } else if (omega_ == 1.0) {
+        omega_ = 2.0 / (2.0 - rho2);
+    } else {
+        omega_ = 1.0 / (1.0 - rho2 * omega_ / 4.0);
+    }
+
+    return (omega_);
+}
+
+double
+ChebyshevWeights::radius() const {
+    return (rho_);
+}
+
+// The partial residuals of the threads are padded to separate cache lines
+static const size_t _PARTIAL_STRIDE = 8;
+
+Jacobi::Jacobi(const LinearOperator & A) :
+A_(A), D_inv_(::inverseDiagonal(A)), check_every_(1) {
+}
+
+Jacobi::~Jacobi() {
+}
+
+const Vector &
+Jacobi::inverseDiagonal() const {
+    return (D_inv_);
+}
+
+void
+Jacobi::setCheckInterval(size_t k) {
+    if (k == 0) {
+        throw runtime_error("Error: The check interval should be positive.");
+    }
+    check_every_ = k;
+}
+
+size_t
+Jacobi::checkInterval() const {
+    return (check_every_);
+}
+
+void
+Jacobi::setChebyshev(bool chebyshev) {
+    chebyshev_ = chebyshev;
+}
+
+bool
+Jacobi::chebyshev() const {
+    return (chebyshev_);
+}
+
+void
+Jacobi::setSpectralRadius(double rho) {
+    rho_ = rho;
+}
+
+double
+Jacobi::spectralRadius() const {
+    if (rho_ < 0.0) rho_ = CHEBYSHEV_RADIUS_FACTOR * jacobiRadius(A_, D_inv_);
+    return (rho_);
+}
+
+Convergence::Status
+Jacobi::status() const {
+    return (status_);
+}
+
+void
+Jacobi::sweep(const Vector & b, const Vector & x, Vector & x_new) const {
+    if (b.size() != A_.nrows() || x.size() != A_.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    // x_new holds A * x first, and then it is updated in place
+    A_.multiply(x, x_new);
+
+    const double *px = x.data();
+    long nrows = A_.nrows();
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(b, x_new, px, nrows)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        x_new[i] = px[i] + D_inv_[i] * (b[i] - x_new[i]);
+    }
+}
+
+double
+Jacobi::solve(const Vector & b, Vector & x, size_t max_it,
+        double small_resid, int verbose) const {
+    return (solve(b, x, max_it, Convergence(small_resid), verbose));
+}
+
+double
+Jacobi::solve(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, int verbose) const {
+
+    if (b.size() != A_.nrows() || x.size() != A_.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    double resid_metric = 999;
+    Convergence::Status status = Convergence::ITERATING;
+    status_ = status;
+    if (max_it == 0) return (resid_metric);
+
+    double b_norm = criterion.measure(b);
+
+    size_t nrows = A_.nrows(), check_every = check_every_;
+    int nthreads = ExecutionContext::current().threads(nrows * A_.ncols());
+
+    // The weights of the iterations are computed by every thread
+    double rho = (chebyshev_ ? spectralRadius() : 0.0);
+    bool accelerate = (chebyshev_ && rho >= 0.0 && rho < 1.0);
+
+    // Step j computes r = b - A * x_j, which is the residual of iteration
+    // j, and x_j+1 = x_j + D^-1 * r from it
+    //
+    Vector x_next(nrows), y(nrows);
+    double *buffers[2] = {x.data(), x_next.data()};
+    double *result = buffers[0];
+
+    // The partial residuals of a check step are read after its barrier,
+    // while the next step could already write its own. Steps of the two
+    // parities use different slots.
+    //
+    vector<double> partials(2 * _PARTIAL_STRIDE * nthreads, 0.0);
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads) default(none) \
+shared(b, y, buffers, result, partials, resid_metric, status, nrows, nthreads, \
+check_every, max_it, criterion, b_norm, verbose, rho, accelerate, cout)
+#endif
+    {
+        int tid = 0, team = 1;
+#if defined(_OPENMP)
+        tid = omp_get_thread_num();
+        team = omp_get_num_threads();
+#endif
+
+        // The block of rows of the thread, which starts at a multiple of
+        // the alignment when every thread gets at least one
+        //
+        size_t alignment = A_.rowAlignment();
+        if ((nrows + alignment - 1) / alignment < (size_t) team) alignment = 1;
+        size_t units = (nrows + alignment - 1) / alignment;
+        size_t begin = min(nrows, units * tid / team * alignment);
+        size_t end = min(nrows, units * (tid + 1) / team * alignment);
+
+        double *px = buffers[0], *px_next = buffers[1], *py = y.data();
+        const double *pb = b.data(), *pd = D_inv_.data();
+
+        // Every thread checks the same residuals, so a monitor per thread
+        // comes to the same decisions without a broadcast
+        //
+        ConvergenceMonitor monitor(criterion, b_norm);
+        ChebyshevWeights weights(rho);
+
+        for (size_t j = 0;; j++) {
+            bool check = (j >= 1 && (j % check_every == 0 || j == max_it));
+            double omega = (accelerate ? weights.next() : 1.0);
+
+            A_.multiplyRows(begin, end, px, py);
+
+            // y is overwritten with the residual, so that it can be
+            // measured in any norm. With the Chebyshev semi-iteration,
+            // x_next holds x_j-1 from the second step on.
+            //
+            if (omega == 1.0) {
+                for (size_t i = begin; i < end; i++) {
+                    py[i] = pb[i] - py[i];
+                    px_next[i] = px[i] + pd[i] * py[i];
+                }
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    py[i] = pb[i] - py[i];
+                    px_next[i] += omega * (px[i] + pd[i] * py[i] - px_next[i]);
+                }
+            }
+
+            if (check) {
+                partials[(j % 2 * nthreads + tid) * _PARTIAL_STRIDE] =
+                        criterion.accumulate(py + begin, end - begin);
+            }
+
+#if defined(_OPENMP)
+#pragma omp barrier
+#endif
+
+            if (check) {
+
+                // Every thread adds the partials in the same order, so
+                // that they all come to the same decision
+                //
+                double resid = 0.0;
+                for (int t = 0; t < team; t++) {
+                    resid = criterion.combine(resid, partials[(j % 2 * nthreads + t) * _PARTIAL_STRIDE]);
+                }
+                resid = criterion.finish(resid);
+                Convergence::Status step_status = monitor.check(resid);
+
+                if (tid == 0) {
+                    resid_metric = resid;
+                    status = step_status;
+                    if (verbose >= 2) {
+                        cout << "Iteration " << j << " residual: " << resid << endl;
+                    }
+                }
+
+                if (step_status != Convergence::ITERATING || j == max_it) {
+                    if (tid == 0) result = px;
+                    break;
+                }
+            }
+
+            swap(px, px_next);
+        }
+    }
+
+    if (result != x.data()) x.swap(x_next);
+    status_ = status;
+
+    return (resid_metric);
+}
+
+double
+Jacobi::solve(const Matrix & B, Matrix & X, size_t max_it,
+        double small_resid, int verbose) const {
+    return (solve(B, X, max_it, Convergence(small_resid), verbose));
+}
+
+double
+Jacobi::solve(const Matrix & B, Matrix & X, size_t max_it,
+        const Convergence & criterion, int verbose) const {
+
+    if (B.nrows() != A_.nrows() || X.nrows() != A_.ncols() || X.ncols() != B.ncols()) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    // Every column takes at least one iteration like the single solve
+    size_t k = B.ncols(), nrows = A_.nrows(), check_every = check_every_;
+    Vector resids(k, 0.0);
+    vector<size_t> active(k);
+    vector<ConvergenceMonitor> monitors;
+    for (size_t j = 0; j < k; j++) {
+        active[j] = j;
+        monitors.push_back(ConvergenceMonitor(criterion,
+                criterion.finish(criterion.accumulate(B[0] + j, B.nrows(), B.stride()))));
+    }
+
+    double resid_metric = (k == 0 ? 0.0 : 999);
+    status_ = Convergence::ITERATING;
+    if (max_it == 0) return (resid_metric);
+
+    // All active columns have taken the same steps, so they share the
+    // weights of the Chebyshev semi-iteration. X_prev holds x_j-1 of the
+    // columns.
+    //
+    double rho = (chebyshev_ ? spectralRadius() : 0.0);
+    bool accelerate = (chebyshev_ && rho >= 0.0 && rho < 1.0);
+    ChebyshevWeights weights(rho);
+    Matrix X_prev(accelerate ? nrows : 0, accelerate ? k : 0);
+
+    // Step j computes R = B - A * X_j of the active columns, which is both
+    // the residual of iteration j and the update to X_j+1. Column c of R
+    // and X_active is the column active[c] of X.
+    //
+    Matrix X_active, R;
+    long n_rows = nrows;
+
+    for (size_t j = 0; !active.empty(); j++) {
+        bool check = (j >= 1 && (j % check_every == 0 || j == max_it));
+        double omega = (accelerate ? weights.next() : 1.0);
+        size_t n_active = active.size();
+
+        if (n_active == k) {
+            A_.multiplyBlock(X, R);
+        } else {
+            X_active.resize(nrows, n_active);
+            for (size_t i = 0; i < nrows; i++) {
+                for (size_t c = 0; c < n_active; c++) X_active[i][c] = X[i][active[c]];
+            }
+            A_.multiplyBlock(X_active, R);
+        }
+
+        for (size_t i = 0; i < nrows; i++) {
+            for (size_t c = 0; c < n_active; c++) R[i][c] = B[i][active[c]] - R[i][c];
+        }
+
+        if (check) {
+
+            // Only keep the columns that are still iterating
+            size_t n_kept = 0;
+            for (size_t c = 0; c < n_active; c++) {
+                size_t col = active[c];
+                resids[col] = criterion.finish(criterion.accumulate(R[0] + c, nrows, R.stride()));
+                if (monitors[col].check(resids[col]) != Convergence::ITERATING) continue;
+
+                // The residuals of the kept columns move along with them
+                if (n_kept != c) {
+                    for (size_t i = 0; i < nrows; i++) R[i][n_kept] = R[i][c];
+                }
+                active[n_kept++] = col;
+            }
+            active.resize(n_kept);
+            n_active = n_kept;
+            resid_metric = normInf(resids);
+
+            if (verbose >= 2) {
+                cout << "Iteration " << j << " residual: " << resid_metric << endl;
+            }
+
+            if (j == max_it) break;
+        }
+
+#if defined(_OPENMP)
+        int nthreads = ExecutionContext::current().threads(nrows * n_active);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(X, X_prev, R, active, n_rows, n_active, omega, accelerate)
+#endif
+        for (long i = 0; i < n_rows; i++) {
+            for (size_t c = 0; c < n_active; c++) {
+                size_t col = active[c];
+                double x_new = X[i][col] + D_inv_[i] * R[i][c];
+
+                if (accelerate) {
+                    if (omega != 1.0) x_new = X_prev[i][col] + omega * (x_new - X_prev[i][col]);
+                    X_prev[i][col] = X[i][col];
+                }
+
+                X[i][col] = x_new;
+            }
+        }
+    }
+
+    // The status of the batch is the worst status of the columns
+    status_ = Convergence::CONVERGED;
+    for (size_t j = 0; j < k; j++) {
+        status_ = Convergence::worst(status_, monitors[j].status());
+    }
+
+    return (resid_metric);
+}
@@ -0,0 +1,167 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Jacobi.h
+ * Author: Weiming Hu
+ *
+ * Created on October 15, 2026, 3:05 PM
+ */
+
+#ifndef JACOBI_H
+#define JACOBI_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+#include "Convergence.h"
+
+// The number of power iterations that estimate the spectral radius of the
+// Jacobi iteration matrix for the Chebyshev semi-iteration
+//
+#ifndef CHEBYSHEV_POWER_STEPS
+#define CHEBYSHEV_POWER_STEPS 20
+#endif
+
+// The power iterations approach the spectral radius from below, and an
+// underestimate slows the Chebyshev semi-iteration down much more than an
+// overestimate. The estimate is enlarged by this factor.
+//
+#ifndef CHEBYSHEV_RADIUS_FACTOR
+#define CHEBYSHEV_RADIUS_FACTOR 1.002
+#endif
+
+// The weights of the Chebyshev semi-iteration
+//
+// Let rho < 1 be the spectral radius of the iteration matrix G = I - D^-1 * A
+// of the Jacobi Method. When the eigenvalues of G are real, the iterates
+//
+//   x_k+1 = x_k-1 + omega_k+1 * (x_k + D^-1 * (b - A * x_k) - x_k-1)
+//
+// with omega_1 = 1, omega_2 = 2 / (2 - rho^2), and
+// omega_k+1 = 1 / (1 - rho^2 * omega_k / 4) reduce the error with the
+// Chebyshev polynomials on [-rho, rho], which takes about the square root
+// of the iterations of the Jacobi Method. The weights only depend on rho,
+// so they need no reductions.
+//
+class ChebyshevWeights {
+public:
+    explicit ChebyshevWeights(double rho = 0.0);
+    virtual ~ChebyshevWeights();
+
+    // The weight of the next iteration, starting with omega_1
+    double next();
+
+    double radius() const;
+
+private:
+    double rho_;
+    double omega_ = 0.0;
+};
+
+// Jacobi Method
+//
+// For the linear system Ax = b, let D be the diagonal of A. The iteration
+// scheme x_k+1 = D^-1 * (b - R * x_k) with R = A - D is rearranged to
+//
+//   x_k+1 = x_k + D^-1 * (b - A * x_k)
+//
+// so that only the inverse of the diagonal is stored and neither D nor R
+// needs to be formed. A can be dense or sparse.
+//
+class Jacobi {
+public:
+    Jacobi(const LinearOperator & A);
+    virtual ~Jacobi();
+
+    // Carry out one iteration x_new = x + D^-1 * (b - A * x)
+    void sweep(const Vector & b, const Vector & x, Vector & x_new) const;
+
+    // Iterate until the L1 norm of the residual is not larger than
+    // small_resid or max_it is reached. The L1 norm of the final residual
+    // is returned.
+    //
+    // The iterations run in one parallel region. Every thread owns a
+    // contiguous block of rows (see LinearOperator::rowAlignment), and the
+    // residual b - A * x_k is both the convergence check of x_k and the
+    // update to x_k+1, so there is one product and one barrier per
+    // iteration. The iterates are swapped by pointers.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            double small_resid, int verbose = 0) const;
+
+    // Iterate until the criterion stops. The norm of the criterion of the
+    // final residual is returned.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, int verbose = 0) const;
+
+    // Solve a batch of systems, one in every column of B and X, with one
+    // blocked product A * X per iteration. A column is neither multiplied
+    // nor updated after it has converged, so that it takes the same
+    // iterations as when it is solved alone, also with the Chebyshev
+    // semi-iteration and the check interval. The largest L1 norm of the
+    // final residuals is returned.
+    //
+    double solve(const Matrix & B, Matrix & X, std::size_t max_it,
+            double small_resid, int verbose = 0) const;
+    double solve(const Matrix & B, Matrix & X, std::size_t max_it,
+            const Convergence & criterion, int verbose = 0) const;
+
+    // The status of the last solve. The status of a batch is the worst
+    // status of its columns.
+    //
+    Convergence::Status status() const;
+
+    // The inverse of the diagonal of A
+    const Vector & inverseDiagonal() const;
+
+    // Accelerate the solves with the Chebyshev semi-iteration. The product
+    // and the convergence checks are the same as without it, and x_k+1
+    // overwrites x_k-1, so the single solve adds no vector and a batch adds
+    // one matrix. The default is off. When the spectral radius is not at
+    // least 0 and smaller than 1, e.g. when the Jacobi Method does not
+    // converge, the iterations are not accelerated.
+    //
+    // The Chebyshev semi-iteration needs real eigenvalues of D^-1 * A, e.g.
+    // for a symmetric A. Otherwise, it can take more iterations than the
+    // Jacobi Method.
+    //
+    void setChebyshev(bool chebyshev);
+    bool chebyshev() const;
+
+    // The spectral radius of I - D^-1 * A for the Chebyshev semi-iteration.
+    // Unless it is set, it is estimated with CHEBYSHEV_POWER_STEPS power
+    // iterations the first time it is needed.
+    //
+    void setSpectralRadius(double rho);
+    double spectralRadius() const;
+
+    // The residuals of the solves are only checked every k iterations
+    // and at max_it, which saves the reduction in the other iterations.
+    // The default is 1. The solve can take up to k - 1 more iterations
+    // than needed.
+    //
+    void setCheckInterval(std::size_t k);
+    std::size_t checkInterval() const;
+
+private:
+    const LinearOperator & A_;
+    Vector D_inv_;
+    std::size_t check_every_;
+    bool chebyshev_ = false;
+    mutable double rho_ = -1.0;
+    mutable Convergence::Status status_ = Convergence::ITERATING;
+};
+
+// Compute the inverse of the diagonal of A. An exception is thrown when
+// a diagonal value is 0.
+//
+Vector inverseDiagonal(const LinearOperator & A);
+
+// Estimate the spectral radius of the Jacobi iteration matrix
+// I - D^-1 * A with the given number of power iterations. The estimate is
+// not enlarged.
+//
+double jacobiRadius(const LinearOperator & A, const Vector & D_inv,
+        std::size_t steps = CHEBYSHEV_POWER_STEPS);
+
+#endif /* JACOBI_H */
@@ -0,0 +1,465 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Krylov.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 2:15 PM
+ */
+
+#include "Krylov.h"
+
+#include <cmath>
+#include <vector>
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+// y = x + beta * y
+static void
+xpay(const Vector & x, double beta, Vector & y) {
+    const double *px = x.data();
+    double *py = y.data();
+    size_t n = y.size();
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        py[i] = px[i] + beta * py[i];
+    }
+}
+
+// y = alpha * x
+static void
+scale(double alpha, const Vector & x, Vector & y) {
+    const double *px = x.data();
+    double *py = y.data();
+    size_t n = y.size();
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        py[i] = alpha * px[i];
+    }
+}
+
+static void
+printIteration(int verbose, size_t i_it, double resid) {
+    if (verbose >= 2) {
+        cout << "Iteration " << i_it << " residual: " << resid << endl;
+    }
+}
+
+Krylov::Krylov(const LinearOperator & A, Method method, size_t restart) :
+A_(A), method_(method), restart_(restart) {
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    if (method_ == GMRES && restart_ == 0) {
+        throw runtime_error("Error: GMRES needs at least 1 iteration between restarts.");
+    }
+}
+
+Krylov::~Krylov() {
+}
+
+Krylov::Method
+Krylov::method() const {
+    return (method_);
+}
+
+size_t
+Krylov::restart() const {
+    return (restart_);
+}
+
+string
+Krylov::name(Method method) {
+    switch (method) {
+        case CG:
+            return ("CG");
+        case BICGSTAB:
+            return ("BiCGSTAB");
+        default:
+            return ("GMRES");
+    }
+}
+
+Krylov::Method
+Krylov::method(const string & name) {
+    string lower(name);
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    if (lower == "cg") return (CG);
+    if (lower == "bicgstab") return (BICGSTAB);
+    if (lower == "gmres") return (GMRES);
+
+    throw runtime_error("Error: Unknown Krylov method " + name + ".");
+}
+
+void
+Krylov::setPreconditioner(const Preconditioner * M) {
+    M_ = M;
+}
+
+const Preconditioner *
+Krylov::preconditioner() const {
+    return (M_);
+}
+
+Convergence::Status
+Krylov::status() const {
+    return (status_);
+}
+
+void
+Krylov::reduce(double *, size_t) const {
+}
+
+void
+Krylov::reduceMax(double *, size_t) const {
+}
+
+void
+Krylov::reduceNorm(double * values, size_t count, const Convergence & criterion) const {
+    if (criterion.norm() == Convergence::LINF) {
+        if (count > 1) reduce(values, count - 1);
+        reduceMax(values + count - 1, 1);
+    } else {
+        reduce(values, count);
+    }
+}
+
+double
+Krylov::solve(const Vector & b, Vector & x, size_t max_it,
+        double small_resid, int verbose) const {
+    return (solve(b, x, max_it, Convergence(small_resid), verbose));
+}
+
+double
+Krylov::solve(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, int verbose) const {
+
+    if (b.size() != A_.nrows() || x.size() != A_.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    double b_norm = criterion.accumulate(b.data(), b.size());
+    reduceNorm(&b_norm, 1, criterion);
+    ConvergenceMonitor monitor(criterion, criterion.finish(b_norm));
+
+    double resid;
+    switch (method_) {
+        case CG:
+            resid = solveCG(b, x, max_it, criterion, monitor, verbose);
+            break;
+        case BICGSTAB:
+            resid = solveBiCGSTAB(b, x, max_it, criterion, monitor, verbose);
+            break;
+        default:
+            resid = solveGMRES(b, x, max_it, criterion, monitor, verbose);
+    }
+
+    status_ = monitor.status();
+    return (resid);
+}
+
+double
+Krylov::solveCG(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, ConvergenceMonitor & monitor,
+        int verbose) const {
+
+    Vector r, p, q(x.size()), z_work;
+
+    // z = M^-1 * r, which is r itself without a preconditioner
+    const Vector & z = (M_ ? z_work : r);
+
+    // sums[0] is r^T * z and sums[1] is the partial norm of r
+    double sums[2];
+    residual(A_, x, b, r);
+    sums[1] = criterion.accumulate(r.data(), r.size());
+    if (M_) M_->apply(r, z_work);
+    sums[0] = dot(r, z);
+    reduceNorm(sums, 2, criterion);
+
+    double rho = sums[0], resid = criterion.finish(sums[1]);
+    monitor.check(resid);
+    p = z;
+
+    for (size_t i_it = 0; i_it < max_it && monitor.status() == Convergence::ITERATING; i_it++) {
+        A_.multiply(p, q);
+
+        double pq = dot(p, q);
+        reduce(&pq, 1);
+
+        if (pq <= 0.0) {
+            throw runtime_error("Error: The matrix is not positive definite. Please use BiCGSTAB or GMRES.");
+        }
+
+        double alpha = rho / pq;
+        axpy(alpha, p, x);
+        axpy(-alpha, q, r);
+
+        if (M_) M_->apply(r, z_work);
+        sums[0] = dot(r, z);
+        sums[1] = criterion.accumulate(r.data(), r.size());
+        reduceNorm(sums, 2, criterion);
+
+        // p = z + beta * p
+        xpay(z, sums[0] / rho, p);
+        rho = sums[0];
+        resid = criterion.finish(sums[1]);
+
+        printIteration(verbose, i_it + 1, resid);
+        monitor.check(resid);
+    }
+
+    return (resid);
+}
+
+double
+Krylov::solveBiCGSTAB(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, ConvergenceMonitor & monitor,
+        int verbose) const {
+
+    size_t n = x.size();
+    Vector r, r_hat, p(n), v(n), s(n), t(n), p_work, s_work;
+
+    // M^-1 * p and M^-1 * s, which are p and s without a preconditioner
+    const Vector & p_hat = (M_ ? p_work : p), & s_hat = (M_ ? s_work : s);
+
+    double sums[3];
+    residual(A_, x, b, r);
+    sums[1] = criterion.accumulate(r.data(), r.size());
+    sums[0] = dot(r, r);
+    reduceNorm(sums, 2, criterion);
+
+    // rho_next is r_hat^T * r
+    double rho = 1.0, alpha = 1.0, omega = 1.0;
+    double rho_next = sums[0], resid = criterion.finish(sums[1]);
+    monitor.check(resid);
+    r_hat = r;
+
+    for (size_t i_it = 0; i_it < max_it && monitor.status() == Convergence::ITERATING; i_it++) {
+
+        // r_hat has become orthogonal to r. The iterations start over
+        // with r_hat = r.
+        //
+        if (rho_next == 0.0) {
+            r_hat = r;
+            rho_next = dot(r, r);
+            reduce(&rho_next, 1);
+
+            p.fill(0.0);
+            v.fill(0.0);
+            rho = alpha = omega = 1.0;
+        }
+
+        // p = r + beta * (p - omega * v)
+        double beta = (rho_next / rho) * (alpha / omega);
+        axpy(-omega, v, p);
+        xpay(r, beta, p);
+        rho = rho_next;
+
+        if (M_) M_->apply(p, p_work);
+        A_.multiply(p_hat, v);
+        double rv = dot(r_hat, v);
+        reduce(&rv, 1);
+
+        if (rv == 0.0) {
+            throw runtime_error("Error: BiCGSTAB breaks down.");
+        }
+
+        // s = r - alpha * v, which is kept in r
+        alpha = rho / rv;
+        axpy(-alpha, v, r);
+        s.swap(r);
+
+        if (M_) M_->apply(s, s_work);
+        A_.multiply(s_hat, t);
+        sums[0] = dot(t, s);
+        sums[1] = dot(t, t);
+        sums[2] = criterion.accumulate(s.data(), s.size());
+        reduceNorm(sums, 3, criterion);
+
+        if (criterion.finish(sums[2]) <= monitor.threshold() || sums[1] == 0.0) {
+            axpy(alpha, p_hat, x);
+            s.swap(r);
+            resid = criterion.finish(sums[2]);
+            printIteration(verbose, i_it + 1, resid);
+            monitor.check(resid);
+            break;
+        }
+
+        omega = sums[0] / sums[1];
+        if (omega == 0.0) {
+            throw runtime_error("Error: BiCGSTAB breaks down.");
+        }
+
+        // x = x + alpha * p_hat + omega * s_hat and r = s - omega * t
+        axpy(alpha, p_hat, x);
+        axpy(omega, s_hat, x);
+        axpy(-omega, t, s);
+        r.swap(s);
+
+        sums[0] = dot(r_hat, r);
+        sums[1] = criterion.accumulate(r.data(), r.size());
+        reduceNorm(sums, 2, criterion);
+        rho_next = sums[0];
+        resid = criterion.finish(sums[1]);
+
+        printIteration(verbose, i_it + 1, resid);
+        monitor.check(resid);
+    }
+
+    return (resid);
+}
+
+double
+Krylov::solveGMRES(const Vector & b, Vector & x, size_t max_it,
+        const Convergence & criterion, ConvergenceMonitor & monitor,
+        int verbose) const {
+
+    size_t n = x.size(), m = restart_;
+
+    // The L1 norm is at most sqrt(N) times the L2 norm, and the L-inf norm
+    // is at most the L2 norm
+    //
+    double bound = 1.0;
+    if (criterion.norm() == Convergence::L1) {
+        double n_total = n;
+        reduce(&n_total, 1);
+        bound = sqrt(n_total);
+    }
+
+    // The orthonormal basis V of the Krylov subspace, the Hessenberg matrix
+    // H = V^T * A * V that is reduced to an upper triangular matrix by the
+    // Givens rotations (c, s), and the rotated right-hand side g
+    //
+    vector<Vector> V(m + 1, Vector(n));
+    Matrix H(m + 1, m);
+    vector<double> c(m), s(m), g(m + 1), h(m + 1), y(m);
+
+    // The work space of the preconditioner
+    Vector r, u, z;
+    if (M_) u.resize(n);
+
+    double sums[2];
+    residual(A_, x, b, r);
+    sums[1] = criterion.accumulate(r.data(), r.size());
+    sums[0] = dot(r, r);
+    reduceNorm(sums, 2, criterion);
+
+    double resid = criterion.finish(sums[1]), beta = sqrt(sums[0]);
+    monitor.check(resid);
+    size_t i_it = 0;
+
+    while (i_it < max_it && monitor.status() == Convergence::ITERATING) {
+
+        // A residual that is 0 in the L2 norm, e.g. of an exact guess or
+        // when its squares underflow, can't start a basis. It is taken as
+        // converged.
+        //
+        if (beta == 0.0) {
+            monitor.check(0.0);
+            break;
+        }
+
+        scale(1.0 / beta, r, V[0]);
+        fill(g.begin(), g.end(), 0.0);
+        g[0] = beta;
+
+        size_t k = 0;
+        while (k < m && i_it < max_it) {
+            Vector & w = V[k + 1];
+            if (M_) {
+                M_->apply(V[k], z);
+                A_.multiply(z, w);
+            } else {
+                A_.multiply(V[k], w);
+            }
+
+            // Classical Gram-Schmidt is repeated once so that w stays
+            // orthogonal. Each pass needs only one reduction.
+            //
+            for (int pass = 0; pass < 2; pass++) {
+                for (size_t i = 0; i <= k; i++) h[i] = dot(V[i], w);
+                reduce(h.data(), k + 1);
+
+                for (size_t i = 0; i <= k; i++) {
+                    axpy(-h[i], V[i], w);
+                    H[i][k] = (pass == 0 ? h[i] : H[i][k] + h[i]);
+                }
+            }
+
+            double w_norm = dot(w, w);
+            reduce(&w_norm, 1);
+            w_norm = sqrt(w_norm);
+            if (w_norm > 0.0) scale(1.0 / w_norm, w, w);
+            H[k + 1][k] = w_norm;
+
+            // Apply the previous rotations to the new column, and eliminate
+            // its last value with a new rotation
+            //
+            for (size_t i = 0; i < k; i++) {
+                double top = c[i] * H[i][k] + s[i] * H[i + 1][k];
+                H[i + 1][k] = -s[i] * H[i][k] + c[i] * H[i + 1][k];
+                H[i][k] = top;
+            }
+
+            double diag = hypot(H[k][k], H[k + 1][k]);
+            if (diag == 0.0) {
+                throw runtime_error("Error: The matrix is singular. GMRES breaks down.");
+            }
+
+            c[k] = H[k][k] / diag;
+            s[k] = H[k + 1][k] / diag;
+            H[k][k] = diag;
+            H[k + 1][k] = 0.0;
+            g[k + 1] = -s[k] * g[k];
+            g[k] = c[k] * g[k];
+
+            k++;
+            i_it++;
+
+            // |g(k)| is the L2 norm of the residual
+            double estimate = bound * abs(g[k]);
+            printIteration(verbose, i_it, estimate);
+
+            if (estimate <= monitor.threshold() || w_norm == 0.0) break;
+        }
+
+        // Solve the upper triangular system H * y = g and update
+        // x = x + M^-1 * V * y
+        //
+        for (size_t i = k; i-- > 0;) {
+            double sum = g[i];
+            for (size_t j = i + 1; j < k; j++) sum -= H[i][j] * y[j];
+            y[i] = sum / H[i][i];
+        }
+
+        if (M_) {
+            u.fill(0.0);
+            for (size_t i = 0; i < k; i++) axpy(y[i], V[i], u);
+            M_->apply(u, z);
+            axpy(1.0, z, x);
+        } else {
+            for (size_t i = 0; i < k; i++) axpy(y[i], V[i], x);
+        }
+
+        residual(A_, x, b, r);
+        sums[1] = criterion.accumulate(r.data(), r.size());
+        sums[0] = dot(r, r);
+        reduceNorm(sums, 2, criterion);
+        resid = criterion.finish(sums[1]);
+        beta = sqrt(sums[0]);
+        monitor.check(resid);
+    }
+
+    return (resid);
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Krylov.h
+ * Author: Weiming Hu
+ *
+ * Created on October 22, 2026, 2:15 PM
+ */
+
+#ifndef KRYLOV_H
+#define KRYLOV_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+#include "Preconditioner.h"
+#include "Convergence.h"
+
+#include <string>
+
+// The default number of iterations between the restarts of GMRES
+#ifndef KRYLOV_RESTART
+#define KRYLOV_RESTART 30
+#endif
+
+// Krylov subspace methods
+//
+// CG is for symmetric positive definite systems. BiCGSTAB and the
+// restarted GMRES(m) are for nonsymmetric systems. Unlike the Jacobi and
+// Gauss-Seidel Methods, none of them needs A to be diagonally dominant.
+// They only use the products with A, so A can be dense or sparse.
+//
+// With a preconditioner M, CG iterates on M^-1 * A, which needs M to be
+// symmetric positive definite as well, and BiCGSTAB and GMRES iterate on
+// A * M^-1. The residuals that are checked are always those of Ax = b.
+//
+// The inner products and norms of an iteration are added up together, so
+// that they can be reduced with one call when the vectors are distributed.
+// A subclass only needs to override reduce().
+//
+class Krylov {
+public:
+
+    enum Method {
+        CG,
+        BICGSTAB,
+        GMRES
+    };
+
+    // restart is only used by GMRES
+    Krylov(const LinearOperator & A, Method method,
+            std::size_t restart = KRYLOV_RESTART);
+    virtual ~Krylov();
+
+    // Iterate until the L1 norm of the residual is not larger than
+    // small_resid or max_it is reached. x is the initial guess and the
+    // solution afterwards. The L1 norm of the final residual is returned.
+    //
+    // GMRES checks an upper bound of the L1 norm of the residual, which is
+    // sqrt(N) times its L2 norm, within a restart cycle.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            double small_resid, int verbose = 0) const;
+
+    // Iterate until the criterion stops. The norm of the criterion of the
+    // final residual is returned. The bound of GMRES is the L2 norm for
+    // the L2 and L-inf norms.
+    //
+    double solve(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, int verbose = 0) const;
+
+    // The status of the last solve
+    Convergence::Status status() const;
+
+    Method method() const;
+    std::size_t restart() const;
+
+    // The preconditioner is not owned. nullptr means no preconditioner,
+    // which is the default.
+    //
+    void setPreconditioner(const Preconditioner * M);
+    const Preconditioner * preconditioner() const;
+
+    // The name of a method, and the method of a name, which is case
+    // insensitive. An exception is thrown for an unknown name.
+    //
+    static std::string name(Method method);
+    static Method method(const std::string & name);
+
+protected:
+
+    // Add up the values over all parts of the vectors. The vectors are not
+    // distributed by default, so nothing is done.
+    //
+    virtual void reduce(double * values, std::size_t count) const;
+
+    // Take the largest values over all parts, e.g. for the L-inf norm
+    virtual void reduceMax(double * values, std::size_t count) const;
+
+private:
+    const LinearOperator & A_;
+    Method method_;
+    std::size_t restart_;
+    const Preconditioner * M_ = nullptr;
+    mutable Convergence::Status status_ = Convergence::ITERATING;
+
+    // Reduce the partial sums, whose last value is the partial norm of the
+    // criterion
+    //
+    void reduceNorm(double * values, std::size_t count,
+            const Convergence & criterion) const;
+
+    double solveCG(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, ConvergenceMonitor & monitor,
+            int verbose) const;
+    double solveBiCGSTAB(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, ConvergenceMonitor & monitor,
+            int verbose) const;
+    double solveGMRES(const Vector & b, Vector & x, std::size_t max_it,
+            const Convergence & criterion, ConvergenceMonitor & monitor,
+            int verbose) const;
+};
+
+#endif /* KRYLOV_H */
@@ -0,0 +1,47 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   LinearOperator.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 24, 2026, 9:40 AM
+ */
+
+#include "LinearOperator.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+void
+LinearOperator::multiplyRows(size_t begin, size_t end,
+        const double * x, double * y) const {
+    for (size_t i = begin; i < end; i++) y[i] = rowProduct(i, x);
+}
+
+size_t
+LinearOperator::rowAlignment() const {
+    return (1);
+}
+
+bool
+LinearOperator::rowPattern(size_t, vector<size_t> &) const {
+    return (false);
+}
+
+void
+LinearOperator::multiplyBlock(const Matrix & X, Matrix & Y) const {
+    if (X.nrows() != ncols()) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    Y.resize(nrows(), X.ncols());
+    Vector x(X.nrows()), y(nrows());
+
+    for (size_t j = 0; j < X.ncols(); j++) {
+        for (size_t i = 0; i < X.nrows(); i++) x[i] = X[i][j];
+        multiply(x, y);
+        for (size_t i = 0; i < y.size(); i++) Y[i][j] = y[i];
+    }
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   LinearOperator.h
+ * Author: Weiming Hu
+ *
+ * Created on October 20, 2026, 9:30 AM
+ */
+
+#ifndef LINEAROPERATOR_H
+#define LINEAROPERATOR_H
+
+#include <cstddef>
+#include <vector>
+#include <iostream>
+
+class Vector;
+class Matrix;
+
+// The interface of a matrix for the iterative solvers
+//
+// The solvers only need the products with A, the products of single rows
+// for the Gauss-Seidel sweeps, and the diagonal. Matrix and SparseMatrix
+// both implement it, so the same solvers work on dense and sparse systems.
+//
+class LinearOperator {
+public:
+    virtual ~LinearOperator() {
+    }
+
+    virtual std::size_t nrows() const = 0;
+    virtual std::size_t ncols() const = 0;
+
+    // y = A * x. y is resized when it does not have nrows() values.
+    virtual void multiply(const Vector & x, Vector & y) const = 0;
+
+    // Y = A * X for the ncols(X) columns of X, e.g. a batch of solutions.
+    // Y is resized to nrows() x ncols(X). The default multiplies the
+    // columns one at a time.
+    //
+    virtual void multiplyBlock(const Matrix & X, Matrix & Y) const;
+
+    // The product of row i and x, where x points to ncols() values
+    virtual double rowProduct(std::size_t i, const double * x) const = 0;
+
+    // y[i] = A(i, :) * x for begin <= i < end on the calling thread, e.g.
+    // for the rows that a thread owns. y points to nrows() values. The
+    // default uses rowProduct().
+    //
+    virtual void multiplyRows(std::size_t begin, std::size_t end,
+            const double * x, double * y) const;
+
+    // multiplyRows() is the fastest for ranges that start and end at
+    // multiples of the alignment, or at nrows()
+    //
+    virtual std::size_t rowAlignment() const;
+
+    // The columns of the values of row i that are stored, e.g. for the
+    // coloring of the Gauss-Seidel sweeps. The default returns false,
+    // which means that every value can be nonzero.
+    //
+    virtual bool rowPattern(std::size_t i, std::vector<std::size_t> & cols) const;
+
+    // The value a_ii
+    virtual double diagonal(std::size_t i) const = 0;
+
+    // Check whether the matrix is diagonally dominant
+    virtual bool checkDominant() const = 0;
+
+    virtual void print(std::ostream &) const = 0;
+};
+
+#endif /* LINEAROPERATOR_H */
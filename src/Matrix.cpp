@@ -7,16 +7,30 @@
  */
 
 #include "Matrix.h"
+#include "Vector.h"
+#include "Factorization.h"
+#include "CsvParser.h"
 
+#include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <fstream>
 #include <cmath>
 #include <sstream>
 #include <vector>
+#include <limits>
 #include <numeric>
 #include <iomanip>
+#include <utility>
 #include <algorithm>
 
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #ifdef _PROFILE_TIME
 #include <ctime>
 #endif
@@ -25,15 +39,73 @@
 #include <omp.h>
 #endif
 
+#ifdef _USE_NETCDF
+#include <netcdf.h>
+#endif
+
 using namespace std;
 static const double _ZERO_LIMIT = 1.0e-9;
 
+// Binary matrix file
+static const char _FILE_MAGIC[8] = {'C', 'S', 'E', 'M', 'A', 'T', 'R', 'X'};
+static const uint32_t _FILE_VERSION = 1;
+static const uint32_t _FILE_BYTE_ORDER = 0x01020304;
+static const uint32_t _FILE_DTYPE_FLOAT64 = 1;
+static const uint32_t _FILE_DTYPE_FLOAT32 = 2;
+static const uint32_t _FILE_LAYOUT_ROW_MAJOR = 0;
+static const uint32_t _FILE_LAYOUT_COLUMN_MAJOR = 1;
+
+struct MatrixFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t dtype;
+    uint32_t layout;
+    uint64_t nrows;
+    uint64_t ncols;
+    uint64_t data_offset;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+static_assert(sizeof (MatrixFileHeader) == 64, "The file header should have 64 bytes.");
+
+// Check the values of a header, which can be corrupt, before they are
+// read. The values should start after the header at an offset that is
+// aligned for their type, and nrows * ncols values should fit into the
+// rest of the file without an overflow.
+//
+static bool
+validDataRange(const MatrixFileHeader & header, size_t value_size,
+        size_t value_align, size_t file_size) {
+
+    if (header.data_offset < sizeof (header) || header.data_offset > file_size ||
+            header.data_offset % value_align != 0) {
+        return (false);
+    }
+
+    size_t available = (file_size - header.data_offset) / value_size;
+    return (header.ncols == 0 || header.nrows <= available / header.ncols);
+}
+
 void deleteContinuousMatrix(struct continuousMatrix *cm) {
     free(cm->data);
     free(cm);
     return;
 }
 
+double *
+allocateAligned(size_t length) {
+    if (length == 0) return (nullptr);
+
+    void *p = nullptr;
+    if (posix_memalign(&p, MATRIX_ALIGNMENT, length * sizeof(double)) != 0) {
+        throw runtime_error("Error: Failed to allocate memory for the matrix.");
+    }
+
+    return (static_cast<double *> (p));
+}
+
 Matrix::Matrix() {
 }
 
@@ -49,19 +121,64 @@ Matrix::Matrix(const Matrix& orig) {
     *this = orig;
 }
 
+Matrix::Matrix(Matrix && orig) noexcept {
+    *this = std::move(orig);
+}
+
 Matrix::~Matrix() {
-    resize(0, 0);
+    release();
+}
+
+void
+Matrix::release() {
+    if (map_base_) {
+        munmap(map_base_, map_length_);
+        map_base_ = nullptr;
+        map_length_ = 0;
+    } else {
+        free(data_);
+    }
+
+    data_ = nullptr;
+    capacity_ = 0;
 }
 
 void
 Matrix::resize(size_t nrows, size_t ncols) {
-    vector< vector<double> >::resize(nrows);
-    for (auto & row : * this) {
-        row.resize(ncols, 0);
+    if (nrows == nrows_ && ncols == ncols_) return;
+
+    size_t length = nrows * ncols;
+    double *data = allocateAligned(length);
+
+    // The rows are zeroed with a static schedule so that the pages of a
+    // large matrix are first touched by the threads that work on these rows
+    // in the row-parallel loops, and placed on their NUMA nodes. The
+    // threads are those of the execution context, like in the kernels.
+    //
+    long nrows_fill = nrows;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(length);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(data, nrows_fill, ncols)
+#endif
+    for (long i = 0; i < nrows_fill; i++) {
+        fill(data + i * ncols, data + (i + 1) * ncols, 0.0);
     }
 
+    // Keep the values in the overlapping region
+    size_t nrows_keep = min(nrows, nrows_), ncols_keep = min(ncols, ncols_);
+    for (size_t i = 0; i < nrows_keep; i++) {
+        copy(data_ + i * stride_, data_ + i * stride_ + ncols_keep,
+                data + i * ncols);
+    }
+
+    release();
+    data_ = data;
+    capacity_ = length;
     nrows_ = nrows;
     ncols_ = ncols;
+    stride_ = ncols;
 }
 
 size_t
@@ -74,12 +191,47 @@ Matrix::ncols() const {
     return (ncols_);
 }
 
+size_t
+Matrix::stride() const {
+    return (stride_);
+}
+
+double *
+Matrix::data() {
+    return (data_);
+}
+
+const double *
+Matrix::data() const {
+    return (data_);
+}
+
+Matrix::RowView
+Matrix::row(size_t i) {
+    return (RowView(data_ + i * stride_, ncols_, 1));
+}
+
+Matrix::ConstRowView
+Matrix::row(size_t i) const {
+    return (ConstRowView(data_ + i * stride_, ncols_, 1));
+}
+
+Matrix::ColumnView
+Matrix::col(size_t j) {
+    return (ColumnView(data_ + j, nrows_, stride_));
+}
+
+Matrix::ConstColumnView
+Matrix::col(size_t j) const {
+    return (ConstColumnView(data_ + j, nrows_, stride_));
+}
+
 bool
 Matrix::checkDominant() const {
     double sum;
 
     for (size_t i = 0; i < nrows_; i++) {
-        sum = accumulate((*this)[i].begin(), (*this)[i].end(), 0.0, [](
+        sum = accumulate((*this)[i], (*this)[i] + ncols_, 0.0, [](
                 double lhs, double rhs) {
             return (abs(lhs) + abs(rhs));
         });
@@ -90,49 +242,523 @@ Matrix::checkDominant() const {
     return (true);
 }
 
+void
+Matrix::multiply(const Vector & x, Vector & y) const {
+    if (x.size() != ncols_) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    y.resize(nrows_);
+
+    const double *px = x.data();
+    long nrows = nrows_;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(px, y, nrows)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        y[i] = Matrix::rowProduct(i, px);
+    }
+}
+
+void
+Matrix::multiplyBlock(const Matrix & X, Matrix & Y) const {
+    if (X.nrows() != ncols_) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    Y.resize(nrows_, X.ncols());
+    gemm(nrows_, X.ncols(), ncols_, 1.0, data_, stride_,
+            X.data(), X.stride(), 0.0, Y.data(), Y.stride());
+}
+
+double
+Matrix::rowProduct(size_t i, const double * x) const {
+    const double *a = (*this)[i];
+    size_t n = ncols_;
+    double sum = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+    for (size_t j = 0; j < n; j++) {
+        sum += a[j] * x[j];
+    }
+
+    return (sum);
+}
+
+double
+Matrix::diagonal(size_t i) const {
+    return ((*this)[i][i]);
+}
+
+bool
+Matrix::isMapped() const {
+    return (map_base_ != nullptr);
+}
+
 bool
 Matrix::readMatrix(const std::string & csv_file) {
-    ifstream file;
-    file.open(csv_file);
+    string nc_file, var_name;
+    if (netcdfVariable(csv_file, nc_file, var_name)) {
+        return (readNetCDF(nc_file, var_name));
+    }
 
-    if (!file.is_open()) {
+    int fd = open(csv_file.c_str(), O_RDONLY);
+    if (fd < 0) {
         throw runtime_error("File can't be opened.");
     }
 
-    char comma;
-    string buffer;
-    double tmp_val;
-    size_t nrows = 0;
-    vector<double> tmp_vec;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw runtime_error("Error: The file is empty.");
+    }
 
-    while (!file.eof()) {
-        getline(file, buffer);
+    size_t length = file_stat.st_size;
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
 
-        if (!buffer.empty()) {
-            istringstream iss(buffer);
-            while (!iss.eof()) {
-                iss >> tmp_val;
-                tmp_vec.push_back(tmp_val);
-                iss >> comma;
-            }
-            nrows++;
+    if (base == MAP_FAILED) {
+        throw runtime_error("Error: The file can't be mapped.");
+    }
+
+    const char *text = static_cast<const char *> (base);
+
+    // Check whether this is a binary matrix file
+    if (length >= sizeof (_FILE_MAGIC) &&
+            memcmp(text, _FILE_MAGIC, sizeof (_FILE_MAGIC)) == 0) {
+        munmap(base, length);
+        return (readBinary(csv_file));
+    }
+
+    // The file is split into chunks of lines. Each chunk owns the
+    // lines that start within its range of bytes.
+    //
+    size_t nchunks = 1;
+    int nthreads = ExecutionContext::current().threads(length);
+    if (nthreads > 1) nchunks = 4 * nthreads;
+
+    vector<size_t> chunk_begin(nchunks + 1), chunk_rows(nchunks + 1, 0);
+    for (size_t c = 0; c < nchunks; c++) {
+        chunk_begin[c] = lineStart(text, length, c * length / nchunks);
+    }
+    chunk_begin[nchunks] = length;
+
+    // The first pass counts the rows so that the storage is allocated once
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(dynamic) \
+shared(nchunks, chunk_begin, chunk_rows, text, length)
+#endif
+    for (size_t c = 0; c < nchunks; c++) {
+        size_t pos = chunk_begin[c], count = 0;
+        while (pos < chunk_begin[c + 1]) {
+            const char *eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+            size_t next = (eol ? eol - text + 1 : length);
+            if (!isEmptyLine(text + pos, text + (eol ? eol - text : length))) count++;
+            pos = next;
         }
+        chunk_rows[c + 1] = count;
     }
 
-    size_t ncols = tmp_vec.size() / nrows;
-    this->resize(nrows, ncols);
+    // Offsets of the first row of each chunk
+    for (size_t c = 0; c < nchunks; c++) chunk_rows[c + 1] += chunk_rows[c];
+    size_t nrows = chunk_rows[nchunks];
+
+    // The number of columns is decided by the first row
+    size_t ncols = 0, pos = 0;
+    while (pos < length && ncols == 0) {
+        const char *eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+        const char *line_end = (eol ? eol : text + length);
+        if (!isEmptyLine(text + pos, line_end) &&
+                !parseLine(text + pos, line_end, nullptr, 0, ncols)) {
+            munmap(base, length);
+            throw runtime_error("Error: The first row of the csv file can't be parsed.");
+        }
+        pos = line_end - text + 1;
+    }
+
+    if (nrows == 0 || ncols == 0) {
+        munmap(base, length);
+        throw runtime_error("Error: The file is empty.");
+    }
+
+    release();
+    nrows_ = 0;
+    ncols_ = 0;
+    resize(nrows, ncols);
+
+    // The second pass parses values directly into the storage. Errors
+    // are recorded and reported after the parallel region.
+    //
+    size_t bad_row = nrows, bad_count = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(dynamic) \
+shared(nchunks, chunk_begin, chunk_rows, text, length, ncols, nrows, bad_row, bad_count)
+#endif
+    for (size_t c = 0; c < nchunks; c++) {
+        size_t pos = chunk_begin[c], i_row = chunk_rows[c], count = 0;
+        while (pos < chunk_begin[c + 1]) {
+            const char *eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+            const char *line_end = (eol ? eol : text + length);
+
+            if (!isEmptyLine(text + pos, line_end)) {
+                bool ok = parseLine(text + pos, line_end, (*this)[i_row], ncols, count);
 
+                if (!ok || count != ncols) {
 #if defined(_OPENMP)
-#pragma omp parallel for default(none) schedule(static) collapse(2) \
-shared(nrows, ncols, tmp_vec)
+#pragma omp critical
 #endif
+                    {
+                        if (i_row < bad_row) {
+                            bad_row = i_row;
+                            bad_count = (ok ? count : 0);
+                        }
+                    }
+                    break;
+                }
+                i_row++;
+            }
+
+            pos = line_end - text + 1;
+        }
+    }
+
+    munmap(base, length);
+
+    if (bad_row != nrows) {
+        ostringstream message;
+        message << "Error: Row " << bad_row << " of the csv file ";
+        if (bad_count == 0) message << "can't be parsed.";
+        else message << "has " << bad_count << " values but " << ncols << " are expected.";
+        throw runtime_error(message.str());
+    }
+
+    return (true);
+}
+
+bool
+Matrix::readBinary(const std::string & bin_file, bool verify_checksum) {
+    int fd = open(bin_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    struct stat file_stat;
+    MatrixFileHeader header;
+
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof (header) ||
+            pread(fd, &header, sizeof (header), 0) != sizeof (header)) {
+        close(fd);
+        throw runtime_error("Error: The binary matrix file is too short.");
+    }
+
+    if (memcmp(header.magic, _FILE_MAGIC, sizeof (_FILE_MAGIC)) != 0 ||
+            header.version != _FILE_VERSION) {
+        close(fd);
+        throw runtime_error("Error: The file is not a binary matrix file of a supported version.");
+    }
+
+    if (header.byte_order != _FILE_BYTE_ORDER) {
+        close(fd);
+        throw runtime_error("Error: The binary matrix file has a different byte order.");
+    }
+
+    if ((header.dtype != _FILE_DTYPE_FLOAT64 && header.dtype != _FILE_DTYPE_FLOAT32) ||
+            (header.layout != _FILE_LAYOUT_ROW_MAJOR && header.layout != _FILE_LAYOUT_COLUMN_MAJOR)) {
+        close(fd);
+        throw runtime_error("Error: Unknown data type or layout in the binary matrix file.");
+    }
+
+    bool float64 = (header.dtype == _FILE_DTYPE_FLOAT64);
+    size_t value_size = (float64 ? sizeof (double) : sizeof (float));
+
+    if (!validDataRange(header, value_size, float64 ? alignof (double) : alignof (float),
+            file_stat.st_size)) {
+        close(fd);
+        throw runtime_error("Error: The binary matrix file is truncated or its data offset is not valid.");
+    }
+
+    size_t nrows = header.nrows, ncols = header.ncols, length = nrows * ncols;
+    size_t nbytes = length * value_size;
+
+    if (header.dtype == _FILE_DTYPE_FLOAT64 && header.layout == _FILE_LAYOUT_ROW_MAJOR && length > 0) {
+
+        // Map the file. Pages are only copied when they are modified.
+        void *base = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (base == MAP_FAILED) {
+            throw runtime_error("Error: The binary matrix file can't be mapped.");
+        }
+
+        // The matrix is only replaced by a mapping that is verified
+        const char *values = static_cast<char *> (base) + header.data_offset;
+        if (verify_checksum && checksum(values, nbytes) != header.checksum) {
+            munmap(base, file_stat.st_size);
+            throw runtime_error("Error: The checksum of the binary matrix file does not match.");
+        }
+
+        release();
+        map_base_ = base;
+        map_length_ = file_stat.st_size;
+        data_ = reinterpret_cast<double *> (static_cast<char *> (base) + header.data_offset);
+        capacity_ = length;
+        nrows_ = nrows;
+        ncols_ = ncols;
+        stride_ = ncols;
+
+        return (true);
+    }
+
+    // Other data types and layouts are converted
+    vector<char> buffer(nbytes);
+    size_t nread = 0;
+    while (nread < nbytes) {
+        ssize_t ret = pread(fd, buffer.data() + nread, nbytes - nread, header.data_offset + nread);
+        if (ret <= 0) {
+            close(fd);
+            throw runtime_error("Error: Failed to read the binary matrix file.");
+        }
+        nread += ret;
+    }
+    close(fd);
+
+    if (verify_checksum && checksum(buffer.data(), nbytes) != header.checksum) {
+        throw runtime_error("Error: The checksum of the binary matrix file does not match.");
+    }
+
+    release();
+    nrows_ = 0;
+    ncols_ = 0;
+    resize(nrows, ncols);
+
     for (size_t i = 0; i < nrows; i++) {
         for (size_t j = 0; j < ncols; j++) {
-            (*this)[i][j] = tmp_vec[i * ncols + j];
+            size_t index = (header.layout == _FILE_LAYOUT_ROW_MAJOR ? i * ncols + j : j * nrows + i);
+
+            if (header.dtype == _FILE_DTYPE_FLOAT64) {
+                double value;
+                memcpy(&value, buffer.data() + index * sizeof (double), sizeof (double));
+                (*this)[i][j] = value;
+            } else {
+                float value;
+                memcpy(&value, buffer.data() + index * sizeof (float), sizeof (float));
+                (*this)[i][j] = value;
+            }
+        }
+    }
+
+    return (true);
+}
+
+bool
+Matrix::writeMatrix(const std::string & csv_file) const {
+    string nc_file, var_name;
+    if (netcdfVariable(csv_file, nc_file, var_name)) {
+        return (writeNetCDF(nc_file, var_name));
+    }
+
+    ofstream file(csv_file, ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    // Each line is formatted separately, which is faster than the stream
+    // operators for large matrices
+    //
+    const int digits = numeric_limits<double>::max_digits10;
+    string line;
+    char value[32];
+
+    for (size_t i = 0; i < nrows_; i++) {
+        line.clear();
+        for (size_t j = 0; j < ncols_; j++) {
+            int length = snprintf(value, sizeof (value), "%.*g", digits, (*this)[i][j]);
+            if (j > 0) line += ',';
+            line.append(value, length);
+        }
+        line += '\n';
+        file.write(line.data(), line.size());
+    }
+
+    if (!file.good()) {
+        throw runtime_error("Error: Failed to write the csv matrix file.");
+    }
+
+    return (true);
+}
+
+bool
+Matrix::writeBinary(const std::string & bin_file) const {
+    ofstream file(bin_file, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    MatrixFileHeader header;
+    memset(&header, 0, sizeof (header));
+    memcpy(header.magic, _FILE_MAGIC, sizeof (_FILE_MAGIC));
+    header.version = _FILE_VERSION;
+    header.byte_order = _FILE_BYTE_ORDER;
+    header.dtype = _FILE_DTYPE_FLOAT64;
+    header.layout = _FILE_LAYOUT_ROW_MAJOR;
+    header.nrows = nrows_;
+    header.ncols = ncols_;
+    header.data_offset = sizeof (header);
+
+    header.checksum = checksum(nullptr, 0);
+    for (size_t i = 0; i < nrows_; i++) {
+        header.checksum = checksum((*this)[i], ncols_ * sizeof (double), header.checksum);
+    }
+
+    file.write(reinterpret_cast<const char *> (&header), sizeof (header));
+    for (size_t i = 0; i < nrows_; i++) {
+        file.write(reinterpret_cast<const char *> ((*this)[i]), ncols_ * sizeof (double));
+    }
+
+    if (!file.good()) {
+        throw runtime_error("Error: Failed to write the binary matrix file.");
+    }
+
+    return (true);
+}
+
+bool
+Matrix::readNetCDF(const std::string & nc_file, const std::string & var_name) {
+#ifdef _USE_NETCDF
+    int ncid = -1, varid = -1, ndims = -1;
+    int dimids[NC_MAX_VAR_DIMS];
+    size_t dimlens[2] = {1, 1};
+
+    checkNetCDF(nc_open(nc_file.c_str(), NC_NOWRITE, &ncid));
+
+    try {
+        checkNetCDF(nc_inq_varid(ncid, var_name.c_str(), &varid));
+        checkNetCDF(nc_inq_varndims(ncid, varid, &ndims));
+
+        if (ndims != 1 && ndims != 2) {
+            throw runtime_error("Error: Only 1- or 2-dimensional variables can be read as a matrix.");
+        }
+
+        checkNetCDF(nc_inq_vardimid(ncid, varid, dimids));
+        for (int i = 0; i < ndims; i++) {
+            checkNetCDF(nc_inq_dimlen(ncid, dimids[i], dimlens + i));
+        }
+
+        size_t nrows = (ndims == 1 ? dimlens[0] : dimlens[1]);
+        size_t ncols = (ndims == 1 ? 1 : dimlens[0]);
+        resize(nrows, ncols);
+
+        // A block of columns is read into the buffer and transposed into
+        // the rows. A 1-dimensional variable only uses the last dimension
+        // of start and count.
+        //
+        size_t block = max((size_t) 1, (size_t) NETCDF_CHUNK_VALUES / max(nrows, (size_t) 1));
+        vector<double> buffer(min(block, ncols) * nrows);
+
+        for (size_t c0 = 0; c0 < ncols && nrows > 0; c0 += block) {
+            size_t start[2] = {c0, 0}, count[2] = {min(block, ncols - c0), nrows};
+            checkNetCDF(nc_get_vara_double(ncid, varid, start + 2 - ndims,
+                    count + 2 - ndims, buffer.data()));
+
+            for (size_t j = 0; j < count[0]; j++) {
+                for (size_t i = 0; i < nrows; i++) {
+                    (*this)[i][c0 + j] = buffer[j * nrows + i];
+                }
+            }
+        }
+
+    } catch (...) {
+        nc_close(ncid);
+        throw;
+    }
+
+    checkNetCDF(nc_close(ncid));
+    return (true);
+#else
+    (void) nc_file;
+    (void) var_name;
+    throw runtime_error("Error: The program is not built with NetCDF.");
+#endif
+}
+
+bool
+Matrix::writeNetCDF(const std::string & nc_file, const std::string & var_name,
+        int deflate_level) const {
+#ifdef _USE_NETCDF
+    if (deflate_level < 0 || deflate_level > 9) {
+        throw runtime_error("Error: The deflate level should be from 0 to 9.");
+    }
+
+    int ncid = -1, varid = -1, ndims = (ncols_ == 1 ? 1 : 2);
+    int dimids[2] = {-1, -1};
+
+    checkNetCDF(nc_create(nc_file.c_str(), NC_CLOBBER | NC_NETCDF4, &ncid));
+
+    try {
+
+        // The dimensions are named as in data/ncdf4/generate_test.R, where
+        // both dimensions of a square matrix are the size
+        //
+        checkNetCDF(nc_def_dim(ncid, "size", nrows_, dimids + 1));
+        if (ndims == 1 || ncols_ == nrows_) {
+            dimids[0] = dimids[1];
+        } else {
+            checkNetCDF(nc_def_dim(ncid, "column", ncols_, dimids));
+        }
+
+        checkNetCDF(nc_def_var(ncid, var_name.c_str(), NC_DOUBLE, ndims,
+                dimids + 2 - ndims, &varid));
+
+        // Every chunk holds whole columns, which are also the blocks that
+        // are written
+        //
+        size_t block = max((size_t) 1, (size_t) NETCDF_CHUNK_VALUES / max(nrows_, (size_t) 1));
+        block = min(block, ncols_);
+
+        if (nrows_ > 0 && ncols_ > 0) {
+            size_t chunks[2] = {block, nrows_};
+            checkNetCDF(nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks + 2 - ndims));
+            if (deflate_level > 0) {
+                checkNetCDF(nc_def_var_deflate(ncid, varid, 1, 1, deflate_level));
+            }
+        }
+
+        checkNetCDF(nc_enddef(ncid));
+
+        vector<double> buffer(block * nrows_);
+        for (size_t c0 = 0; c0 < ncols_ && nrows_ > 0; c0 += block) {
+            size_t start[2] = {c0, 0}, count[2] = {min(block, ncols_ - c0), nrows_};
+
+            for (size_t j = 0; j < count[0]; j++) {
+                for (size_t i = 0; i < nrows_; i++) {
+                    buffer[j * nrows_ + i] = (*this)[i][c0 + j];
+                }
+            }
+
+            checkNetCDF(nc_put_vara_double(ncid, varid, start + 2 - ndims,
+                    count + 2 - ndims, buffer.data()));
         }
+
+    } catch (...) {
+        nc_close(ncid);
+        throw;
     }
 
+    checkNetCDF(nc_close(ncid));
     return (true);
+#else
+    (void) nc_file;
+    (void) var_name;
+    (void) deflate_level;
+    throw runtime_error("Error: The program is not built with NetCDF.");
+#endif
 }
 
 Matrix
@@ -142,7 +768,7 @@ Matrix::inverse() {
         throw runtime_error("Matrix should be square!");
     
     size_t nsize = nrows_;
-    Matrix mat_inv(nsize), mat(*this);
+    Matrix mat_inv(nsize);
     
     // Initialize the inverse matrix to an identity matrix
     for (size_t i = 0; i < nsize; i++) {
@@ -153,86 +779,30 @@ Matrix::inverse() {
     clock_t time_start = clock();
 #endif
     
-    // Use Gaussian Elimination to solve the system
+    // Factorize PA = LU with partial pivoting. The factorization runs as a
+    // graph of tasks over column tiles, and throws after all threads have
+    // finished if the matrix is singular.
     //
-    // Forward elimination
-#if defined(_OPENMP)
-#pragma omp parallel default(none) shared(nsize, mat, mat_inv)
-#endif
-    for (size_t k = 0; k < nsize - 1; k++) {
-        if (abs(mat[k][k]) < _ZERO_LIMIT) {
-            ostringstream message;
-            message << "0 occurs (" << mat[k][k]
-                << "). Please use row permutation.";
-            throw runtime_error(message.str());
-        }
-
-#if defined(_OPENMP)
-#pragma omp for schedule(static)
-#endif
-        for (size_t i = k + 1; i < nsize; i++) {
-            double coef = mat[i][k] / mat[k][k];
-
-            for (size_t j = k; j < nsize; j++) {
-                mat[i][j] -= mat[k][j] * coef;
-            }
-
-            for (size_t j = 0; j < nsize; j++) {
-                mat_inv[i][j] -= mat_inv[k][j] * coef;
-            }
-        }
-    }
+    LUFactorization lu(*this);
 
 #ifdef _PROFILE_TIME
     clock_t time_forward = clock();
 #endif
     
-    // Change the proceeding of each line to 1
-#if defined(_OPENMP)
-#pragma omp parallel default(none) shared(nsize, mat, mat_inv)
-#endif
-    for (size_t i = 0; i < nsize; i++) {
-
-        if (abs(mat[i][i]) < _ZERO_LIMIT) {
-            ostringstream message;
-            message << mat[i][i] << " occurs during inverse.";
-            throw runtime_error(message.str());
-        }
-        double coef = mat[i][i];
-
-#if defined(_OPENMP)
-#pragma omp barrier
-#pragma omp for schedule(static)
-#endif
-        for (size_t j = i; j < nsize; j++) {
-            mat[i][j] /= coef;
-        }
-
-#if defined(_OPENMP)
-#pragma omp for schedule(static)
-#endif
-        for (size_t j = 0; j < nsize; j++) {
-            mat_inv[i][j] /= coef;
-        }
-    }
-    
-    // Backward elimination
-#if defined(_OPENMP)
-#pragma omp parallel default(none) shared(nsize, mat_inv, mat) 
-#endif
-    for (int i = nsize - 2; i >= 0; i--) {
+    // Solve for the columns of the identity matrix. Each thread owns a
+    // tile of columns, so no element is written by more than one thread.
+    //
+    size_t ntiles = (nsize + FACTORIZATION_NB - 1) / FACTORIZATION_NB;
 
 #if defined(_OPENMP)
-#pragma omp for schedule(static)
+    int nthreads = ExecutionContext::current().threads(nsize * nsize * nsize);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(dynamic) \
+shared(nsize, ntiles, lu, mat_inv)
 #endif
-        for (int j = nsize - 1; j > i; j--) {
-
-            for (int m = 0; m < nsize; m++) {
-                mat_inv[i][m] -= mat_inv[j][m] * mat[i][j];
-            }
-
-            mat[i][j] -= mat[j][j] * mat[i][j];
-        }
+    for (size_t t = 0; t < ntiles; t++) {
+        size_t j0 = t * FACTORIZATION_NB;
+        size_t nb = min(nsize - j0, (size_t) FACTORIZATION_NB);
+        lu.solveInPlace(mat_inv.data() + j0, nb, mat_inv.stride());
     }
 
 #ifdef _PROFILE_TIME
@@ -244,8 +814,8 @@ Matrix::inverse() {
 
     cout << setprecision(4) << "-----------------------------------" << endl
          << "Time profiling for matrix inversion:" << endl
-         << "Forward elimination: " << duration_forward << "s (" << duration_forward / duration_total * 100 << "%)" << endl
-         << "Backward elimination: " << duration_backward << "s (" << duration_backward / duration_total * 100 << "%)" << endl
+         << "LU factorization: " << duration_forward << "s (" << duration_forward / duration_total * 100 << "%)" << endl
+         << "Triangular solves: " << duration_backward << "s (" << duration_backward / duration_total * 100 << "%)" << endl
          << "Inverse function total: " << duration_total << "s (" << duration_total / duration_total << ")" << endl
          << "-----------------------------------" << endl;
 #endif
@@ -254,24 +824,52 @@ Matrix::inverse() {
 }
 
 Matrix
-Matrix::transpose() {
+Matrix::transpose() const {
     
     Matrix mat_t(ncols_, nrows_);
+
+    // The matrix is transposed in square tiles so that both the rows that
+    // are read and the rows that are written stay in the cache. The
+    // threads take the rows of the transposed matrix.
+    //
+    long tile = 32;
+    long nrows = nrows_, ncols = ncols_;
     
-    // Assign values
 #if defined(_OPENMP)
-#pragma omp parallel for default(none) schedule(static) collapse(2) \
-shared(mat_t) 
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(mat_t, nrows, ncols, tile)
 #endif
-    for (size_t i = 0; i < this->nrows_; i++) {
-        for (size_t j = 0; j < this->ncols_; j++) {
-            mat_t[j][i] = (*this)[i][j];
+    for (long j0 = 0; j0 < ncols; j0 += tile) {
+        long j1 = min(j0 + tile, ncols);
+
+        for (long i0 = 0; i0 < nrows; i0 += tile) {
+            long i1 = min(i0 + tile, nrows);
+
+            for (long j = j0; j < j1; j++) {
+                double *row_t = mat_t[j];
+                for (long i = i0; i < i1; i++) {
+                    row_t[i] = (*this)[i][j];
+                }
+            }
         }
     }
     
     return mat_t;
 }
 
+Vector
+Matrix::leastSquares(const Vector & b) const {
+    QRFactorization qr(*this);
+    return (qr.solve(b));
+}
+
+Matrix
+Matrix::leastSquares(const Matrix & B) const {
+    QRFactorization qr(*this);
+    return (qr.solve(B));
+}
+
 void
 Matrix::print(ostream & os) const {
     os << "Matrix [" << nrows_ << "][" << ncols_ << "]:" << endl;
@@ -307,17 +905,9 @@ Matrix::toContinuousMatrix() const {
     cm->length = cm->nrows * cm->ncols;
     cm->data = (double *) malloc(cm->length * sizeof(double));
     
-    int values_copied = 0;
-    
-    auto row_copy = [cm, &values_copied](const vector<double> & row) {
-        copy(row.begin(), row.end(), cm->data + values_copied);
-        values_copied += row.size();
-    };
-    
-    for_each(this->begin(), this->end(), row_copy);
-    
-    if (values_copied != cm->length) throw runtime_error(
-            "Error: Matrix does not have regular shape.");
+    for (size_t i = 0; i < nrows_; i++) {
+        copy((*this)[i], (*this)[i] + ncols_, cm->data + i * ncols_);
+    }
     
     return (cm);
 }
@@ -329,14 +919,9 @@ Matrix::fromContinuousMatrix(struct continuousMatrix * cm) {
     
     this->resize(cm->nrows, cm->ncols);
     
-    int values_copied = 0;
-    
-    auto row_copy = [cm, &values_copied](vector<double> & row) {
-        copy(cm->data + values_copied, cm->data + values_copied + row.size(), row.begin());
-        values_copied += row.size();
-    };
-    
-    for_each(this->begin(), this->end(), row_copy);
+    for (size_t i = 0; i < nrows_; i++) {
+        copy(cm->data + i * ncols_, cm->data + (i + 1) * ncols_, (*this)[i]);
+    }
     
     return;
 }
@@ -344,20 +929,151 @@ Matrix::fromContinuousMatrix(struct continuousMatrix * cm) {
 Matrix &
         Matrix::operator=(const Matrix & rhs) {
     if (this != &rhs) {
+        size_t length = rhs.nrows_ * rhs.ncols_;
+
+        // Reuse the buffer if it is large enough
+        if (length > capacity_) {
+            release();
+            data_ = allocateAligned(length);
+            capacity_ = length;
+        }
+
         nrows_ = rhs.nrows_;
         ncols_ = rhs.ncols_;
+        stride_ = rhs.ncols_;
 
-        vector< vector<double> >::resize(nrows_);
         for (size_t i = 0; i < nrows_; i++) {
-            (*this)[i].resize(ncols_);
-            for (size_t j = 0; j < ncols_; j++) {
-                (*this)[i][j] = rhs[i][j];
-            }
+            copy(rhs[i], rhs[i] + ncols_, (*this)[i]);
         }
     }
     return (*this);
 }
 
+void
+Matrix::combine(const Matrix & lhs, double sign, const Matrix & rhs, Matrix & result) {
+    if (lhs.ncols_ != rhs.ncols_ || lhs.nrows_ != rhs.nrows_) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    result.resize(lhs.nrows_, lhs.ncols_);
+
+    long nrows = lhs.nrows_;
+    size_t ncols = lhs.ncols_;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows * ncols);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(lhs, sign, rhs, result, nrows, ncols)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        const double *a = lhs[i], *b = rhs[i];
+        double *c = result[i];
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (size_t j = 0; j < ncols; j++) {
+            c[j] = a[j] + sign * b[j];
+        }
+    }
+}
+
+Matrix &
+        Matrix::operator=(Matrix && rhs) noexcept {
+    if (this != &rhs) {
+        release();
+
+        // The buffer, or the file mapping, is taken over
+        nrows_ = rhs.nrows_;
+        ncols_ = rhs.ncols_;
+        stride_ = rhs.stride_;
+        capacity_ = rhs.capacity_;
+        data_ = rhs.data_;
+        map_base_ = rhs.map_base_;
+        map_length_ = rhs.map_length_;
+
+        rhs.nrows_ = rhs.ncols_ = rhs.stride_ = rhs.capacity_ = 0;
+        rhs.data_ = nullptr;
+        rhs.map_base_ = nullptr;
+        rhs.map_length_ = 0;
+    }
+    return (*this);
+}
+
+unsigned long long
+checksum(const void * data, size_t nbytes, unsigned long long seed) {
+    const unsigned long long prime = 1099511628211ULL;
+    const char *p = static_cast<const char *> (data);
+    unsigned long long hash = seed;
+
+    size_t nwords = nbytes / sizeof (uint64_t);
+    for (size_t i = 0; i < nwords; i++) {
+        uint64_t word;
+        memcpy(&word, p + i * sizeof (uint64_t), sizeof (uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+
+    for (size_t i = nwords * sizeof (uint64_t); i < nbytes; i++) {
+        hash = (hash ^ static_cast<unsigned char> (p[i])) * prime;
+    }
+
+    return (hash);
+}
+
+void
+binaryLayout(const string & bin_file, size_t & nrows, size_t & ncols, size_t & data_offset) {
+    int fd = open(bin_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    struct stat file_stat;
+    MatrixFileHeader header;
+
+    bool valid = (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t) sizeof (header) &&
+            pread(fd, &header, sizeof (header), 0) == sizeof (header));
+    close(fd);
+
+    if (!valid || memcmp(header.magic, _FILE_MAGIC, sizeof (_FILE_MAGIC)) != 0 ||
+            header.version != _FILE_VERSION || header.byte_order != _FILE_BYTE_ORDER) {
+        throw runtime_error("Error: The file is not a binary matrix file of a supported version.");
+    }
+
+    if (header.dtype != _FILE_DTYPE_FLOAT64 || header.layout != _FILE_LAYOUT_ROW_MAJOR) {
+        throw runtime_error("Error: The binary matrix file does not have row-major double values.");
+    }
+
+    if (!validDataRange(header, sizeof (double), alignof (double), file_stat.st_size)) {
+        throw runtime_error("Error: The binary matrix file is truncated or its data offset is not valid.");
+    }
+
+    nrows = header.nrows;
+    ncols = header.ncols;
+    data_offset = header.data_offset;
+}
+
+bool
+netcdfVariable(const string & path, string & nc_file, string & var_name) {
+    size_t colon = path.rfind(':');
+    if (colon == string::npos || colon < 3 || colon + 1 == path.size() ||
+            path.compare(colon - 3, 3, ".nc") != 0) {
+        return (false);
+    }
+
+    nc_file = path.substr(0, colon);
+    var_name = path.substr(colon + 1);
+    return (true);
+}
+
+#ifdef _USE_NETCDF
+void
+checkNetCDF(int res) {
+    if (res != NC_NOERR) {
+        throw runtime_error(string("Error: ") + nc_strerror(res));
+    }
+}
+#endif
+
 ostream &
 operator<<(ostream & os, const Matrix & mat) {
     mat.print(os);
@@ -12,6 +12,29 @@
 #include <vector>
 #include <iostream>
 #include <exception>
+#include <cstddef>
+
+#include "Gemm.h"
+#include "LinearOperator.h"
+
+// Alignment in bytes of the matrix storage. 64 bytes covers a cache line
+// and the widest SIMD register (AVX-512).
+#define MATRIX_ALIGNMENT 64
+
+// The compression level of the NetCDF variables that are written, from 0
+// (no compression) to 9. Shuffling and deflating a solution costs more
+// than it saves on most file systems, so the default is off.
+//
+#ifndef NETCDF_DEFLATE_LEVEL
+#define NETCDF_DEFLATE_LEVEL 0
+#endif
+
+// The number of values in a chunk of a NetCDF variable that is written,
+// and in a block of a variable that is read
+//
+#ifndef NETCDF_CHUNK_VALUES
+#define NETCDF_CHUNK_VALUES (1 << 20)
+#endif
 
 struct continuousMatrix {
     int nrows;
@@ -22,88 +45,193 @@ struct continuousMatrix {
 
 void deleteContinuousMatrix(struct continuousMatrix * p_cm);
 
-class Matrix : public std::vector< std::vector<double> > {
+// Allocate memory for values aligned to MATRIX_ALIGNMENT. The memory
+// should be released with free().
+//
+double * allocateAligned(std::size_t length);
+
+// A non-owning view of values that are equally spaced in memory. It is used
+// to refer to a row (stride 1) or a column (stride of the matrix) without
+// copying any data.
+//
+template <typename T>
+class StridedView {
+public:
+    StridedView(T * data, std::size_t size, std::size_t stride) :
+    data_(data), size_(size), stride_(stride) {
+    }
+
+    T & operator[](std::size_t i) const {
+        return (data_[i * stride_]);
+    }
+
+    T * data() const {
+        return (data_);
+    }
+
+    std::size_t size() const {
+        return (size_);
+    }
+
+    std::size_t stride() const {
+        return (stride_);
+    }
+
+private:
+    T * data_;
+    std::size_t size_;
+    std::size_t stride_;
+};
+
+// Matrix stores values in a single aligned buffer in row-major order. The
+// element (i, j) is located at data()[i * stride() + j]. The buffer can be
+// passed directly to MPI or SIMD kernels without copying.
+//
+class Matrix : public LinearOperator {
 public:
+    typedef StridedView<double> RowView;
+    typedef StridedView<double> ColumnView;
+    typedef StridedView<const double> ConstRowView;
+    typedef StridedView<const double> ConstColumnView;
+
     Matrix();
     Matrix(std::size_t nsize);
     Matrix(std::size_t nrows, std::size_t ncols);
     Matrix(const Matrix& orig);
+    Matrix(Matrix && orig) noexcept;
     virtual ~Matrix();
     
+    // Resize the matrix. Values in the overlapping region are kept and
+    // new values are initialized to 0.
+    //
     void resize(std::size_t nrows, std::size_t ncols);
-    size_t nrows() const;
-    size_t ncols() const;
+    size_t nrows() const override;
+    size_t ncols() const override;
+
+    // Number of elements between the beginnings of two consecutive rows
+    size_t stride() const;
+
+    // Pointer to the beginning of the storage
+    double * data();
+    const double * data() const;
+
+    // Views of a row or a column
+    RowView row(std::size_t i);
+    ConstRowView row(std::size_t i) const;
+    ColumnView col(std::size_t j);
+    ConstColumnView col(std::size_t j) const;
+
+    // Element access. mat[i] points to the beginning of row i so that
+    // mat[i][j] refers to the element (i, j).
+    //
+    double * operator[](std::size_t i) {
+        return (data_ + i * stride_);
+    }
+
+    const double * operator[](std::size_t i) const {
+        return (data_ + i * stride_);
+    }
     
+    // The interface of the iterative solvers. Please see LinearOperator.h.
+    void multiply(const Vector & x, Vector & y) const override;
+    void multiplyBlock(const Matrix & X, Matrix & Y) const override;
+    double rowProduct(std::size_t i, const double * x) const override;
+    double diagonal(std::size_t i) const override;
+
     // Check whether the matrix is diagonally dominant
-    bool checkDominant()const;
+    bool checkDominant() const override;
     
-    // Read matrix from file
+    // Read matrix from file. Binary files (see writeBinary) are detected
+    // automatically, paths of NetCDF variables are read with readNetCDF,
+    // and other files are parsed as CSV.
+    //
     bool readMatrix(const std::string & csv_file);
+
+    // Write the matrix as a csv file with one row per line. The values are
+    // written with enough digits to be read back exactly. Paths of NetCDF
+    // variables are written with writeNetCDF.
+    //
+    bool writeMatrix(const std::string & csv_file) const;
+
+    // Binary matrix file
+    //
+    // The file starts with a 64-byte header that records the magic string
+    // "CSEMATRX", the format version, the byte order, the data type, the
+    // layout, the dimensions, the offset of the data, and a checksum of
+    // the data. The data are raw values aligned to 64 bytes.
+    //
+    // Row-major double files are memory-mapped without parsing or copying.
+    // The mapping is private, so changes to the matrix are not written
+    // back to the file. Other layouts and data types are converted.
+    //
+    bool readBinary(const std::string & bin_file, bool verify_checksum = false);
+    bool writeBinary(const std::string & bin_file) const;
+
+    // NetCDF variables
+    //
+    // The first dimension of a 2-dimensional variable is the column and
+    // the second dimension is the row, which is how R writes a matrix, e.g.
+    // in data/ncdf4/generate_test.R. A 1-dimensional variable is a column.
+    // The variable is read a block of columns at a time.
+    //
+    // The matrix is written as a new NetCDF-4 file with the variable
+    // chunked in blocks of whole columns, and compressed at deflate_level.
+    // A matrix with one column is written as a 1-dimensional variable.
+    //
+    // readMatrix() and writeMatrix() use these for the paths of NetCDF
+    // variables (see netcdfVariable). Without NetCDF, an exception is
+    // thrown.
+    //
+    bool readNetCDF(const std::string & nc_file, const std::string & var_name);
+    bool writeNetCDF(const std::string & nc_file, const std::string & var_name,
+            int deflate_level = NETCDF_DEFLATE_LEVEL) const;
+
+    // Whether the storage is memory-mapped from a file
+    bool isMapped() const;
     
     // Matrix inverse
     Matrix inverse();
     
     // Matrix transpose
-    Matrix transpose();
+    Matrix transpose() const;
+
+    // Least-squares solution of Ax = b with the Householder QR
+    // factorization. The minimum norm solution is returned when A has
+    // fewer rows than columns. A * A^t is never formed.
+    //
+    Vector leastSquares(const Vector & b) const;
+    Matrix leastSquares(const Matrix & B) const;
 
     // Print functions
-    void print(std::ostream &) const;
+    void print(std::ostream &) const override;
     
-    // Convert to a matrix with continuous memory
+    // Convert to a matrix with continuous memory. The storage of Matrix is
+    // already continuous, so data() should be preferred to avoid the copy.
+    //
     struct continuousMatrix *toContinuousMatrix() const;
     
     // Generate from a matrix with continuous memory
     void fromContinuousMatrix(struct continuousMatrix * p_cm);
     
-    // Overload operators
+    // Overload operators. The results of the operators below are moved
+    // out without copying the values.
+    //
     Matrix & operator=(const Matrix & rhs);
+    Matrix & operator=(Matrix && rhs) noexcept;
     friend std::ostream & operator<<(std::ostream &, const Matrix &);
 
+    // The element-wise operators are threaded over the rows with the
+    // current execution context. Please see ExecutionContext.h.
+    //
     inline friend Matrix operator+(const Matrix & lhs, const Matrix & rhs) {
-        using namespace std;
-        Matrix mat_add(0, 0);
-
-        if (lhs.ncols_ != rhs.ncols_ || lhs.nrows_ != rhs.nrows_) {
-            throw runtime_error("Matrices do not have the correct shape.");
-        }
-
-        mat_add.resize(lhs.nrows_, lhs.ncols_);
-
-#if defined(_OPENMP)
-//#pragma omp parallel for default(none) schedule(static) collapse(2) \
-//        shared(lhs, mat_add, rhs) 
-#pragma omp for schedule(static) collapse(2)
-#endif
-        for (size_t i = 0; i < lhs.nrows_; i++) {
-            for (size_t j = 0; j < lhs.ncols_; j++) {
-                mat_add[i][j] = lhs[i][j] + rhs[i][j];
-            }
-        }
-
+        Matrix mat_add;
+        combine(lhs, 1.0, rhs, mat_add);
         return (mat_add);
     }
 
     inline friend Matrix operator-(const Matrix & lhs, const Matrix & rhs) {
-        using namespace std;
-        Matrix mat_minus(0, 0);
-
-        if (lhs.ncols_ != rhs.ncols_ || lhs.nrows_ != rhs.nrows_) {
-            throw runtime_error("Matrices do not have the correct shape.");
-        }
-
-        mat_minus.resize(lhs.nrows_, lhs.ncols_);
-
-#if defined(_OPENMP)
-//#pragma omp parallel for default(none) schedule(static) collapse(2) \
-//        shared(lhs, rhs, mat_minus) 
-#pragma omp for schedule(static) collapse(2)
-#endif
-        for (size_t i = 0; i < lhs.nrows_; i++) {
-            for (size_t j = 0; j < lhs.ncols_; j++) {
-                mat_minus[i][j] = lhs[i][j] - rhs[i][j];
-            }
-        }
-
+        Matrix mat_minus;
+        combine(lhs, -1.0, rhs, mat_minus);
         return (mat_minus);
     }
 
@@ -121,19 +249,15 @@ public:
 
         mat_mul.resize(nrows, ncols);
 
-#if defined(_OPENMP)
-//#pragma omp parallel for default(none) schedule(static) collapse(2) \
-//        shared(nrows, ncols, mat_mul, lhs, rhs, mid)
-#pragma omp for schedule(static) collapse(2)
-#endif
-        for (size_t i = 0; i < nrows; i++) {
-            for (size_t j = 0; j < ncols; j++) {
-                double sum = 0.0;
-                for (size_t k = 0; k < mid; k++) {
-                    sum += lhs[i][k] * rhs[k][j];
-                }
-                mat_mul[i][j] = sum;
-            }
+        // Matrix-vector products are the common case in the iterative
+        // solvers and they have a dedicated kernel.
+        //
+        if (ncols == 1) {
+            gemv(nrows, mid, 1.0, lhs.data(), lhs.stride(),
+                    rhs.data(), rhs.stride(), 0.0, mat_mul.data(), mat_mul.stride());
+        } else {
+            gemm(nrows, ncols, mid, 1.0, lhs.data(), lhs.stride(),
+                    rhs.data(), rhs.stride(), 0.0, mat_mul.data(), mat_mul.stride());
         }
 
         return (mat_mul);
@@ -142,7 +266,49 @@ public:
 private:
     std::size_t nrows_ = 0;
     std::size_t ncols_ = 0;
+    std::size_t stride_ = 0;
+
+    // Number of values that the buffer can hold
+    std::size_t capacity_ = 0;
+    double *data_ = nullptr;
+
+    // The file mapping when the storage is memory-mapped
+    void *map_base_ = nullptr;
+    std::size_t map_length_ = 0;
+
+    // Release the storage
+    void release();
+
+    // result = lhs + sign * rhs, where sign is 1 or -1
+    static void combine(const Matrix & lhs, double sign, const Matrix & rhs,
+            Matrix & result);
 };
 
+// Checksum used by the binary matrix file. It is the 64-bit FNV-1a hash
+// over 64-bit words, followed by the remaining bytes. A previous checksum
+// can be passed as the seed to continue hashing.
+//
+unsigned long long checksum(const void * data, std::size_t nbytes,
+        unsigned long long seed = 14695981039346656037ULL);
+
+// The shape and the offset of the values of a binary matrix file with
+// row-major double values, which can be read in place, e.g. by
+// StreamedMatrix. An exception is thrown for other files.
+//
+void binaryLayout(const std::string & bin_file, std::size_t & nrows,
+        std::size_t & ncols, std::size_t & data_offset);
+
+// The path of a NetCDF variable is <file>.nc:<variable>, e.g. 100.nc:A.
+// Such a path is split into the file and the variable, and false is
+// returned for other paths.
+//
+bool netcdfVariable(const std::string & path, std::string & nc_file,
+        std::string & var_name);
+
+#ifdef _USE_NETCDF
+// Throw an exception with the message of a NetCDF error
+void checkNetCDF(int res);
+#endif
+
 #endif /* MATRIX_H */
 
@@ -0,0 +1,251 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   MixedPrecision.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 26, 2026, 10:40 AM
+ */
+
+#include "MixedPrecision.h"
+#include "ExecutionContext.h"
+
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+// Round a value to single precision
+static float
+toSingle(double value) {
+    if (!(abs(value) <= FLT_MAX)) {
+        throw runtime_error("Error: A value of the matrix does not fit in single precision.");
+    }
+    return (static_cast<float> (value));
+}
+
+SingleMatrix::SingleMatrix() {
+}
+
+SingleMatrix::SingleMatrix(const Matrix & A) :
+nrows_(A.nrows()), ncols_(A.ncols()), sparse_(false) {
+
+    values_.resize(nrows_ * ncols_);
+    diag_.assign(nrows_, 0.0);
+
+    for (size_t i = 0; i < nrows_; i++) {
+        for (size_t j = 0; j < ncols_; j++) {
+            values_[i * ncols_ + j] = toSingle(A[i][j]);
+        }
+        if (i < ncols_) diag_[i] = values_[i * ncols_ + i];
+    }
+}
+
+SingleMatrix::SingleMatrix(const SparseMatrix & A) :
+nrows_(A.nrows()), ncols_(A.ncols()), sparse_(true),
+row_ptr_(A.rowPointers()), cols_(A.columnIndices()) {
+
+    const vector<double> & values = A.values();
+    values_.resize(values.size());
+    for (size_t k = 0; k < values.size(); k++) values_[k] = toSingle(values[k]);
+
+    diag_.assign(nrows_, 0.0);
+    for (size_t i = 0; i < nrows_; i++) {
+        for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+            if (cols_[k] == i) diag_[i] = values_[k];
+        }
+    }
+}
+
+SingleMatrix::~SingleMatrix() {
+}
+
+size_t
+SingleMatrix::nrows() const {
+    return (nrows_);
+}
+
+size_t
+SingleMatrix::ncols() const {
+    return (ncols_);
+}
+
+bool
+SingleMatrix::sparse() const {
+    return (sparse_);
+}
+
+size_t
+SingleMatrix::bytes() const {
+    return (values_.size() * sizeof (float) +
+            cols_.size() * sizeof (SparseMatrix::Index) +
+            row_ptr_.size() * sizeof (size_t));
+}
+
+void
+SingleMatrix::multiply(const Vector & x, Vector & y) const {
+    if (x.size() != ncols_) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    y.resize(nrows_);
+
+    const double *px = x.data();
+    double *py = y.data();
+    long nrows = nrows_;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(values_.size());
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(px, py, nrows)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        py[i] = SingleMatrix::rowProduct(i, px);
+    }
+}
+
+double
+SingleMatrix::rowProduct(size_t i, const double * x) const {
+    const float *v = values_.data();
+    double sum = 0.0;
+
+    if (sparse_) {
+        size_t begin = row_ptr_[i], end = row_ptr_[i + 1];
+        const SparseMatrix::Index *col = cols_.data();
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+        for (size_t k = begin; k < end; k++) {
+            sum += v[k] * x[col[k]];
+        }
+
+    } else {
+        size_t n = ncols_;
+        v += i * n;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+        for (size_t j = 0; j < n; j++) {
+            sum += v[j] * x[j];
+        }
+    }
+
+    return (sum);
+}
+
+double
+SingleMatrix::diagonal(size_t i) const {
+    return (diag_[i]);
+}
+
+bool
+SingleMatrix::checkDominant() const {
+    for (size_t i = 0; i < nrows_; i++) {
+        size_t begin = (sparse_ ? row_ptr_[i] : i * ncols_);
+        size_t end = (sparse_ ? row_ptr_[i + 1] : begin + ncols_);
+
+        double sum = 0.0;
+        for (size_t k = begin; k < end; k++) {
+            sum += abs(values_[k]);
+        }
+        if (diag_[i] < sum - diag_[i]) {
+            return false;
+        }
+    }
+    return (true);
+}
+
+void
+SingleMatrix::print(ostream & os) const {
+    os << "SingleMatrix [" << nrows_ << "][" << ncols_ << "]"
+            << (sparse_ ? " sparse" : " dense") << ":" << endl;
+
+    for (size_t i = 0; i < nrows_; i++) {
+        if (sparse_) {
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                os << "[" << i << ", " << cols_[k] << "]\t" << values_[k] << endl;
+            }
+        } else {
+            for (size_t j = 0; j < ncols_; j++) {
+                os << values_[i * ncols_ + j] << (j + 1 < ncols_ ? "\t" : "");
+            }
+            os << endl;
+        }
+    }
+    os << endl;
+}
+
+IterativeRefinement::IterativeRefinement(const LinearOperator & A,
+        const Correction & correct, size_t max_steps) :
+A_(A), correct_(correct), max_steps_(max_steps) {
+    if (A_.nrows() != A_.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+}
+
+IterativeRefinement::~IterativeRefinement() {
+}
+
+size_t
+IterativeRefinement::steps() const {
+    return (steps_);
+}
+
+Convergence::Status
+IterativeRefinement::status() const {
+    return (status_);
+}
+
+double
+IterativeRefinement::solve(const Vector & b, Vector & x, double small_resid,
+        int verbose) const {
+    return (solve(b, x, Convergence(small_resid), verbose));
+}
+
+double
+IterativeRefinement::solve(const Vector & b, Vector & x,
+        const Convergence & criterion, int verbose) const {
+
+    if (b.size() != A_.nrows() || x.size() != A_.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    ConvergenceMonitor monitor(criterion, criterion.measure(b));
+
+    Vector r, d;
+    r = b - A_ * x;
+    double resid_metric = criterion.measure(r);
+    monitor.check(resid_metric);
+
+    for (steps_ = 0; steps_ < max_steps_ &&
+            monitor.status() == Convergence::ITERATING; steps_++) {
+        d = Vector(x.size(), 0.0);
+        correct_(r, d);
+
+        // A step that does not reduce the residual is not kept, e.g. when
+        // the inner solver has stagnated at the precision of float
+        //
+        Vector x_new;
+        x_new = x + d;
+        r = b - A_ * x_new;
+        double resid_new = criterion.measure(r);
+
+        if (verbose >= 2) {
+            cout << "Refinement " << steps_ + 1 << " residual: " << resid_new << endl;
+        }
+
+        if (resid_new >= resid_metric) {
+            status_ = Convergence::STAGNATED;
+            return (resid_metric);
+        }
+
+        x.swap(x_new);
+        resid_metric = resid_new;
+        monitor.check(resid_metric);
+    }
+
+    status_ = monitor.status();
+    return (resid_metric);
+}
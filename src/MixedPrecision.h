@@ -0,0 +1,121 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   MixedPrecision.h
+ * Author: Weiming Hu
+ *
+ * Created on October 26, 2026, 10:40 AM
+ */
+
+#ifndef MIXEDPRECISION_H
+#define MIXEDPRECISION_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "SparseMatrix.h"
+#include "LinearOperator.h"
+#include "Convergence.h"
+
+#include <vector>
+#include <iostream>
+#include <functional>
+
+// The largest number of refinement steps, i.e. the inner solves
+#ifndef REFINEMENT_MAX_STEPS
+#define REFINEMENT_MAX_STEPS 10
+#endif
+
+// The inner solver of a refinement step reduces the L1 norm of the
+// residual by this factor. Smaller factors than the precision of float
+// only add inner iterations.
+//
+#ifndef REFINEMENT_INNER_TOLERANCE
+#define REFINEMENT_INNER_TOLERANCE 1.0e-5
+#endif
+
+// A copy of a dense or sparse matrix with the values in single precision
+//
+// The values are stored as float, which halves the memory traffic of the
+// mat-vec, and the products are added up in double. A dense matrix is
+// stored row by row, and a sparse matrix in the CSR format of SparseMatrix.
+// An exception is thrown when a value does not fit in a float.
+//
+class SingleMatrix : public LinearOperator {
+public:
+    SingleMatrix();
+    explicit SingleMatrix(const Matrix & A);
+    explicit SingleMatrix(const SparseMatrix & A);
+    virtual ~SingleMatrix();
+
+    std::size_t nrows() const override;
+    std::size_t ncols() const override;
+
+    bool sparse() const;
+
+    // Number of bytes of the values and the indices
+    std::size_t bytes() const;
+
+    // The interface of the iterative solvers. Please see LinearOperator.h.
+    void multiply(const Vector & x, Vector & y) const override;
+    double rowProduct(std::size_t i, const double * x) const override;
+    double diagonal(std::size_t i) const override;
+    bool checkDominant() const override;
+
+    void print(std::ostream &) const override;
+
+private:
+    std::size_t nrows_ = 0;
+    std::size_t ncols_ = 0;
+    bool sparse_ = false;
+
+    // Without the row pointers, the values are dense
+    std::vector<std::size_t> row_ptr_;
+    std::vector<SparseMatrix::Index> cols_;
+    std::vector<float> values_;
+    std::vector<double> diag_;
+};
+
+// Mixed-precision iterative refinement
+//
+// For Ax = b, every step solves the correction A * d = r of the residual
+// r = b - A * x with a fast inner solver, e.g. an iterative solver on the
+// SingleMatrix of A, and updates x = x + d. The residuals are computed
+// with A in double, so the solution reaches the double precision of A
+// although the inner solves are only accurate to the precision of float.
+//
+class IterativeRefinement {
+public:
+
+    // Solve A * d = r. d is 0 when it is called.
+    typedef std::function<void(const Vector & r, Vector & d)> Correction;
+
+    IterativeRefinement(const LinearOperator & A, const Correction & correct,
+            std::size_t max_steps = REFINEMENT_MAX_STEPS);
+    virtual ~IterativeRefinement();
+
+    // Refine until the L1 norm of the residual is not larger than
+    // small_resid, max_steps are taken, or a step does not reduce the
+    // residual. x is the initial guess and the solution afterwards. The
+    // L1 norm of the final residual is returned.
+    //
+    double solve(const Vector & b, Vector & x, double small_resid,
+            int verbose = 0) const;
+
+    // Refine until the criterion stops or a step does not reduce the
+    // residual. The norm of the criterion of the final residual is returned.
+    //
+    double solve(const Vector & b, Vector & x, const Convergence & criterion,
+            int verbose = 0) const;
+
+    // Number of steps and the status of the last solve
+    std::size_t steps() const;
+    Convergence::Status status() const;
+
+private:
+    const LinearOperator & A_;
+    Correction correct_;
+    std::size_t max_steps_;
+    mutable std::size_t steps_ = 0;
+    mutable Convergence::Status status_ = Convergence::ITERATING;
+};
+
+#endif /* MIXEDPRECISION_H */
@@ -0,0 +1,289 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Preconditioner.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 23, 2026, 10:05 AM
+ */
+
+#include "Preconditioner.h"
+#include "Jacobi.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <cctype>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _PROFILE_TIME
+#include <ctime>
+#endif
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+Preconditioner::Preconditioner() {
+}
+
+Preconditioner::~Preconditioner() {
+}
+
+void
+Preconditioner::apply(const Vector & r, Vector & z) const {
+
+#ifdef _PROFILE_TIME
+    clock_t time_start = clock();
+#endif
+
+    z.resize(r.size());
+    solve(r, z);
+    applications_++;
+
+#ifdef _PROFILE_TIME
+    apply_time_ += (clock() - time_start) / (double) CLOCKS_PER_SEC;
+#endif
+}
+
+size_t
+Preconditioner::applications() const {
+    return (applications_);
+}
+
+double
+Preconditioner::applyTime() const {
+    return (apply_time_);
+}
+
+JacobiPreconditioner::JacobiPreconditioner(const LinearOperator & A) :
+D_inv_(inverseDiagonal(A)) {
+}
+
+JacobiPreconditioner::~JacobiPreconditioner() {
+}
+
+string
+JacobiPreconditioner::name() const {
+    return ("Jacobi");
+}
+
+void
+JacobiPreconditioner::solve(const Vector & r, Vector & z) const {
+    const double *pr = r.data(), *pd = D_inv_.data();
+    double *pz = z.data();
+    size_t n = D_inv_.size();
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        pz[i] = pd[i] * pr[i];
+    }
+}
+
+ILU0Preconditioner::ILU0Preconditioner(const SparseMatrix & A) :
+row_ptr_(A.rowPointers()), cols_(A.columnIndices()), LU_(A.values()) {
+
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    size_t n = A.nrows();
+    diag_ptr_.resize(n);
+
+    // The position of every column of row i, or n if it is not stored
+    vector<size_t> position(n, n);
+
+    for (size_t i = 0; i < n; i++) {
+        size_t begin = row_ptr_[i], end = row_ptr_[i + 1];
+        for (size_t k = begin; k < end; k++) position[cols_[k]] = k;
+
+        // Eliminate the values left of the diagonal with the rows above.
+        // Updates of the values that are not stored are dropped.
+        //
+        size_t k = begin;
+        for (; k < end && cols_[k] < i; k++) {
+            size_t row = cols_[k];
+            double l = (LU_[k] /= LU_[diag_ptr_[row]]);
+
+            for (size_t kk = diag_ptr_[row] + 1; kk < row_ptr_[row + 1]; kk++) {
+                size_t pos = position[cols_[kk]];
+                if (pos != n) LU_[pos] -= l * LU_[kk];
+            }
+        }
+
+        if (k == end || cols_[k] != i || abs(LU_[k]) < _ZERO_LIMIT) {
+            ostringstream message;
+            message << "Error: 0 occurs on the diagonal of ILU(0) at row " << i << ".";
+            throw runtime_error(message.str());
+        }
+
+        diag_ptr_[i] = k;
+        for (size_t kk = begin; kk < end; kk++) position[cols_[kk]] = n;
+    }
+}
+
+ILU0Preconditioner::~ILU0Preconditioner() {
+}
+
+string
+ILU0Preconditioner::name() const {
+    return ("ILU(0)");
+}
+
+void
+ILU0Preconditioner::solve(const Vector & r, Vector & z) const {
+    size_t n = diag_ptr_.size();
+
+    // L * y = r, where L has a unit diagonal
+    for (size_t i = 0; i < n; i++) {
+        double sum = r[i];
+        for (size_t k = row_ptr_[i]; k < diag_ptr_[i]; k++) {
+            sum -= LU_[k] * z[cols_[k]];
+        }
+        z[i] = sum;
+    }
+
+    // U * z = y
+    for (size_t i = n; i-- > 0;) {
+        double sum = z[i];
+        for (size_t k = diag_ptr_[i] + 1; k < row_ptr_[i + 1]; k++) {
+            sum -= LU_[k] * z[cols_[k]];
+        }
+        z[i] = sum / LU_[diag_ptr_[i]];
+    }
+}
+
+BlockJacobiPreconditioner::BlockJacobiPreconditioner(const Matrix & A,
+        size_t block_size) {
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    factorize(A.nrows(), block_size, [&A](size_t row0, Matrix & A_block) {
+        for (size_t i = 0; i < A_block.nrows(); i++) {
+            copy(A[row0 + i] + row0, A[row0 + i] + row0 + A_block.ncols(), A_block[i]);
+        }
+    });
+}
+
+BlockJacobiPreconditioner::BlockJacobiPreconditioner(const SparseMatrix & A,
+        size_t block_size) {
+    if (A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix should be square!");
+    }
+
+    factorize(A.nrows(), block_size, [&A](size_t row0, Matrix & A_block) {
+        const vector<size_t> & row_ptr = A.rowPointers();
+        const vector<SparseMatrix::Index> & cols = A.columnIndices();
+        const vector<double> & values = A.values();
+        size_t size = A_block.nrows();
+
+        for (size_t i = 0; i < size; i++) {
+            fill(A_block[i], A_block[i] + size, 0.0);
+            for (size_t k = row_ptr[row0 + i]; k < row_ptr[row0 + i + 1]; k++) {
+                if (cols[k] >= row0 && cols[k] < row0 + size) A_block[i][cols[k] - row0] = values[k];
+            }
+        }
+    });
+}
+
+BlockJacobiPreconditioner::~BlockJacobiPreconditioner() {
+}
+
+template <typename Block>
+void
+BlockJacobiPreconditioner::factorize(size_t n, size_t block_size, Block block) {
+    block_size_ = (block_size == 0 || block_size > n ? n : block_size);
+    if (n == 0) return;
+
+    size_t nblocks = (n + block_size_ - 1) / block_size_;
+    blocks_.resize(nblocks);
+
+    // The factorizations use the threads themselves
+    Matrix A_block;
+    for (size_t b = 0; b < nblocks; b++) {
+        size_t size = min(block_size_, n - b * block_size_);
+        A_block.resize(size, size);
+        block(b * block_size_, A_block);
+        blocks_[b].factorize(A_block);
+    }
+}
+
+string
+BlockJacobiPreconditioner::name() const {
+    return ("block-Jacobi");
+}
+
+size_t
+BlockJacobiPreconditioner::blockSize() const {
+    return (block_size_);
+}
+
+size_t
+BlockJacobiPreconditioner::nblocks() const {
+    return (blocks_.size());
+}
+
+void
+BlockJacobiPreconditioner::solve(const Vector & r, Vector & z) const {
+    long nblocks = blocks_.size();
+    size_t block_size = block_size_;
+    copy(r.data(), r.data() + r.size(), z.data());
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(r.size() * block_size);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) shared(nblocks, block_size, z)
+#endif
+    for (long b = 0; b < nblocks; b++) {
+        blocks_[b].solveInPlace(z.data() + b * block_size, 1, 1);
+    }
+}
+
+static string
+lowerCase(const string & name) {
+    string lower(name);
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return (lower);
+}
+
+unique_ptr<Preconditioner>
+makePreconditioner(const string & name, const Matrix & A, size_t block_size) {
+    string lower = lowerCase(name);
+
+    if (lower == "jacobi") {
+        return (unique_ptr<Preconditioner>(new JacobiPreconditioner(A)));
+    } else if (lower == "ilu0") {
+        return (unique_ptr<Preconditioner>(new ILU0Preconditioner(SparseMatrix(A))));
+    } else if (lower == "block") {
+        return (unique_ptr<Preconditioner>(new BlockJacobiPreconditioner(A, block_size)));
+    }
+
+    throw runtime_error("Error: Unknown preconditioner " + name + ".");
+}
+
+unique_ptr<Preconditioner>
+makePreconditioner(const string & name, const SparseMatrix & A, size_t block_size) {
+    string lower = lowerCase(name);
+
+    if (lower == "jacobi") {
+        return (unique_ptr<Preconditioner>(new JacobiPreconditioner(A)));
+    } else if (lower == "ilu0") {
+        return (unique_ptr<Preconditioner>(new ILU0Preconditioner(A)));
+    } else if (lower == "block") {
+        return (unique_ptr<Preconditioner>(new BlockJacobiPreconditioner(A, block_size)));
+    }
+
+    throw runtime_error("Error: Unknown preconditioner " + name + ".");
+}
+
+unique_ptr<Preconditioner>
+makePreconditioner(const string & name, const LinearOperator & A, size_t block_size) {
+    (void) block_size;
+
+    if (lowerCase(name) == "jacobi") {
+        return (unique_ptr<Preconditioner>(new JacobiPreconditioner(A)));
+    }
+
+    throw runtime_error("Error: Only the jacobi preconditioner is available for this matrix.");
+}
@@ -0,0 +1,147 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Preconditioner.h
+ * Author: Weiming Hu
+ *
+ * Created on October 23, 2026, 10:05 AM
+ */
+
+#ifndef PRECONDITIONER_H
+#define PRECONDITIONER_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "SparseMatrix.h"
+#include "LinearOperator.h"
+#include "Factorization.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+
+// The default number of rows in a block of the block-Jacobi preconditioner
+#ifndef BLOCK_JACOBI_SIZE
+#define BLOCK_JACOBI_SIZE 64
+#endif
+
+// The interface of a preconditioner M of A for the Krylov methods
+//
+// apply() computes z = M^-1 * r, where M is an approximation of A that is
+// cheap to invert. The number of applications is counted, and their time
+// is measured with _PROFILE_TIME.
+//
+class Preconditioner {
+public:
+    Preconditioner();
+    virtual ~Preconditioner();
+
+    // z = M^-1 * r. z is resized when it does not have the size of r.
+    void apply(const Vector & r, Vector & z) const;
+
+    virtual std::string name() const = 0;
+
+    std::size_t applications() const;
+
+    // The total time of apply() in seconds, or 0 without _PROFILE_TIME
+    double applyTime() const;
+
+protected:
+    // z = M^-1 * r, where z has the size of r
+    virtual void solve(const Vector & r, Vector & z) const = 0;
+
+private:
+    mutable std::size_t applications_ = 0;
+    mutable double apply_time_ = 0.0;
+};
+
+// Diagonal scaling, M = D
+class JacobiPreconditioner : public Preconditioner {
+public:
+    JacobiPreconditioner(const LinearOperator & A);
+    virtual ~JacobiPreconditioner();
+
+    std::string name() const override;
+
+protected:
+    void solve(const Vector & r, Vector & z) const override;
+
+private:
+    Vector D_inv_;
+};
+
+// Incomplete LU factorization without fill-in, M = LU
+//
+// L and U have the sparsity pattern of A, so that the factors are stored
+// in a copy of the values of A. L has a unit diagonal. An exception is
+// thrown when a diagonal value is not stored or becomes 0.
+//
+class ILU0Preconditioner : public Preconditioner {
+public:
+    ILU0Preconditioner(const SparseMatrix & A);
+    virtual ~ILU0Preconditioner();
+
+    std::string name() const override;
+
+protected:
+    void solve(const Vector & r, Vector & z) const override;
+
+private:
+
+    // The pattern of A, the values of L and U in the same layout, and the
+    // position of the diagonal value of every row
+    //
+    std::vector<std::size_t> row_ptr_;
+    std::vector<SparseMatrix::Index> cols_;
+    std::vector<double> LU_;
+    std::vector<std::size_t> diag_ptr_;
+};
+
+// Block-Jacobi preconditioner, M = diag(A_11, A_22, ...)
+//
+// The diagonal blocks of block_size consecutive rows, where the last
+// block can be smaller, are factorized with LUFactorization, and they are
+// solved independently by the threads. A block_size of 0 means one block
+// of all rows, e.g. the rows owned by a process.
+//
+class BlockJacobiPreconditioner : public Preconditioner {
+public:
+    BlockJacobiPreconditioner(const Matrix & A,
+            std::size_t block_size = BLOCK_JACOBI_SIZE);
+    BlockJacobiPreconditioner(const SparseMatrix & A,
+            std::size_t block_size = BLOCK_JACOBI_SIZE);
+    virtual ~BlockJacobiPreconditioner();
+
+    std::string name() const override;
+
+    std::size_t blockSize() const;
+    std::size_t nblocks() const;
+
+protected:
+    void solve(const Vector & r, Vector & z) const override;
+
+private:
+    std::size_t block_size_ = 0;
+    std::vector<LUFactorization> blocks_;
+
+    // Factorize the blocks, where block(row0, A_block) copies the block
+    // that starts at row and column row0 into A_block
+    //
+    template <typename Block>
+    void factorize(std::size_t n, std::size_t block_size, Block block);
+};
+
+// Create a preconditioner by its name, jacobi, ilu0, or block, which is
+// case insensitive. The dense matrix is converted for ILU(0).
+//
+std::unique_ptr<Preconditioner> makePreconditioner(const std::string & name,
+        const Matrix & A, std::size_t block_size = BLOCK_JACOBI_SIZE);
+std::unique_ptr<Preconditioner> makePreconditioner(const std::string & name,
+        const SparseMatrix & A, std::size_t block_size = BLOCK_JACOBI_SIZE);
+
+// Other operators, e.g. StreamedMatrix, only have the Jacobi
+// preconditioner, which only needs the diagonal
+//
+std::unique_ptr<Preconditioner> makePreconditioner(const std::string & name,
+        const LinearOperator & A, std::size_t block_size = BLOCK_JACOBI_SIZE);
+
+#endif /* PRECONDITIONER_H */
@@ -0,0 +1,210 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   SolutionCache.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 24, 2026, 2:20 PM
+ */
+
+#include "SolutionCache.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+// The rows of a cache file
+static const size_t _ROW_X = 0, _ROW_B = 1, _ROW_DIAGONAL = 2, _ROW_SUMS = 3;
+static const size_t _NROWS = 4;
+
+static unsigned long long
+hashShape(size_t nrows, size_t ncols, unsigned long long seed) {
+    unsigned long long shape[2] = {nrows, ncols};
+    return (checksum(shape, sizeof (shape), seed));
+}
+
+unsigned long long
+fingerprint(const Matrix & A, const Vector & b) {
+    unsigned long long hash = hashShape(A.nrows(), A.ncols(), 14695981039346656037ULL);
+
+    // Rows are hashed separately because of the padding of the storage
+    for (size_t i = 0; i < A.nrows(); i++) {
+        hash = checksum(A[i], A.ncols() * sizeof (double), hash);
+    }
+
+    return (checksum(b.data(), b.size() * sizeof (double), hash));
+}
+
+unsigned long long
+fingerprint(const SparseMatrix & A, const Vector & b) {
+    unsigned long long hash = hashShape(A.nrows(), A.ncols(), 14695981039346656037ULL);
+
+    const vector<size_t> & row_ptr = A.rowPointers();
+    const vector<SparseMatrix::Index> & cols = A.columnIndices();
+    const vector<double> & values = A.values();
+
+    hash = checksum(row_ptr.data(), row_ptr.size() * sizeof (size_t), hash);
+    hash = checksum(cols.data(), cols.size() * sizeof (SparseMatrix::Index), hash);
+    hash = checksum(values.data(), values.size() * sizeof (double), hash);
+
+    return (checksum(b.data(), b.size() * sizeof (double), hash));
+}
+
+// The sketch of A, which is the diagonal and the row sums
+static void
+sketch(const LinearOperator & A, Vector & diag, Vector & sums) {
+    diag.resize(A.nrows());
+    for (size_t i = 0; i < A.nrows(); i++) diag[i] = A.diagonal(i);
+
+    Vector ones(A.ncols(), 1.0);
+    A.multiply(ones, sums);
+}
+
+// The L1 distance of x and row i of mat
+static double
+distanceToRow(const Vector & x, const Matrix & mat, size_t i) {
+    double distance = 0.0;
+    for (size_t j = 0; j < x.size(); j++) distance += abs(x[j] - mat[i][j]);
+    return (distance);
+}
+
+// Read a cache file of a system of size n. A file that can't be read,
+// e.g. a corrupt file, is skipped.
+//
+static bool
+readEntry(const string & cache_file, size_t n, Matrix & entry) {
+    try {
+        entry.readBinary(cache_file, true);
+    } catch (const exception &) {
+        return (false);
+    }
+
+    return (entry.nrows() == _NROWS && entry.ncols() == n);
+}
+
+SolutionCache::SolutionCache(const string & directory) :
+directory_(directory) {
+    if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw runtime_error("Error: The cache directory " + directory_ + " can't be created.");
+    }
+}
+
+SolutionCache::~SolutionCache() {
+}
+
+const string &
+SolutionCache::directory() const {
+    return (directory_);
+}
+
+string
+SolutionCache::file(unsigned long long key) const {
+    char name[32];
+    snprintf(name, sizeof (name), "%016llx.bin", key);
+    return (directory_ + "/" + name);
+}
+
+SolutionCache::Match
+SolutionCache::lookup(unsigned long long key, const LinearOperator & A,
+        const Vector & b, Vector & x, double & distance,
+        double max_distance) const {
+
+    size_t n = b.size();
+    Vector diag, sums;
+    sketch(A, diag, sums);
+
+    // The norm that the distances are relative to
+    double norm = norm1(b) + norm1(diag) + norm1(sums);
+    if (norm < _ZERO_LIMIT) norm = 1.0;
+
+    // The file of the fingerprint is only an exact match when b and the
+    // sketch are also the same, in case two systems share a fingerprint
+    //
+    string exact_file = file(key);
+    struct stat file_stat;
+    Matrix entry;
+
+    if (stat(exact_file.c_str(), &file_stat) == 0 && readEntry(exact_file, n, entry)) {
+        if (distanceToRow(b, entry, _ROW_B) == 0.0 &&
+                distanceToRow(diag, entry, _ROW_DIAGONAL) == 0.0 &&
+                distanceToRow(sums, entry, _ROW_SUMS) == 0.0) {
+            x.resize(n);
+            copy(entry[_ROW_X], entry[_ROW_X] + n, x.data());
+            distance = 0.0;
+            return (EXACT);
+        }
+    }
+
+    // Otherwise, all cached systems with the same size are compared
+    DIR *dir = opendir(directory_.c_str());
+    if (dir == nullptr) {
+        throw runtime_error("Error: The cache directory " + directory_ + " can't be opened.");
+    }
+
+    vector<string> files;
+    for (struct dirent *item = readdir(dir); item; item = readdir(dir)) {
+        string name(item->d_name);
+        if (name.size() == 20 && name.compare(16, 4, ".bin") == 0) {
+            files.push_back(directory_ + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    Match match = NONE;
+    distance = max_distance;
+
+    for (const string & cache_file : files) {
+        if (!readEntry(cache_file, n, entry)) continue;
+
+        double entry_distance = (distanceToRow(b, entry, _ROW_B) +
+                distanceToRow(diag, entry, _ROW_DIAGONAL) +
+                distanceToRow(sums, entry, _ROW_SUMS)) / norm;
+
+        if (entry_distance <= distance) {
+            x.resize(n);
+            copy(entry[_ROW_X], entry[_ROW_X] + n, x.data());
+            distance = entry_distance;
+            match = CLOSEST;
+        }
+    }
+
+    return (match);
+}
+
+void
+SolutionCache::store(unsigned long long key, const LinearOperator & A,
+        const Vector & b, const Vector & x) const {
+
+    if (b.size() != A.nrows() || x.size() != A.ncols() || A.nrows() != A.ncols()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    size_t n = b.size();
+    Vector diag, sums;
+    sketch(A, diag, sums);
+
+    Matrix entry(_NROWS, n);
+    const Vector * rows[_NROWS] = {&x, &b, &diag, &sums};
+    for (size_t i = 0; i < _NROWS; i++) {
+        copy(rows[i]->data(), rows[i]->data() + n, entry[i]);
+    }
+
+    // The file is written under a temporary name and renamed, so that
+    // other runs never read a partial file
+    //
+    string cache_file = file(key), temp_file = cache_file + ".tmp";
+    entry.writeBinary(temp_file);
+
+    if (rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+        remove(temp_file.c_str());
+        throw runtime_error("Error: The cache file " + cache_file + " can't be written.");
+    }
+}
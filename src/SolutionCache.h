@@ -0,0 +1,81 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   SolutionCache.h
+ * Author: Weiming Hu
+ *
+ * Created on October 24, 2026, 2:20 PM
+ */
+
+#ifndef SOLUTIONCACHE_H
+#define SOLUTIONCACHE_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "SparseMatrix.h"
+#include "LinearOperator.h"
+
+#include <string>
+
+// The largest relative distance of a system from a cached system, so that
+// the cached solution is still used as the initial guess
+//
+#ifndef SOLUTION_CACHE_DISTANCE
+#define SOLUTION_CACHE_DISTANCE 0.1
+#endif
+
+// The fingerprint of a system Ax = b, which is the checksum of the shape
+// and the stored values of A and b. Dense and sparse matrices with the same
+// values have different fingerprints.
+//
+unsigned long long fingerprint(const Matrix & A, const Vector & b);
+unsigned long long fingerprint(const SparseMatrix & A, const Vector & b);
+
+// An on-disk cache of converged solutions for repeated solves
+//
+// Every solution is a binary matrix file (see Matrix::writeBinary) in the
+// cache directory named after the fingerprint of its system. Besides the
+// solution x, it keeps b and a sketch of A, which is the diagonal and
+// the row sums of A, so that a similar system can be found.
+//
+// lookup() finds the file of the fingerprint first. Otherwise, the
+// solution of the closest system with the same size is used as the initial
+// guess, when the relative L1 distance of b and of the sketch of A is
+// not larger than max_distance.
+//
+class SolutionCache {
+public:
+
+    enum Match {
+        NONE,
+        CLOSEST,
+        EXACT
+    };
+
+    // The directory is created when it does not exist
+    SolutionCache(const std::string & directory);
+    virtual ~SolutionCache();
+
+    const std::string & directory() const;
+
+    // The path of the file of a fingerprint
+    std::string file(unsigned long long key) const;
+
+    // Find a solution of Ax = b. x is only changed when a solution is
+    // found. The relative distance of the cached system is returned in
+    // distance, which is 0 for an exact match.
+    //
+    Match lookup(unsigned long long key, const LinearOperator & A,
+            const Vector & b, Vector & x, double & distance,
+            double max_distance = SOLUTION_CACHE_DISTANCE) const;
+
+    // Save the solution x of Ax = b. An existing file of the same system
+    // is replaced.
+    //
+    void store(unsigned long long key, const LinearOperator & A,
+            const Vector & b, const Vector & x) const;
+
+private:
+    std::string directory_;
+};
+
+#endif /* SOLUTIONCACHE_H */
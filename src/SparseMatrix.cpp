@@ -0,0 +1,867 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   SparseMatrix.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 20, 2026, 11:20 AM
+ */
+
+#include "SparseMatrix.h"
+#include "CsvParser.h"
+#include "ExecutionContext.h"
+
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _USE_NETCDF
+#include <netcdf.h>
+#endif
+
+using namespace std;
+static const double _ZERO_LIMIT = 1.0e-9;
+
+// The magic string of binary matrix files. Please see Matrix::readBinary.
+static const char _FILE_MAGIC[8] = {'C', 'S', 'E', 'M', 'A', 'T', 'R', 'X'};
+
+// The header of Matrix Market files
+static const char _MM_BANNER[] = "%%MatrixMarket";
+
+static void
+checkColumns(size_t ncols) {
+    if (ncols > numeric_limits<SparseMatrix::Index>::max()) {
+        throw runtime_error("Error: Too many columns for the sparse matrix.");
+    }
+}
+
+static inline bool
+isBlank(char c) {
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+// Parse an unsigned integer from [p, end) after skipping blanks. The
+// pointer after the number is returned, or nullptr when there is none.
+//
+static const char *
+parseIndex(const char *p, const char *end, size_t & value) {
+    while (p < end && isBlank(*p)) p++;
+    if (p == end || *p < '0' || *p > '9') return (nullptr);
+
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        value = value * 10 + (*p - '0');
+    }
+
+    return (p);
+}
+
+SparseMatrix::SparseMatrix() {
+    row_ptr_.assign(1, 0);
+}
+
+SparseMatrix::SparseMatrix(const Matrix & A, double drop_tolerance) :
+nrows_(A.nrows()), ncols_(A.ncols()) {
+
+    checkColumns(ncols_);
+
+    // The first pass counts the values of each row so that the storage
+    // is allocated once
+    //
+    long nrows = nrows_;
+    size_t ncols = ncols_;
+    row_ptr_.assign(nrows_ + 1, 0);
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(A, nrows, ncols, drop_tolerance)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        const double *a = A[i];
+        size_t count = 0;
+        for (size_t j = 0; j < ncols; j++) {
+            if (abs(a[j]) > drop_tolerance) count++;
+        }
+        row_ptr_[i + 1] = count;
+    }
+
+    partial_sum(row_ptr_.begin(), row_ptr_.end(), row_ptr_.begin());
+    cols_.resize(row_ptr_[nrows_]);
+    values_.resize(row_ptr_[nrows_]);
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(A, nrows, ncols, drop_tolerance)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        const double *a = A[i];
+        size_t pos = row_ptr_[i];
+        for (size_t j = 0; j < ncols; j++) {
+            if (abs(a[j]) > drop_tolerance) {
+                cols_[pos] = j;
+                values_[pos] = a[j];
+                pos++;
+            }
+        }
+    }
+
+    finalize();
+}
+
+SparseMatrix::SparseMatrix(size_t nrows, size_t ncols,
+        const vector<size_t> & rows, const vector<size_t> & cols,
+        const vector<double> & values) :
+nrows_(nrows), ncols_(ncols) {
+
+    checkColumns(ncols_);
+
+    if (rows.size() != cols.size() || rows.size() != values.size()) {
+        throw runtime_error("Error: The triplets do not have the same length.");
+    }
+
+    // Sort the triplets by rows with a counting sort
+    vector<size_t> offsets(nrows_ + 1, 0);
+    for (size_t k = 0; k < rows.size(); k++) {
+        if (rows[k] >= nrows_ || cols[k] >= ncols_) {
+            ostringstream message;
+            message << "Error: The value at (" << rows[k] << ", " << cols[k]
+                    << ") is out of the " << nrows_ << " x " << ncols_ << " matrix.";
+            throw runtime_error(message.str());
+        }
+        offsets[rows[k] + 1]++;
+    }
+
+    partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    vector< pair<Index, double> > entries(rows.size());
+    vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t k = 0; k < rows.size(); k++) {
+        entries[next[rows[k]]++] = make_pair((Index) cols[k], values[k]);
+    }
+
+    // Sort each row by columns and add up the duplicates. The sort is
+    // stable so that the duplicates are always added in the same order.
+    //
+    row_ptr_.assign(nrows_ + 1, 0);
+    cols_.reserve(entries.size());
+    values_.reserve(entries.size());
+
+    for (size_t i = 0; i < nrows_; i++) {
+        auto begin = entries.begin() + offsets[i], end = entries.begin() + offsets[i + 1];
+        stable_sort(begin, end, [](const pair<Index, double> & lhs,
+                const pair<Index, double> & rhs) {
+            return (lhs.first < rhs.first);
+        });
+
+        for (auto it = begin; it != end; it++) {
+            if (cols_.size() > row_ptr_[i] && cols_.back() == it->first) {
+                values_.back() += it->second;
+            } else {
+                cols_.push_back(it->first);
+                values_.push_back(it->second);
+            }
+        }
+
+        row_ptr_[i + 1] = cols_.size();
+    }
+
+    finalize();
+}
+
+SparseMatrix::~SparseMatrix() {
+}
+
+void
+SparseMatrix::finalize() {
+    diag_.assign(nrows_, 0.0);
+    for (size_t i = 0; i < nrows_ && i < ncols_; i++) {
+        diag_[i] = value(i, i);
+    }
+
+    // The chunks are out of date
+    layout_ = CSR;
+    sell_ptr_.clear();
+    sell_cols_.clear();
+    sell_values_.clear();
+    sell_rows_.clear();
+}
+
+size_t
+SparseMatrix::nrows() const {
+    return (nrows_);
+}
+
+size_t
+SparseMatrix::ncols() const {
+    return (ncols_);
+}
+
+size_t
+SparseMatrix::nnz() const {
+    return (values_.size());
+}
+
+const vector<size_t> &
+SparseMatrix::rowPointers() const {
+    return (row_ptr_);
+}
+
+const vector<SparseMatrix::Index> &
+SparseMatrix::columnIndices() const {
+    return (cols_);
+}
+
+const vector<double> &
+SparseMatrix::values() const {
+    return (values_);
+}
+
+double
+SparseMatrix::value(size_t i, size_t j) const {
+    auto begin = cols_.begin() + row_ptr_[i], end = cols_.begin() + row_ptr_[i + 1];
+    auto it = lower_bound(begin, end, (Index) j);
+
+    if (it != end && *it == j) return (values_[it - cols_.begin()]);
+    return (0.0);
+}
+
+void
+SparseMatrix::setLayout(Layout layout, size_t sigma) {
+    sell_ptr_.clear();
+    sell_cols_.clear();
+    sell_values_.clear();
+    sell_rows_.clear();
+    layout_ = CSR;
+    sell_sigma_ = 0;
+
+    if (layout == CSR) return;
+
+    if (sigma == 0) {
+        throw runtime_error("Error: The sorting window of SELL-C-sigma should be positive.");
+    }
+
+    size_t C = SPARSE_SELL_C;
+    size_t nchunks = (nrows_ + C - 1) / C;
+
+    // Sort the rows by their lengths within each window. The sort is
+    // stable so that rows of the same length keep their order.
+    //
+    vector<size_t> order(nchunks * C, nrows_);
+    iota(order.begin(), order.begin() + nrows_, 0);
+
+    for (size_t w = 0; w < nrows_; w += sigma) {
+        stable_sort(order.begin() + w, order.begin() + min(w + sigma, nrows_),
+                [this](size_t lhs, size_t rhs) {
+                    return (row_ptr_[lhs + 1] - row_ptr_[lhs] > row_ptr_[rhs + 1] - row_ptr_[rhs]);
+                });
+    }
+
+    // Every chunk is padded to its longest row
+    sell_ptr_.assign(nchunks + 1, 0);
+    for (size_t c = 0; c < nchunks; c++) {
+        size_t width = 0;
+        for (size_t r = 0; r < C; r++) {
+            size_t i = order[c * C + r];
+            if (i < nrows_) width = max(width, row_ptr_[i + 1] - row_ptr_[i]);
+        }
+        sell_ptr_[c + 1] = sell_ptr_[c] + width * C;
+    }
+
+    sell_rows_.swap(order);
+    sell_cols_.resize(sell_ptr_[nchunks]);
+    sell_values_.resize(sell_ptr_[nchunks]);
+
+    // Padded values are 0 and they read the first column
+    long nchunks_fill = nchunks;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(sell_ptr_[nchunks]);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) shared(nchunks_fill, C)
+#endif
+    for (long c = 0; c < nchunks_fill; c++) {
+        size_t base = sell_ptr_[c], width = (sell_ptr_[c + 1] - base) / C;
+
+        for (size_t r = 0; r < C; r++) {
+            size_t i = sell_rows_[c * C + r];
+            size_t len = (i < nrows_ ? row_ptr_[i + 1] - row_ptr_[i] : 0);
+
+            for (size_t k = 0; k < width; k++) {
+                size_t pos = base + k * C + r;
+                if (k < len) {
+                    sell_cols_[pos] = cols_[row_ptr_[i] + k];
+                    sell_values_[pos] = values_[row_ptr_[i] + k];
+                } else {
+                    sell_cols_[pos] = 0;
+                    sell_values_[pos] = 0.0;
+                }
+            }
+        }
+    }
+
+    layout_ = SELL;
+    sell_sigma_ = sigma;
+}
+
+SparseMatrix::Layout
+SparseMatrix::layout() const {
+    return (layout_);
+}
+
+void
+SparseMatrix::multiply(const Vector & x, Vector & y) const {
+    if (x.size() != ncols_) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    y.resize(nrows_);
+
+    if (layout_ == SELL) multiplySell(x.data(), y.data());
+    else multiplyCsr(x.data(), y.data());
+}
+
+void
+SparseMatrix::multiplyBlock(const Matrix & X, Matrix & Y) const {
+    if (X.nrows() != ncols_) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    Y.resize(nrows_, X.ncols());
+
+    long nrows = nrows_;
+    size_t k = X.ncols();
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(values_.size() * k);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(X, Y, nrows, k)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        double *py = Y[i];
+        fill(py, py + k, 0.0);
+
+        for (size_t pos = row_ptr_[i]; pos < row_ptr_[i + 1]; pos++) {
+            const double *px = X[cols_[pos]];
+            double v = values_[pos];
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+            for (size_t j = 0; j < k; j++) {
+                py[j] += v * px[j];
+            }
+        }
+    }
+}
+
+void
+SparseMatrix::multiplyCsr(const double *px, double *py) const {
+    long nrows = nrows_;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(values_.size());
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(px, py, nrows)
+#endif
+    for (long i = 0; i < nrows; i++) {
+        py[i] = SparseMatrix::rowProduct(i, px);
+    }
+}
+
+void
+SparseMatrix::multiplySell(const double *px, double *py) const {
+    long nchunks = sell_ptr_.size() - 1;
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(sell_values_.size());
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) \
+shared(px, py, nchunks)
+#endif
+    for (long c = 0; c < nchunks; c++) {
+        multiplyChunk(c, px, py);
+    }
+}
+
+void
+SparseMatrix::multiplyChunk(size_t c, const double *px, double *py) const {
+    const size_t C = SPARSE_SELL_C;
+    size_t base = sell_ptr_[c], width = (sell_ptr_[c + 1] - base) / C;
+    const double *v = sell_values_.data() + base;
+    const Index *col = sell_cols_.data() + base;
+
+    double sums[SPARSE_SELL_C] = {0.0};
+
+    for (size_t k = 0; k < width; k++) {
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (size_t r = 0; r < C; r++) {
+            sums[r] += v[k * C + r] * px[col[k * C + r]];
+        }
+    }
+
+    for (size_t r = 0; r < C; r++) {
+        size_t i = sell_rows_[c * C + r];
+        if (i < nrows_) py[i] = sums[r];
+    }
+}
+
+size_t
+SparseMatrix::rowAlignment() const {
+    if (layout_ != SELL) return (1);
+
+    // The least common multiple of sigma and C
+    size_t a = sell_sigma_, b = SPARSE_SELL_C;
+    while (b != 0) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return (sell_sigma_ / a * SPARSE_SELL_C);
+}
+
+void
+SparseMatrix::multiplyRows(size_t begin, size_t end,
+        const double * x, double * y) const {
+
+    size_t alignment = rowAlignment();
+
+    if (layout_ == SELL && begin % alignment == 0 &&
+            (end % alignment == 0 || end == nrows_)) {
+        size_t C = SPARSE_SELL_C;
+        for (size_t c = begin / C; c < (end + C - 1) / C; c++) {
+            multiplyChunk(c, x, y);
+        }
+    } else {
+        for (size_t i = begin; i < end; i++) {
+            y[i] = SparseMatrix::rowProduct(i, x);
+        }
+    }
+}
+
+double
+SparseMatrix::rowProduct(size_t i, const double * x) const {
+    size_t begin = row_ptr_[i], end = row_ptr_[i + 1];
+    const Index *col = cols_.data();
+    const double *v = values_.data();
+    double sum = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+    for (size_t k = begin; k < end; k++) {
+        sum += v[k] * x[col[k]];
+    }
+
+    return (sum);
+}
+
+bool
+SparseMatrix::rowPattern(size_t i, vector<size_t> & cols) const {
+    cols.assign(cols_.begin() + row_ptr_[i], cols_.begin() + row_ptr_[i + 1]);
+    return (true);
+}
+
+double
+SparseMatrix::diagonal(size_t i) const {
+    return (diag_[i]);
+}
+
+bool
+SparseMatrix::checkDominant() const {
+    for (size_t i = 0; i < nrows_; i++) {
+        double sum = 0.0;
+        for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+            sum += abs(values_[k]);
+        }
+        if (diag_[i] < sum - diag_[i]) {
+            return false;
+        }
+    }
+    return (true);
+}
+
+Matrix
+SparseMatrix::toMatrix() const {
+    Matrix A(nrows_, ncols_);
+    for (size_t i = 0; i < nrows_; i++) {
+        for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+            A[i][cols_[k]] = values_[k];
+        }
+    }
+    return (A);
+}
+
+bool
+SparseMatrix::readMatrix(const string & file, double drop_tolerance) {
+    string nc_file, var_name;
+    if (netcdfVariable(file, nc_file, var_name)) {
+        return (readNetCDF(nc_file, var_name, drop_tolerance));
+    }
+
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw runtime_error("Error: The file is empty.");
+    }
+
+    size_t length = file_stat.st_size;
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        throw runtime_error("Error: The file can't be mapped.");
+    }
+
+    const char *text = static_cast<const char *> (base);
+
+    // Binary files are mapped by Matrix and converted
+    if (length >= sizeof (_FILE_MAGIC) &&
+            memcmp(text, _FILE_MAGIC, sizeof (_FILE_MAGIC)) == 0) {
+        munmap(base, length);
+
+        Matrix A;
+        A.readBinary(file);
+        *this = SparseMatrix(A, drop_tolerance);
+        return (true);
+    }
+
+    try {
+        if (length >= strlen(_MM_BANNER) &&
+                memcmp(text, _MM_BANNER, strlen(_MM_BANNER)) == 0) {
+            readCoordinate(text, length);
+        } else {
+            readCsv(text, length, drop_tolerance);
+        }
+    } catch (...) {
+        munmap(base, length);
+        throw;
+    }
+
+    munmap(base, length);
+    return (true);
+}
+
+void
+SparseMatrix::readCoordinate(const char *text, size_t length) {
+
+    // The header is %%MatrixMarket matrix coordinate <field> <symmetry>
+    const char *eol = static_cast<const char *> (memchr(text, '\n', length));
+    string header(text, eol ? eol - text : length);
+    transform(header.begin(), header.end(), header.begin(), ::tolower);
+
+    istringstream header_stream(header);
+    string banner, object, format, field, symmetry;
+    header_stream >> banner >> object >> format >> field >> symmetry;
+
+    if (object != "matrix" || format != "coordinate") {
+        throw runtime_error("Error: Only Matrix Market files in the coordinate format are supported.");
+    }
+
+    if (field != "real" && field != "integer" && field != "pattern") {
+        throw runtime_error("Error: Only real, integer, and pattern Matrix Market files are supported.");
+    }
+
+    if (symmetry != "general" && symmetry != "symmetric") {
+        throw runtime_error("Error: Only general and symmetric Matrix Market files are supported.");
+    }
+
+    bool pattern = (field == "pattern"), symmetric = (symmetry == "symmetric");
+
+    // The size line comes after the comments
+    size_t nrows = 0, ncols = 0, nentries = 0, count = 0, pos = 0;
+    bool has_size = false;
+    vector<size_t> rows, cols;
+    vector<double> values;
+
+    while (pos < length) {
+        eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+        const char *p = text + pos, *line_end = (eol ? eol : text + length);
+        pos = line_end - text + 1;
+
+        if (*p == '%' || isEmptyLine(p, line_end)) continue;
+
+        if (!has_size) {
+            if (!(p = parseIndex(p, line_end, nrows)) || !(p = parseIndex(p, line_end, ncols)) ||
+                    !(p = parseIndex(p, line_end, nentries))) {
+                throw runtime_error("Error: The size line of the Matrix Market file can't be parsed.");
+            }
+
+            has_size = true;
+            rows.reserve(symmetric ? 2 * nentries : nentries);
+            cols.reserve(rows.capacity());
+            values.reserve(rows.capacity());
+            continue;
+        }
+
+        size_t i = 0, j = 0;
+        double value = 1.0;
+        p = parseIndex(p, line_end, i);
+        if (p) p = parseIndex(p, line_end, j);
+        if (p && !pattern) {
+            while (p < line_end && isBlank(*p)) p++;
+            p = parseDouble(p, line_end, value);
+        }
+
+        if (!p || i == 0 || j == 0) {
+            ostringstream message;
+            message << "Error: Entry " << count << " of the Matrix Market file can't be parsed.";
+            throw runtime_error(message.str());
+        }
+
+        // Indices are 1-based
+        rows.push_back(i - 1);
+        cols.push_back(j - 1);
+        values.push_back(value);
+
+        if (symmetric && i != j) {
+            rows.push_back(j - 1);
+            cols.push_back(i - 1);
+            values.push_back(value);
+        }
+
+        count++;
+    }
+
+    if (!has_size || count != nentries) {
+        ostringstream message;
+        message << "Error: The Matrix Market file has " << count << " entries but "
+                << nentries << " are expected.";
+        throw runtime_error(message.str());
+    }
+
+    *this = SparseMatrix(nrows, ncols, rows, cols, values);
+}
+
+void
+SparseMatrix::readCsv(const char *text, size_t length, double drop_tolerance) {
+
+    // The file is split into chunks of lines as in Matrix::readMatrix.
+    // Each chunk keeps the values of its rows, and the chunks are joined
+    // after the number of values of every row is known.
+    //
+    size_t nchunks = 1;
+    int nthreads = ExecutionContext::current().threads(length);
+    if (nthreads > 1) nchunks = 4 * nthreads;
+
+    vector<size_t> chunk_begin(nchunks + 1);
+    for (size_t c = 0; c < nchunks; c++) {
+        chunk_begin[c] = lineStart(text, length, c * length / nchunks);
+    }
+    chunk_begin[nchunks] = length;
+
+    // The number of columns is decided by the first row
+    size_t ncols = 0, pos = 0;
+    while (pos < length && ncols == 0) {
+        const char *eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+        const char *line_end = (eol ? eol : text + length);
+        if (!isEmptyLine(text + pos, line_end) &&
+                !parseLine(text + pos, line_end, nullptr, 0, ncols)) {
+            throw runtime_error("Error: The first row of the csv file can't be parsed.");
+        }
+        pos = line_end - text + 1;
+    }
+
+    if (ncols == 0) {
+        throw runtime_error("Error: The file is empty.");
+    }
+
+    checkColumns(ncols);
+
+    vector< vector<size_t> > chunk_lengths(nchunks);
+    vector< vector<Index> > chunk_cols(nchunks);
+    vector< vector<double> > chunk_values(nchunks);
+
+    // The first bad row of each chunk, relative to the chunk
+    vector<size_t> bad_rows(nchunks, length), bad_counts(nchunks, 0);
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads) default(none) \
+shared(nchunks, chunk_begin, text, length, ncols, drop_tolerance, chunk_lengths, chunk_cols, chunk_values, bad_rows, bad_counts)
+#endif
+    {
+        vector<double> row(ncols);
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+        for (size_t c = 0; c < nchunks; c++) {
+            size_t pos = chunk_begin[c], count = 0;
+
+            while (pos < chunk_begin[c + 1]) {
+                const char *eol = static_cast<const char *> (memchr(text + pos, '\n', length - pos));
+                const char *line_end = (eol ? eol : text + length);
+
+                if (!isEmptyLine(text + pos, line_end)) {
+                    bool ok = parseLine(text + pos, line_end, row.data(), ncols, count);
+
+                    if (!ok || count != ncols) {
+                        bad_rows[c] = chunk_lengths[c].size();
+                        bad_counts[c] = (ok ? count : 0);
+                        break;
+                    }
+
+                    size_t nnz = 0;
+                    for (size_t j = 0; j < ncols; j++) {
+                        if (abs(row[j]) > drop_tolerance) {
+                            chunk_cols[c].push_back(j);
+                            chunk_values[c].push_back(row[j]);
+                            nnz++;
+                        }
+                    }
+                    chunk_lengths[c].push_back(nnz);
+                }
+
+                pos = line_end - text + 1;
+            }
+        }
+    }
+
+    // Offsets of the first row and the first value of each chunk
+    vector<size_t> row_offsets(nchunks + 1, 0), value_offsets(nchunks + 1, 0);
+    for (size_t c = 0; c < nchunks; c++) {
+        if (bad_rows[c] != length) {
+            ostringstream message;
+            message << "Error: Row " << row_offsets[c] + bad_rows[c] << " of the csv file ";
+            if (bad_counts[c] == 0) message << "can't be parsed.";
+            else message << "has " << bad_counts[c] << " values but " << ncols << " are expected.";
+            throw runtime_error(message.str());
+        }
+
+        row_offsets[c + 1] = row_offsets[c] + chunk_lengths[c].size();
+        value_offsets[c + 1] = value_offsets[c] + chunk_values[c].size();
+    }
+
+    nrows_ = row_offsets[nchunks];
+    ncols_ = ncols;
+    row_ptr_.assign(nrows_ + 1, 0);
+    cols_.resize(value_offsets[nchunks]);
+    values_.resize(value_offsets[nchunks]);
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(dynamic) \
+shared(nchunks, row_offsets, value_offsets, chunk_lengths, chunk_cols, chunk_values)
+#endif
+    for (size_t c = 0; c < nchunks; c++) {
+        size_t ptr = value_offsets[c];
+        for (size_t k = 0; k < chunk_lengths[c].size(); k++) {
+            ptr += chunk_lengths[c][k];
+            row_ptr_[row_offsets[c] + k + 1] = ptr;
+        }
+
+        copy(chunk_cols[c].begin(), chunk_cols[c].end(), cols_.begin() + value_offsets[c]);
+        copy(chunk_values[c].begin(), chunk_values[c].end(), values_.begin() + value_offsets[c]);
+
+        // Release the chunk early to reduce the peak memory
+        vector<Index>().swap(chunk_cols[c]);
+        vector<double>().swap(chunk_values[c]);
+    }
+
+    finalize();
+}
+
+bool
+SparseMatrix::readNetCDF(const string & nc_file, const string & var_name,
+        double drop_tolerance) {
+#ifdef _USE_NETCDF
+    int ncid = -1, varid = -1, ndims = -1;
+    int dimids[NC_MAX_VAR_DIMS];
+    size_t dimlens[2] = {0, 0};
+
+    checkNetCDF(nc_open(nc_file.c_str(), NC_NOWRITE, &ncid));
+
+    try {
+        checkNetCDF(nc_inq_varid(ncid, var_name.c_str(), &varid));
+        checkNetCDF(nc_inq_varndims(ncid, varid, &ndims));
+
+        if (ndims != 2) {
+            throw runtime_error("Error: Only 2-dimensional variables can be read as a matrix.");
+        }
+
+        checkNetCDF(nc_inq_vardimid(ncid, varid, dimids));
+        for (int i = 0; i < ndims; i++) {
+            checkNetCDF(nc_inq_dimlen(ncid, dimids[i], dimlens + i));
+        }
+
+        // The first dimension is the column and the second dimension is the
+        // row. A block of columns is read at a time, so the buffer holds
+        // about 4M values however large the matrix is.
+        //
+        size_t nrows = dimlens[1], ncols = dimlens[0];
+        size_t block = max((size_t) 1, ((size_t) 1 << 22) / max(nrows, (size_t) 1));
+        vector<double> buffer(min(block, ncols) * nrows);
+        vector<size_t> rows, cols;
+        vector<double> values;
+
+        for (size_t c0 = 0; c0 < ncols; c0 += block) {
+            size_t start[2] = {c0, 0}, count[2] = {min(block, ncols - c0), nrows};
+            checkNetCDF(nc_get_vara_double(ncid, varid, start, count, buffer.data()));
+
+            for (size_t j = 0; j < count[0]; j++) {
+                for (size_t i = 0; i < nrows; i++) {
+                    double value = buffer[j * nrows + i];
+                    if (abs(value) > drop_tolerance) {
+                        rows.push_back(i);
+                        cols.push_back(c0 + j);
+                        values.push_back(value);
+                    }
+                }
+            }
+        }
+
+        *this = SparseMatrix(nrows, ncols, rows, cols, values);
+
+    } catch (...) {
+        nc_close(ncid);
+        throw;
+    }
+
+    checkNetCDF(nc_close(ncid));
+    return (true);
+#else
+    (void) nc_file;
+    (void) var_name;
+    (void) drop_tolerance;
+    throw runtime_error("Error: The program is not built with NetCDF.");
+#endif
+}
+
+void
+SparseMatrix::print(ostream & os) const {
+    os << "SparseMatrix [" << nrows_ << "][" << ncols_ << "] with "
+            << nnz() << " values:" << endl;
+
+    for (size_t i = 0; i < nrows_; i++) {
+        for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+            os << "[" << i << ", " << cols_[k] << "]\t" << values_[k] << endl;
+        }
+    }
+    os << endl;
+}
+
+ostream &
+operator<<(ostream & os, const SparseMatrix & mat) {
+    mat.print(os);
+    return (os);
+}
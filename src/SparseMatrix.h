@@ -0,0 +1,163 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   SparseMatrix.h
+ * Author: Weiming Hu
+ *
+ * Created on October 20, 2026, 11:20 AM
+ */
+
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+// Number of rows in a chunk of the SELL-C-sigma layout. It should be the
+// number of doubles in a SIMD register or a multiple of it.
+//
+#ifndef SPARSE_SELL_C
+#define SPARSE_SELL_C 8
+#endif
+
+// Number of rows that are sorted by their lengths in the SELL-C-sigma
+// layout. Larger windows need less padding, but x is read less locally.
+//
+#ifndef SPARSE_SELL_SIGMA
+#define SPARSE_SELL_SIGMA 256
+#endif
+
+// Sparse matrix in the compressed sparse row (CSR) format
+//
+// The values of row i are values()[rowPointers()[i], rowPointers()[i + 1])
+// and their columns are in columnIndices(), sorted within each row. The
+// column indices are 32-bit to reduce the memory traffic of the mat-vec.
+//
+// Optionally, the mat-vec can use the SELL-C-sigma layout. Rows are sorted
+// by their lengths within windows of sigma rows, and every C rows form a
+// chunk that is padded to its longest row and stored column by column, so
+// that the C rows of a chunk are processed together in SIMD lanes. The CSR
+// storage is kept for the row products of the Gauss-Seidel sweeps.
+//
+class SparseMatrix : public LinearOperator {
+public:
+    typedef unsigned int Index;
+
+    enum Layout {
+        CSR,
+        SELL
+    };
+
+    SparseMatrix();
+
+    // Convert a dense matrix. Values with an absolute value not larger
+    // than drop_tolerance are not stored.
+    //
+    explicit SparseMatrix(const Matrix & A, double drop_tolerance = 0.0);
+
+    // Build from the triplets (rows[k], cols[k], values[k]). Values of the
+    // same row and column are added up.
+    //
+    SparseMatrix(std::size_t nrows, std::size_t ncols,
+            const std::vector<std::size_t> & rows,
+            const std::vector<std::size_t> & cols,
+            const std::vector<double> & values);
+
+    virtual ~SparseMatrix();
+
+    std::size_t nrows() const override;
+    std::size_t ncols() const override;
+
+    // Number of stored values
+    std::size_t nnz() const;
+
+    const std::vector<std::size_t> & rowPointers() const;
+    const std::vector<Index> & columnIndices() const;
+    const std::vector<double> & values() const;
+
+    // The value (i, j), which is 0 when it is not stored
+    double value(std::size_t i, std::size_t j) const;
+
+    // Choose the layout of the mat-vec. sigma is only used by SELL.
+    void setLayout(Layout layout, std::size_t sigma = SPARSE_SELL_SIGMA);
+    Layout layout() const;
+
+    // The interface of the iterative solvers. Please see LinearOperator.h.
+    void multiply(const Vector & x, Vector & y) const override;
+    double rowProduct(std::size_t i, const double * x) const override;
+    bool rowPattern(std::size_t i, std::vector<std::size_t> & cols) const override;
+    double diagonal(std::size_t i) const override;
+    bool checkDominant() const override;
+
+    // Y = A * X with the CSR layout, so that every stored value is read
+    // once for all columns of X
+    //
+    void multiplyBlock(const Matrix & X, Matrix & Y) const override;
+
+    // With SELL, the aligned ranges are whole sorting windows, which are
+    // multiplied with the chunks. Other ranges use the CSR storage.
+    //
+    void multiplyRows(std::size_t begin, std::size_t end,
+            const double * x, double * y) const override;
+    std::size_t rowAlignment() const override;
+
+    Matrix toMatrix() const;
+
+    // Read a sparse matrix from a file without forming the dense matrix
+    //
+    // Matrix Market coordinate files (general or symmetric) are detected
+    // by their header, and binary matrix files (see Matrix::writeBinary)
+    // by their magic string. Paths of NetCDF variables (see netcdfVariable
+    // in Matrix.h) are read with readNetCDF. Other files are parsed as
+    // dense csv files, where values not larger than drop_tolerance are
+    // dropped row by row.
+    //
+    bool readMatrix(const std::string & file, double drop_tolerance = 0.0);
+
+    // Read a 2-dimensional variable from a NetCDF file generated by
+    // data/ncdf4/generate_test.R, a block of columns at a time. Without
+    // NetCDF, an exception is thrown.
+    //
+    bool readNetCDF(const std::string & nc_file, const std::string & var_name,
+            double drop_tolerance = 0.0);
+
+    // Print the stored values as (row, column) value
+    void print(std::ostream &) const override;
+    friend std::ostream & operator<<(std::ostream &, const SparseMatrix &);
+
+private:
+    std::size_t nrows_ = 0;
+    std::size_t ncols_ = 0;
+
+    std::vector<std::size_t> row_ptr_;
+    std::vector<Index> cols_;
+    std::vector<double> values_;
+    std::vector<double> diag_;
+
+    // The SELL-C-sigma layout. Chunk c starts at sell_ptr_[c] and the value
+    // of lane r in column k of the chunk is at sell_ptr_[c] + k * C + r.
+    // sell_rows_ has the row of every lane, or nrows_ for padded lanes.
+    //
+    Layout layout_ = CSR;
+    std::size_t sell_sigma_ = 0;
+    std::vector<std::size_t> sell_ptr_;
+    std::vector<Index> sell_cols_;
+    std::vector<double> sell_values_;
+    std::vector<std::size_t> sell_rows_;
+
+    // Check the shape and set up the diagonal after the CSR storage is built
+    void finalize();
+
+    void readCoordinate(const char *text, std::size_t length);
+    void readCsv(const char *text, std::size_t length, double drop_tolerance);
+
+    void multiplyCsr(const double *px, double *py) const;
+    void multiplySell(const double *px, double *py) const;
+    void multiplyChunk(std::size_t c, const double *px, double *py) const;
+};
+
+#endif /* SPARSEMATRIX_H */
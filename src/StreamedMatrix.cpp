@@ -0,0 +1,387 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   StreamedMatrix.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 27, 2026, 9:15 AM
+ */
+
+#include "StreamedMatrix.h"
+#include "ExecutionContext.h"
+#include "Gemm.h"
+
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+StreamedMatrix::StreamedMatrix() {
+}
+
+StreamedMatrix::StreamedMatrix(const string & bin_file, size_t panel_bytes) :
+file_(bin_file) {
+
+    binaryLayout(file_, nrows_, ncols_, data_offset_);
+
+    fd_ = open(file_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw runtime_error("File can't be opened.");
+    }
+
+    panel_rows_ = max((size_t) 1, panel_bytes / max(ncols_ * sizeof (double), (size_t) 1));
+    panel_rows_ = min(panel_rows_, max(nrows_, (size_t) 1));
+    buffers_[0].resize(panel_rows_ * ncols_);
+    buffers_[1].resize(panel_rows_ * ncols_);
+
+    // The panels of rowProduct() are only allocated when it is called
+    row_panel_rows_ = max((size_t) 1, panel_rows_ / 2);
+
+    // One pass over the file finds the diagonal and whether every row is
+    // diagonally dominant
+    //
+    diag_ = Vector(nrows_, 0.0);
+    vector<char> dominant(nrows_, 1);
+
+    stream([this, &dominant](size_t begin, size_t end, const double * rows) {
+        for (size_t i = begin; i < end; i++) {
+            const double *row = rows + (i - begin) * ncols_;
+
+            double sum = 0.0;
+            for (size_t j = 0; j < ncols_; j++) sum += abs(row[j]);
+
+            if (i < ncols_) diag_[i] = row[i];
+            dominant[i] = !(diag_[i] < sum - diag_[i]);
+        }
+    });
+
+    dominant_ = (find(dominant.begin(), dominant.end(), 0) == dominant.end());
+}
+
+StreamedMatrix::~StreamedMatrix() {
+
+    // The panel that is read ahead is not freed while it is written
+    if (prefetching_) finishRead(row_request_);
+    if (fd_ >= 0) close(fd_);
+}
+
+size_t
+StreamedMatrix::nrows() const {
+    return (nrows_);
+}
+
+size_t
+StreamedMatrix::ncols() const {
+    return (ncols_);
+}
+
+size_t
+StreamedMatrix::panelRows() const {
+    return (panel_rows_);
+}
+
+bool
+StreamedMatrix::readRows(size_t begin, size_t count, double * buffer) const {
+    size_t nbytes = count * ncols_ * sizeof (double), nread = 0;
+    size_t offset = data_offset_ + begin * ncols_ * sizeof (double);
+    char *p = reinterpret_cast<char *> (buffer);
+
+    while (nread < nbytes) {
+        ssize_t ret = pread(fd_, p + nread, nbytes - nread, offset + nread);
+        if (ret <= 0) return (false);
+        nread += ret;
+    }
+
+    return (true);
+}
+
+bool
+StreamedMatrix::startRead(size_t begin, size_t count, double * buffer,
+        struct aiocb & request) const {
+
+    memset(&request, 0, sizeof (request));
+    request.aio_fildes = fd_;
+    request.aio_offset = data_offset_ + begin * ncols_ * sizeof (double);
+    request.aio_buf = buffer;
+    request.aio_nbytes = count * ncols_ * sizeof (double);
+    request.aio_sigevent.sigev_notify = SIGEV_NONE;
+
+    return (fd_ >= 0 && aio_read(&request) == 0);
+}
+
+bool
+StreamedMatrix::finishRead(struct aiocb & request) const {
+    const struct aiocb *requests[1] = {&request};
+
+    int error;
+    while ((error = aio_error(&request)) == EINPROGRESS) {
+        aio_suspend(requests, 1, nullptr);
+    }
+
+    ssize_t ret = aio_return(&request);
+    if (error != 0 || ret < 0) return (false);
+
+    // The rest of a short read, which starts within a row
+    size_t nread = ret;
+    char *p = static_cast<char *> (const_cast<void *> (request.aio_buf));
+
+    while (nread < request.aio_nbytes) {
+        ret = pread(fd_, p + nread, request.aio_nbytes - nread, request.aio_offset + nread);
+        if (ret <= 0) return (false);
+        nread += ret;
+    }
+
+    return (true);
+}
+
+void
+StreamedMatrix::readRow(size_t i, Vector & values) const {
+    if (i >= nrows_) {
+        throw runtime_error("Error: The row is out of the matrix.");
+    }
+
+    values.resize(ncols_);
+
+    if (!readRows(i, 1, values.data())) {
+        throw runtime_error("Error: Failed to read the binary matrix file.");
+    }
+}
+
+void
+StreamedMatrix::stream(const function<void(size_t begin, size_t end,
+        const double * rows)> & compute) const {
+
+    size_t npanels = (nrows_ + panel_rows_ - 1) / panel_rows_;
+    if (npanels == 0) return;
+
+    double *buffers[2] = {buffers_[0].data(), buffers_[1].data()};
+    bool failed = !readRows(0, min(panel_rows_, nrows_), buffers[0]);
+
+#if defined(_OPENMP)
+    int nthreads = ExecutionContext::current().threads(nrows_ * ncols_);
+#pragma omp parallel num_threads(nthreads) default(none) \
+shared(compute, buffers, npanels, failed)
+#endif
+    {
+        int tid = 0, team = 1;
+#if defined(_OPENMP)
+        tid = omp_get_thread_num();
+        team = omp_get_num_threads();
+#endif
+
+        // The first thread reads and the others multiply, unless it is
+        // alone
+        //
+        int workers = max(team - 1, 1), worker = (team == 1 ? 0 : tid - 1);
+
+        for (size_t p = 0; p < npanels; p++) {
+            size_t begin = p * panel_rows_, end = min(nrows_, begin + panel_rows_);
+            bool reads = (tid == 0 && p + 1 < npanels);
+
+            if (reads && team > 1) {
+                if (!readRows(end, min(panel_rows_, nrows_ - end), buffers[(p + 1) % 2])) failed = true;
+            }
+
+            if (worker >= 0) {
+                size_t n = end - begin;
+                size_t b = begin + n * worker / workers, e = begin + n * (worker + 1) / workers;
+                if (b < e) compute(b, e, buffers[p % 2] + (b - begin) * ncols_);
+            }
+
+            if (reads && team == 1) {
+                if (!readRows(end, min(panel_rows_, nrows_ - end), buffers[(p + 1) % 2])) failed = true;
+            }
+
+            // The next panel is complete, and nobody multiplies the panel
+            // that is read next
+            //
+#if defined(_OPENMP)
+#pragma omp barrier
+#endif
+        }
+    }
+
+    if (failed) {
+        throw runtime_error("Error: Failed to read the binary matrix file.");
+    }
+}
+
+void
+StreamedMatrix::multiply(const Vector & x, Vector & y) const {
+    if (x.size() != ncols_) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    y.resize(nrows_);
+
+    const double *px = x.data();
+    double *py = y.data();
+    size_t n = ncols_;
+
+    stream([px, py, n](size_t begin, size_t end, const double * rows) {
+        gemv(end - begin, n, 1.0, rows, n, px, 1, 0.0, py + begin, 1, ExecutionContext(1));
+    });
+}
+
+void
+StreamedMatrix::multiplyBlock(const Matrix & X, Matrix & Y) const {
+    if (X.nrows() != ncols_) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    Y.resize(nrows_, X.ncols());
+
+    size_t n = ncols_, k = X.ncols();
+
+    stream([&X, &Y, n, k](size_t begin, size_t end, const double * rows) {
+        gemm(end - begin, k, n, 1.0, rows, n, X.data(), X.stride(),
+                0.0, Y[begin], Y.stride(), ExecutionContext(1));
+    });
+}
+
+const double *
+StreamedMatrix::cachedRow(size_t i) const {
+    if (i >= nrows_) {
+        throw runtime_error("Error: The row is out of the matrix.");
+    }
+
+    if (row_begin_ <= i && i < row_end_) {
+        return (row_panels_[0].data() + (i - row_begin_) * ncols_);
+    }
+
+    size_t count = row_panel_rows_;
+    if (row_panels_[0].empty()) {
+        row_panels_[0].resize(count * ncols_);
+        row_panels_[1].resize(count * ncols_);
+    }
+
+    // A sweep that goes backwards reads the panels that end at its rows
+    bool forward = !(row_end_ > 0 && i < row_begin_);
+    size_t begin = i;
+    if (!forward) begin = (i + 1 > count ? i + 1 - count : 0);
+
+    // The panel that was read ahead is used unless the sweep has jumped
+    bool read;
+    if (prefetching_ && prefetch_begin_ == begin) {
+        read = finishRead(row_request_);
+    } else {
+        if (prefetching_) finishRead(row_request_);
+        read = readRows(begin, min(count, nrows_ - begin), row_panels_[1].data());
+    }
+    prefetching_ = false;
+
+    if (!read) {
+        row_begin_ = row_end_ = 0;
+        throw runtime_error("Error: Failed to read the binary matrix file.");
+    }
+
+    swap(row_panels_[0], row_panels_[1]);
+    row_begin_ = begin;
+    row_end_ = min(nrows_, begin + count);
+
+    // The next panel in the direction of the sweep is read ahead
+    if (forward ? row_end_ < nrows_ : row_begin_ > 0) {
+        prefetch_begin_ = (forward ? row_end_ : (row_begin_ > count ? row_begin_ - count : 0));
+        prefetching_ = startRead(prefetch_begin_, min(count, nrows_ - prefetch_begin_),
+                row_panels_[1].data(), row_request_);
+    }
+
+    return (row_panels_[0].data() + (i - row_begin_) * ncols_);
+}
+
+double
+StreamedMatrix::rowProduct(size_t i, const double * x) const {
+    const double *row = nullptr;
+
+    // The panels are only used by one thread
+    Vector values;
+#if defined(_OPENMP)
+    if (omp_in_parallel()) {
+        readRow(i, values);
+        row = values.data();
+    }
+#endif
+    if (!row) row = cachedRow(i);
+
+    double sum = 0.0;
+    for (size_t j = 0; j < ncols_; j++) sum += row[j] * x[j];
+    return (sum);
+}
+
+void
+StreamedMatrix::multiplyRows(size_t begin, size_t end, const double * x, double * y) const {
+    if (begin >= end) return;
+
+    int tid = 0, team = 1;
+#if defined(_OPENMP)
+    tid = omp_get_thread_num();
+    team = omp_get_num_threads();
+#endif
+
+    // Every thread reads into its slice of the two panels. When there are
+    // more threads than rows in a panel, the threads without a slice
+    // allocate their own.
+    //
+    size_t slice = max((size_t) 1, panel_rows_ / team);
+    size_t piece = min(slice, end - begin);
+
+    vector<double> own[2];
+    double *buffers[2];
+    if ((tid + 1) * slice <= panel_rows_) {
+        buffers[0] = buffers_[0].data() + tid * slice * ncols_;
+        buffers[1] = buffers_[1].data() + tid * slice * ncols_;
+    } else {
+        own[0].resize(piece * ncols_);
+        own[1].resize(piece * ncols_);
+        buffers[0] = own[0].data();
+        buffers[1] = own[1].data();
+    }
+
+    // This is called within parallel regions, so a failed read is not
+    // thrown. y is NaN instead, which the solvers report as diverged.
+    // The next piece is read while the current one is multiplied.
+    //
+    struct aiocb requests[2];
+    bool started = startRead(begin, piece, buffers[0], requests[0]);
+
+    for (size_t i0 = begin, p = 0; i0 < end; i0 += piece, p++) {
+        size_t count = min(piece, end - i0), next = i0 + count;
+
+        bool read = (started && finishRead(requests[p % 2]));
+        started = (read && next < end &&
+                startRead(next, min(piece, end - next), buffers[(p + 1) % 2], requests[(p + 1) % 2]));
+
+        if (!read) {
+            fill(y + i0, y + end, numeric_limits<double>::quiet_NaN());
+            break;
+        }
+
+        gemv(count, ncols_, 1.0, buffers[p % 2], ncols_, x, 1, 0.0, y + i0, 1, ExecutionContext(1));
+    }
+}
+
+double
+StreamedMatrix::diagonal(size_t i) const {
+    return (diag_[i]);
+}
+
+bool
+StreamedMatrix::checkDominant() const {
+    return (dominant_);
+}
+
+void
+StreamedMatrix::print(ostream & os) const {
+    os << "StreamedMatrix [" << nrows_ << "][" << ncols_ << "] from " << file_
+            << " in panels of " << panel_rows_ << " rows" << endl << endl;
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   StreamedMatrix.h
+ * Author: Weiming Hu
+ *
+ * Created on October 27, 2026, 9:15 AM
+ */
+
+#ifndef STREAMEDMATRIX_H
+#define STREAMEDMATRIX_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "LinearOperator.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+
+#include <aio.h>
+
+// The memory of one panel of rows of a streamed matrix. Two panels are
+// allocated so that one is read while the other one is multiplied.
+//
+#ifndef STREAMED_PANEL_BYTES
+#define STREAMED_PANEL_BYTES (64 << 20)
+#endif
+
+// A dense matrix that is streamed from a binary matrix file
+//
+// The matrix is never loaded. The file is opened once, and every product
+// reads it in panels of whole rows, so only two panels are in memory
+// however large the matrix is. The panels are double-buffered: while the
+// other threads of the team multiply one panel, the first thread reads
+// the next one into the other buffer, so the reads overlap with the
+// products. With one thread, the panels are read and multiplied in turn.
+//
+// multiplyRows(), which the threads of the Jacobi solver call for their
+// own blocks of rows, reads the rows of the calling thread in pieces of a
+// panel divided by the number of threads. Every thread has its slice of
+// both panels, and the next piece is read with POSIX AIO while the
+// current one is multiplied, so the memory is still about two panels.
+//
+// rowProduct(), e.g. for Gauss-Seidel, reads the rows in two more panels
+// of half the size, and the next one in the direction of the sweep is
+// read ahead. It keeps which rows are read, so it should only be called
+// by one thread at a time. Within a parallel region, it reads single rows.
+//
+// The file has to be a binary matrix file of row-major double values, as
+// written by Matrix::writeBinary() and convertMatrix. The diagonal and the
+// diagonal dominance are found in one pass over the file when the matrix
+// is constructed.
+//
+class StreamedMatrix : public LinearOperator {
+public:
+    StreamedMatrix();
+    explicit StreamedMatrix(const std::string & bin_file,
+            std::size_t panel_bytes = STREAMED_PANEL_BYTES);
+    virtual ~StreamedMatrix();
+
+    // The file is kept open, so the matrix is not copied
+    StreamedMatrix(const StreamedMatrix &) = delete;
+    StreamedMatrix & operator=(const StreamedMatrix &) = delete;
+
+    std::size_t nrows() const override;
+    std::size_t ncols() const override;
+
+    // Number of rows in a panel
+    std::size_t panelRows() const;
+
+    // Read row i into values, which is resized to ncols()
+    void readRow(std::size_t i, Vector & values) const;
+
+    // The interface of the iterative solvers. Please see LinearOperator.h.
+    void multiply(const Vector & x, Vector & y) const override;
+    void multiplyBlock(const Matrix & X, Matrix & Y) const override;
+    double rowProduct(std::size_t i, const double * x) const override;
+    void multiplyRows(std::size_t begin, std::size_t end,
+            const double * x, double * y) const override;
+    double diagonal(std::size_t i) const override;
+    bool checkDominant() const override;
+
+    // Print the shape and the file. The values are not printed.
+    void print(std::ostream &) const override;
+
+private:
+    std::string file_;
+    std::size_t nrows_ = 0;
+    std::size_t ncols_ = 0;
+    std::size_t data_offset_ = 0;
+    std::size_t panel_rows_ = 0;
+
+    Vector diag_;
+    bool dominant_ = false;
+
+    int fd_ = -1;
+
+    // The two panels
+    mutable std::vector<double> buffers_[2];
+
+    // The panels of rowProduct(). The first one holds the rows
+    // [row_begin_, row_end_), and the second one is read ahead from row
+    // prefetch_begin_ while prefetching_ is set.
+    //
+    std::size_t row_panel_rows_ = 0;
+    mutable std::vector<double> row_panels_[2];
+    mutable std::size_t row_begin_ = 0;
+    mutable std::size_t row_end_ = 0;
+    mutable std::size_t prefetch_begin_ = 0;
+    mutable bool prefetching_ = false;
+    mutable struct aiocb row_request_;
+
+    // Read count rows from row begin into buffer
+    bool readRows(std::size_t begin, std::size_t count, double * buffer) const;
+
+    // Start reading count rows from row begin into buffer in the
+    // background, and wait for the read to finish. A read that could not
+    // be started or has failed returns false.
+    //
+    bool startRead(std::size_t begin, std::size_t count, double * buffer,
+            struct aiocb & request) const;
+    bool finishRead(struct aiocb & request) const;
+
+    // The values of row i in the panels of rowProduct()
+    const double * cachedRow(std::size_t i) const;
+
+    // Stream all panels. compute(begin, end, rows) is called for the rows
+    // [begin, end), where rows points to the values of row begin, on the
+    // threads that do not read. An exception is thrown when a read fails.
+    //
+    void stream(const std::function<void(std::size_t begin, std::size_t end,
+            const double * rows)> & compute) const;
+};
+
+#endif /* STREAMEDMATRIX_H */
@@ -0,0 +1,362 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Vector.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 14, 2026, 2:25 PM
+ */
+
+#include "Vector.h"
+#include "Gemm.h"
+
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+Vector::Vector() {
+}
+
+Vector::Vector(size_t size) {
+    resize(size);
+}
+
+Vector::Vector(size_t size, double value) {
+    resize(size);
+    fill(value);
+}
+
+Vector::Vector(const Vector& orig) {
+    *this = orig;
+}
+
+Vector::Vector(Vector && orig) noexcept {
+    swap(orig);
+}
+
+Vector::Vector(const OperatorProduct & product) {
+    *this = product;
+}
+
+Vector::Vector(const Matrix& mat) {
+    if (mat.ncols() == 1) {
+        resize(mat.nrows());
+        for (size_t i = 0; i < size_; i++) data_[i] = mat[i][0];
+    } else if (mat.nrows() == 1) {
+        resize(mat.ncols());
+        copy(mat[0], mat[0] + size_, data_);
+    } else {
+        throw runtime_error("Error: Only a matrix with one row or one column can be converted to a vector.");
+    }
+}
+
+Vector::~Vector() {
+    free(data_);
+}
+
+void
+Vector::resize(size_t size) {
+    if (size == size_) return;
+
+    double *data = allocateAligned(size);
+    std::fill(data, data + size, 0.0);
+    copy(data_, data_ + min(size, size_), data);
+
+    free(data_);
+    data_ = data;
+    size_ = size;
+}
+
+size_t
+Vector::size() const {
+    return (size_);
+}
+
+double *
+Vector::data() {
+    return (data_);
+}
+
+const double *
+Vector::data() const {
+    return (data_);
+}
+
+void
+Vector::fill(double value) {
+    std::fill(data_, data_ + size_, value);
+}
+
+void
+Vector::swap(Vector & other) {
+    std::swap(size_, other.size_);
+    std::swap(data_, other.data_);
+}
+
+bool
+Vector::readVector(const std::string & csv_file) {
+    Matrix mat;
+    mat.readMatrix(csv_file);
+    *this = Vector(mat);
+    return (true);
+}
+
+Matrix
+Vector::toMatrix() const {
+    Matrix mat(size_, 1);
+    for (size_t i = 0; i < size_; i++) mat[i][0] = data_[i];
+    return (mat);
+}
+
+void
+Vector::print(ostream & os) const {
+    os << "Matrix [" << size_ << "][1]:" << endl
+            << "\t[ ,0]\t" << endl;
+
+    for (size_t i = 0; i < size_; i++) {
+        os << "[" << i << ", ]\t" << data_[i] << " \t" << endl;
+    }
+    os << endl;
+}
+
+Vector &
+Vector::operator=(const Vector & rhs) {
+    if (this != &rhs) {
+        if (size_ != rhs.size_) {
+            free(data_);
+            data_ = allocateAligned(rhs.size_);
+            size_ = rhs.size_;
+        }
+        copy(rhs.data_, rhs.data_ + size_, data_);
+    }
+    return (*this);
+}
+
+Vector &
+Vector::operator=(Vector && rhs) noexcept {
+    if (this != &rhs) {
+        free(data_);
+        data_ = nullptr;
+        size_ = 0;
+        swap(rhs);
+    }
+    return (*this);
+}
+
+Vector &
+Vector::operator=(const OperatorProduct & product) {
+    if (data_ && product.vector().data() == data_) {
+        Vector result(product);
+        swap(result);
+    } else {
+        product.matrix().multiply(product.vector(), *this);
+    }
+    return (*this);
+}
+
+ostream &
+operator<<(ostream & os, const Vector & vec) {
+    vec.print(os);
+    return (os);
+}
+
+void
+gemv(double alpha, const Matrix & A, const Vector & x,
+        double beta, Vector & y) {
+    if (A.ncols() != x.size() || A.nrows() != y.size()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    gemv(A.nrows(), A.ncols(), alpha, A.data(), A.stride(),
+            x.data(), 1, beta, y.data(), 1);
+}
+
+void
+axpy(double alpha, const Vector & x, Vector & y) {
+    if (x.size() != y.size()) {
+        throw runtime_error("Vectors do not have the same size.");
+    }
+
+    const double *px = x.data();
+    double *py = y.data();
+    size_t n = x.size();
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        py[i] += alpha * px[i];
+    }
+}
+
+double
+dot(const Vector & x, const Vector & y) {
+    if (x.size() != y.size()) {
+        throw runtime_error("Vectors do not have the same size.");
+    }
+
+    const double *px = x.data(), *py = y.data();
+    size_t n = x.size();
+    double sum = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+    for (size_t i = 0; i < n; i++) {
+        sum += px[i] * py[i];
+    }
+
+    return (sum);
+}
+
+double
+norm1(const Vector & x) {
+    const double *px = x.data();
+    size_t n = x.size();
+    double sum = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:sum)
+#endif
+    for (size_t i = 0; i < n; i++) {
+        sum += abs(px[i]);
+    }
+
+    return (sum);
+}
+
+double
+norm2(const Vector & x) {
+    return (sqrt(dot(x, x)));
+}
+
+double
+normInf(const Vector & x) {
+    const double *px = x.data();
+    size_t n = x.size();
+    double value = 0.0;
+
+    for (size_t i = 0; i < n; i++) {
+        value = max(value, abs(px[i]));
+    }
+
+    return (value);
+}
+
+double
+residual(const Matrix & A, const Vector & x, const Vector & b, Vector & r) {
+    r = b;
+    gemv(-1.0, A, x, 1.0, r);
+    return (norm1(r));
+}
+
+double
+residual(const LinearOperator & A, const Vector & x, const Vector & b, Vector & r) {
+    if (A.nrows() != b.size()) {
+        throw runtime_error("Matrix and vectors do not have the correct shape.");
+    }
+
+    A.multiply(x, r);
+
+    double *pr = r.data();
+    const double *pb = b.data();
+    size_t n = r.size();
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        pr[i] = pb[i] - pr[i];
+    }
+
+    return (norm1(r));
+}
+
+Vector
+residuals(const LinearOperator & A, const Matrix & X, const Matrix & B, Matrix & R) {
+    if (A.nrows() != B.nrows() || X.ncols() != B.ncols()) {
+        throw runtime_error("Matrices do not have the correct shape.");
+    }
+
+    A.multiplyBlock(X, R);
+
+    size_t k = B.ncols();
+    Vector resids(k);
+
+    for (size_t i = 0; i < R.nrows(); i++) {
+        double *pr = R[i];
+        const double *pb = B[i];
+        for (size_t j = 0; j < k; j++) {
+            pr[j] = pb[j] - pr[j];
+            resids[j] += abs(pr[j]);
+        }
+    }
+
+    return (resids);
+}
+
+Matrix
+readRightHandSides(const string & path) {
+    Matrix B;
+
+    // A NetCDF variable also has one right-hand side per column
+    string nc_file, var_name;
+    if (netcdfVariable(path, nc_file, var_name)) {
+        B.readNetCDF(nc_file, var_name);
+        return (B);
+    }
+
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        throw runtime_error("Error: " + path + " can't be found.");
+    }
+
+    if (!S_ISDIR(path_stat.st_mode)) {
+        B.readMatrix(path);
+        if (B.nrows() == 1) B = B.transpose();
+        return (B);
+    }
+
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        throw runtime_error("Error: The directory " + path + " can't be opened.");
+    }
+
+    vector<string> files;
+    for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir)) {
+        string file = path + "/" + entry->d_name;
+        if (entry->d_name[0] != '.' && stat(file.c_str(), &path_stat) == 0 &&
+                S_ISREG(path_stat.st_mode)) {
+            files.push_back(file);
+        }
+    }
+    closedir(dir);
+
+    if (files.empty()) {
+        throw runtime_error("Error: No right-hand sides are found in " + path + ".");
+    }
+
+    sort(files.begin(), files.end());
+
+    Vector b;
+    for (size_t j = 0; j < files.size(); j++) {
+        b.readVector(files[j]);
+
+        if (j == 0) {
+            B.resize(b.size(), files.size());
+        } else if (b.size() != B.nrows()) {
+            throw runtime_error("Error: The right-hand sides in " + path + " have different lengths.");
+        }
+
+        for (size_t i = 0; i < b.size(); i++) B[i][j] = b[i];
+    }
+
+    return (B);
+}
+
@@ -0,0 +1,222 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   Vector.h
+ * Author: Weiming Hu
+ *
+ * Created on October 14, 2026, 2:25 PM
+ */
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include "Matrix.h"
+#include "VectorExpression.h"
+#include "ExecutionContext.h"
+
+#include <iostream>
+#include <string>
+
+class OperatorProduct;
+
+// Vector stores values in a single aligned buffer. It is used for the
+// right-hand side, the solution, and the residuals of the solvers.
+//
+// Arithmetic on vectors is lazy. Please see VectorExpression.h.
+//
+class Vector : public VectorExpression<Vector> {
+public:
+    Vector();
+    Vector(std::size_t size);
+    Vector(std::size_t size, double value);
+    Vector(const Vector& orig);
+    Vector(Vector && orig) noexcept;
+
+    // Evaluate an expression, e.g. b - A * x
+    template <typename E>
+    Vector(const VectorExpression<E> & expr);
+    Vector(const OperatorProduct & product);
+
+    // Generate from a matrix with only one row or one column
+    explicit Vector(const Matrix& mat);
+
+    virtual ~Vector();
+
+    // Resize the vector. Values are kept and new values are initialized to 0.
+    void resize(std::size_t size);
+    size_t size() const;
+
+    // Pointer to the beginning of the storage
+    double * data();
+    const double * data() const;
+
+    double & operator[](std::size_t i) {
+        return (data_[i]);
+    }
+
+    const double & operator[](std::size_t i) const {
+        return (data_[i]);
+    }
+
+    // Set all values
+    void fill(double value);
+
+    // Exchange the storage with another vector without copying
+    void swap(Vector & other);
+
+    // Read vector from a file with one value per line or per column
+    bool readVector(const std::string & csv_file);
+
+    // Convert to a matrix with one column
+    Matrix toMatrix() const;
+
+    // Print functions. The output has the same layout as a matrix with one
+    // column so that logs of the solvers are not changed.
+    //
+    void print(std::ostream &) const;
+
+    // Overload operators. An expression is evaluated into the storage of
+    // the vector, which is only reallocated when the size changes.
+    //
+    Vector & operator=(const Vector & rhs);
+    Vector & operator=(Vector && rhs) noexcept;
+
+    template <typename E>
+    Vector & operator=(const VectorExpression<E> & expr);
+    Vector & operator=(const OperatorProduct & product);
+
+    friend std::ostream & operator<<(std::ostream &, const Vector &);
+
+private:
+    std::size_t size_ = 0;
+    double *data_ = nullptr;
+};
+
+// Fused kernels for the iterative solvers
+
+// y = alpha * A * x + beta * y. y is not read when beta is 0.
+void gemv(double alpha, const Matrix & A, const Vector & x,
+        double beta, Vector & y);
+
+// y = alpha * x + y
+void axpy(double alpha, const Vector & x, Vector & y);
+
+// Inner product of x and y
+double dot(const Vector & x, const Vector & y);
+
+// Norms
+double norm1(const Vector & x);
+double norm2(const Vector & x);
+double normInf(const Vector & x);
+
+// r = b - A * x. The L1 norm of r is returned.
+double residual(const Matrix & A, const Vector & x, const Vector & b, Vector & r);
+double residual(const LinearOperator & A, const Vector & x, const Vector & b, Vector & r);
+
+// R = B - A * X for a batch of solutions in the columns of X. The L1 norms
+// of the columns of R are returned.
+//
+Vector residuals(const LinearOperator & A, const Matrix & X, const Matrix & B, Matrix & R);
+
+// Read a batch of right-hand sides into the columns of a matrix
+//
+// path is either a matrix file, where every column is a right-hand side
+// and a single row is taken as one right-hand side, a NetCDF variable (see
+// netcdfVariable in Matrix.h) with one right-hand side per column, or a
+// directory, where every file is read as a vector in the order of the file
+// names.
+//
+Matrix readRightHandSides(const std::string & path);
+
+// The lazy product A * x
+//
+// Within an expression, every value is the product of a row of A and x,
+// so e.g. b - A * x is one pass over A. A product alone is computed with
+// LinearOperator::multiply. x is only referred to, like the vectors of the
+// other nodes.
+//
+class OperatorProduct : public VectorExpression<OperatorProduct> {
+public:
+    static const bool has_product = true;
+
+    OperatorProduct(const LinearOperator & A, const Vector & x) : A_(A), x_(x) {
+        if (A.ncols() != x.size()) {
+            throw std::runtime_error("Matrix and vectors do not have the correct shape.");
+        }
+    }
+
+    std::size_t size() const {
+        return (A_.nrows());
+    }
+
+    double operator[](std::size_t i) const {
+        return (A_.rowProduct(i, x_.data()));
+    }
+
+    // A row product reads all values of x
+    bool aliases(const double * data) const {
+        return (x_.data() == data);
+    }
+
+    const LinearOperator & matrix() const {
+        return (A_);
+    }
+
+    const Vector & vector() const {
+        return (x_);
+    }
+
+private:
+    const LinearOperator & A_;
+    const Vector & x_;
+};
+
+inline OperatorProduct
+operator*(const LinearOperator & lhs, const Vector & rhs) {
+    return (OperatorProduct(lhs, rhs));
+}
+
+template <typename E>
+Vector::Vector(const VectorExpression<E> & expr) {
+    *this = expr;
+}
+
+template <typename E>
+Vector &
+Vector::operator=(const VectorExpression<E> & expression) {
+    const E & expr = expression.self();
+
+    // A product that reads this vector can't write it in place
+    if (data_ && ExpressionOperand<E>::aliases(expr, data_)) {
+        Vector result(expr);
+        swap(result);
+        return (*this);
+    }
+
+    resize(expr.size());
+    double *py = data_;
+    long n = size_;
+
+    // The row products are worth the threads, and every one is taken as
+    // n operations. The other expressions are as cheap as axpy().
+    //
+    if (ExpressionOperand<E>::has_product) {
+#if defined(_OPENMP)
+        int nthreads = ExecutionContext::current().threads((std::size_t) n * n);
+#pragma omp parallel for num_threads(nthreads) default(none) schedule(static) shared(expr, py, n)
+#endif
+        for (long i = 0; i < n; i++) {
+            py[i] = expr[i];
+        }
+    } else {
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (long i = 0; i < n; i++) {
+            py[i] = expr[i];
+        }
+    }
+
+    return (*this);
+}
+
+#endif /* VECTOR_H */
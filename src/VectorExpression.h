@@ -0,0 +1,162 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   VectorExpression.h
+ * Author: Weiming Hu
+ *
+ * Created on October 25, 2026, 10:10 AM
+ */
+
+#ifndef VECTOREXPRESSION_H
+#define VECTOREXPRESSION_H
+
+#include <cstddef>
+#include <stdexcept>
+
+class Vector;
+
+// Lazy vector expressions
+//
+// Sums, differences, and scalings of vectors, and the products with a
+// linear operator (see Vector.h), are not computed where they are written.
+// They are nodes of an expression that is evaluated in one pass when it is
+// assigned to a Vector, so that y = b - A * x needs no temporary vectors
+// and no allocation when y already has the size.
+//
+// The nodes only refer to the vectors, so an expression should be assigned
+// in the statement that creates it and never be kept with auto.
+//
+template <typename E>
+class VectorExpression {
+public:
+
+    const E & self() const {
+        return (static_cast<const E &> (*this));
+    }
+
+    std::size_t size() const {
+        return (self().size());
+    }
+
+    double operator[](std::size_t i) const {
+        return (self()[i]);
+    }
+};
+
+// Vectors are kept by reference in the nodes, and the nodes by value
+template <typename E>
+struct ExpressionOperand {
+    typedef const E type;
+    static const bool has_product = E::has_product;
+
+    static bool aliases(const E & expr, const double * data) {
+        return (expr.aliases(data));
+    }
+};
+
+template <>
+struct ExpressionOperand<Vector> {
+    typedef const Vector & type;
+    static const bool has_product = false;
+
+    // Every value only depends on the values of the same index, so the
+    // destination can be one of the vectors
+    //
+    static bool aliases(const Vector &, const double *) {
+        return (false);
+    }
+};
+
+struct ExpressionPlus {
+
+    static double apply(double lhs, double rhs) {
+        return (lhs + rhs);
+    }
+};
+
+struct ExpressionMinus {
+
+    static double apply(double lhs, double rhs) {
+        return (lhs - rhs);
+    }
+};
+
+template <typename L, typename R, typename Op>
+class VectorBinary : public VectorExpression<VectorBinary<L, R, Op> > {
+public:
+    static const bool has_product =
+            ExpressionOperand<L>::has_product || ExpressionOperand<R>::has_product;
+
+    VectorBinary(const L & lhs, const R & rhs) : lhs_(lhs), rhs_(rhs) {
+        if (lhs.size() != rhs.size()) {
+            throw std::runtime_error("Vectors do not have the correct shape.");
+        }
+    }
+
+    std::size_t size() const {
+        return (lhs_.size());
+    }
+
+    double operator[](std::size_t i) const {
+        return (Op::apply(lhs_[i], rhs_[i]));
+    }
+
+    bool aliases(const double * data) const {
+        return (ExpressionOperand<L>::aliases(lhs_, data) ||
+                ExpressionOperand<R>::aliases(rhs_, data));
+    }
+
+private:
+    typename ExpressionOperand<L>::type lhs_;
+    typename ExpressionOperand<R>::type rhs_;
+};
+
+template <typename E>
+class VectorScaled : public VectorExpression<VectorScaled<E> > {
+public:
+    static const bool has_product = ExpressionOperand<E>::has_product;
+
+    VectorScaled(double alpha, const E & expr) : alpha_(alpha), expr_(expr) {
+    }
+
+    std::size_t size() const {
+        return (expr_.size());
+    }
+
+    double operator[](std::size_t i) const {
+        return (alpha_ * expr_[i]);
+    }
+
+    bool aliases(const double * data) const {
+        return (ExpressionOperand<E>::aliases(expr_, data));
+    }
+
+private:
+    double alpha_;
+    typename ExpressionOperand<E>::type expr_;
+};
+
+template <typename L, typename R>
+inline VectorBinary<L, R, ExpressionPlus>
+operator+(const VectorExpression<L> & lhs, const VectorExpression<R> & rhs) {
+    return (VectorBinary<L, R, ExpressionPlus>(lhs.self(), rhs.self()));
+}
+
+template <typename L, typename R>
+inline VectorBinary<L, R, ExpressionMinus>
+operator-(const VectorExpression<L> & lhs, const VectorExpression<R> & rhs) {
+    return (VectorBinary<L, R, ExpressionMinus>(lhs.self(), rhs.self()));
+}
+
+template <typename E>
+inline VectorScaled<E>
+operator*(double alpha, const VectorExpression<E> & expr) {
+    return (VectorScaled<E>(alpha, expr.self()));
+}
+
+template <typename E>
+inline VectorScaled<E>
+operator-(const VectorExpression<E> & expr) {
+    return (VectorScaled<E>(-1.0, expr.self()));
+}
+
+#endif /* VECTOREXPRESSION_H */
@@ -0,0 +1,409 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   benchMatrix.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 27, 2026, 4:40 PM
+ */
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "SparseMatrix.h"
+#include "GaussSeidel.h"
+#include "Jacobi.h"
+#include "Krylov.h"
+#include "Convergence.h"
+#include "ExecutionContext.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// The number of iterations of a Krylov solve that is timed. They are few
+// enough that the solves on the test data do not break down.
+//
+#ifndef BENCH_KRYLOV_ITERATIONS
+#define BENCH_KRYLOV_ITERATIONS 8
+#endif
+
+// The result of a benchmark
+//
+// A benchmark is run once to warm up, and then until it has taken at least
+// the minimum time. flops and bytes are the operations and the memory
+// traffic of one iteration, which is one run of the kernel or, for the
+// solvers, one iteration within a run.
+//
+struct BenchResult {
+    string name;
+    string source;
+    size_t size;
+    int threads;
+    size_t runs;
+    double seconds;
+    double flops;
+    double bytes;
+};
+
+// Time a kernel of the given number of iterations per run
+static BenchResult
+timeKernel(const string & name, const string & source, size_t size,
+        double flops, double bytes, size_t iterations, double min_time,
+        const function<void()> & kernel) {
+
+    typedef chrono::steady_clock Clock;
+
+    kernel();
+
+    size_t runs = 0;
+    double elapsed = 0.0;
+    Clock::time_point start = Clock::now();
+
+    do {
+        kernel();
+        runs++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < min_time);
+
+    BenchResult result = {name, source, size, ExecutionContext::current().nthreads(),
+        runs, elapsed / (runs * iterations), flops, bytes};
+    return (result);
+}
+
+// The sizes N of all A_<N>.csv files in a directory that have b_<N>.csv
+static vector<size_t>
+findSizes(const string & csv_dir) {
+    vector<size_t> sizes;
+    DIR *dir = opendir(csv_dir.c_str());
+    if (!dir) return (sizes);
+
+    for (struct dirent *item = readdir(dir); item; item = readdir(dir)) {
+        string file(item->d_name);
+        if (file.size() < 7 || file.compare(0, 2, "A_") != 0 ||
+                file.compare(file.size() - 4, 4, ".csv") != 0) continue;
+
+        string digits = file.substr(2, file.size() - 6);
+        if (digits.find_first_not_of("0123456789") != string::npos) continue;
+
+        struct stat file_stat;
+        string b_file = csv_dir + "/b_" + digits + ".csv";
+        if (stat(b_file.c_str(), &file_stat) == 0) sizes.push_back(atol(digits.c_str()));
+    }
+
+    closedir(dir);
+    sort(sizes.begin(), sizes.end());
+    return (sizes);
+}
+
+static double
+fileBytes(const string & file) {
+    struct stat file_stat;
+    return (stat(file.c_str(), &file_stat) == 0 ? (double) file_stat.st_size : 0.0);
+}
+
+// Run the benchmarks of the kernels on A and b of size n
+static void
+benchKernels(const Matrix & A, const Vector & b, size_t n, double min_time,
+        const string & filter, vector<BenchResult> & results) {
+
+    auto selected = [&filter](const string & name) {
+        return (filter.empty() || name.find(filter) != string::npos);
+    };
+
+    double nn = (double) n * n, matrix_bytes = nn * sizeof (double);
+    Vector x(n, 1.0), y(n), x_new(n);
+
+    if (selected("multiply_matrix")) {
+        results.push_back(timeKernel("multiply_matrix", "csv", n, 2.0 * nn * n,
+                3.0 * matrix_bytes, 1, min_time, [&A]() {
+                    Matrix C = A * A;
+                }));
+    }
+
+    // The LU factorization takes about 2/3 N^3 operations, and the N pairs
+    // of triangular solves of the identity 2 N^3, which are 8/3 N^3
+    // together
+    //
+    if (selected("inverse")) {
+        results.push_back(timeKernel("inverse", "csv", n, 8.0 / 3.0 * nn * n,
+                2.0 * matrix_bytes, 1, min_time, [&A]() {
+                    Matrix A_copy(A);
+                    Matrix A_inv = A_copy.inverse();
+                }));
+    }
+
+    if (selected("transpose")) {
+        results.push_back(timeKernel("transpose", "csv", n, 0.0,
+                2.0 * matrix_bytes, 1, min_time, [&A]() {
+                    Matrix A_t = A.transpose();
+                }));
+    }
+
+    double vector_bytes = 2.0 * n * sizeof (double);
+
+    if (selected("matvec_dense")) {
+        results.push_back(timeKernel("matvec_dense", "csv", n, 2.0 * nn,
+                matrix_bytes + vector_bytes, 1, min_time, [&A, &x, &y]() {
+                    A.multiply(x, y);
+                }));
+    }
+
+    // The CSR mat-vec reads a value and a 32-bit column index per nonzero
+    SparseMatrix A_sparse(A);
+    double nnz = A_sparse.nnz(), sparse_bytes = nnz * (sizeof (double) + 4);
+
+    if (selected("matvec_csr")) {
+        results.push_back(timeKernel("matvec_csr", "csv", n, 2.0 * nnz,
+                sparse_bytes + vector_bytes, 1, min_time, [&A_sparse, &x, &y]() {
+                    A_sparse.multiply(x, y);
+                }));
+    }
+
+    if (selected("matvec_sell")) {
+        A_sparse.setLayout(SparseMatrix::SELL);
+        results.push_back(timeKernel("matvec_sell", "csv", n, 2.0 * nnz,
+                sparse_bytes + vector_bytes, 1, min_time, [&A_sparse, &x, &y]() {
+                    A_sparse.multiply(x, y);
+                }));
+    }
+
+    if (selected("jacobi_sweep")) {
+        Jacobi jacobi(A);
+        results.push_back(timeKernel("jacobi_sweep", "csv", n, 2.0 * nn + 3.0 * n,
+                matrix_bytes + 4.0 * n * sizeof (double), 1, min_time, [&jacobi, &b, &x, &x_new]() {
+                    jacobi.sweep(b, x, x_new);
+                }));
+    }
+
+    if (selected("gauss_seidel_sweep")) {
+        GaussSeidel gauss(A);
+        Vector x_gauss(n, 0.0);
+        results.push_back(timeKernel("gauss_seidel_sweep", "csv", n, 2.0 * nn + 3.0 * n,
+                matrix_bytes + 3.0 * n * sizeof (double), 1, min_time, [&gauss, &b, &x_gauss]() {
+                    gauss.sweep(b, x_gauss);
+                }));
+    }
+
+    // The operations of the Krylov iterations only count the mat-vecs,
+    // which are 2 per BiCGSTAB iteration and 1 per GMRES iteration. The
+    // tolerance 0 never stops them early.
+    //
+    Krylov::Method methods[2] = {Krylov::BICGSTAB, Krylov::GMRES};
+    string names[2] = {"bicgstab_iteration", "gmres_iteration"};
+    double matvecs[2] = {2.0, 1.0};
+
+    for (int m = 0; m < 2; m++) {
+        if (!selected(names[m])) continue;
+
+        Krylov krylov(A, methods[m]);
+        results.push_back(timeKernel(names[m], "csv", n, matvecs[m] * 2.0 * nn,
+                matvecs[m] * matrix_bytes, BENCH_KRYLOV_ITERATIONS, min_time, [&krylov, &b, n]() {
+                    Vector x_krylov(n, 0.0);
+                    krylov.solve(b, x_krylov, BENCH_KRYLOV_ITERATIONS, Convergence(0.0));
+                }));
+    }
+}
+
+static void
+writeCsv(const vector<BenchResult> & results, ostream & os) {
+    os << "benchmark,source,size,threads,runs,seconds_per_iteration,gflops,gbytes_per_second" << endl;
+    for (const auto & result : results) {
+        os << result.name << "," << result.source << "," << result.size << ","
+                << result.threads << "," << result.runs << "," << result.seconds << ","
+                << result.flops / result.seconds * 1.0e-9 << ","
+                << result.bytes / result.seconds * 1.0e-9 << endl;
+    }
+}
+
+// The layout follows the JSON output of Google Benchmark
+static void
+writeJson(const vector<BenchResult> & results, double min_time, ostream & os) {
+    os << "{" << endl << "  \"context\": {" << endl
+            << "    \"threads\": " << ExecutionContext::current().nthreads() << "," << endl
+            << "    \"min_time\": " << min_time << endl
+            << "  }," << endl << "  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult & result = results[i];
+        os << (i == 0 ? "" : ",") << endl << "    {" << endl
+                << "      \"name\": \"" << result.name << "/" << result.source << "/" << result.size << "\"," << endl
+                << "      \"benchmark\": \"" << result.name << "\"," << endl
+                << "      \"source\": \"" << result.source << "\"," << endl
+                << "      \"size\": " << result.size << "," << endl
+                << "      \"threads\": " << result.threads << "," << endl
+                << "      \"runs\": " << result.runs << "," << endl
+                << "      \"seconds_per_iteration\": " << result.seconds << "," << endl
+                << "      \"gflops\": " << result.flops / result.seconds * 1.0e-9 << "," << endl
+                << "      \"gbytes_per_second\": " << result.bytes / result.seconds * 1.0e-9 << endl
+                << "    }";
+    }
+
+    os << endl << "  ]" << endl << "}" << endl;
+}
+
+int main(int argc, char** argv) {
+
+    string data_dir("data"), format("csv"), output_file, filter;
+    double min_time = 0.5;
+    int nthreads = 0;
+    vector<size_t> sizes;
+
+    for (int i_arg = 1; i_arg < argc; i_arg++) {
+        string option(argv[i_arg]);
+
+        if (option == "--data" && i_arg + 1 < argc) {
+            data_dir = argv[++i_arg];
+        } else if (option == "--sizes" && i_arg + 1 < argc) {
+            istringstream list(argv[++i_arg]);
+            for (string size; getline(list, size, ',');) {
+                if (!size.empty()) sizes.push_back(atol(size.c_str()));
+            }
+        } else if (option == "--format" && i_arg + 1 < argc) {
+            format = argv[++i_arg];
+        } else if (option == "--output" && i_arg + 1 < argc) {
+            output_file = argv[++i_arg];
+        } else if (option == "--min-time" && i_arg + 1 < argc) {
+            min_time = atof(argv[++i_arg]);
+        } else if (option == "--threads" && i_arg + 1 < argc) {
+            nthreads = atoi(argv[++i_arg]);
+        } else if (option == "--filter" && i_arg + 1 < argc) {
+            filter = argv[++i_arg];
+        } else {
+            cout << "benchMatrix [options]" << endl << endl << "\tOptions: " << endl
+                    << "\t\t--data <directory> Directory of the test data with csv/ and ncdf4/ (default data)" << endl
+                    << "\t\t--sizes <N,N,...> Sizes of the test data (default all A_<N>.csv in csv/)" << endl
+                    << "\t\t--format <csv|json> Format of the results (default csv)" << endl
+                    << "\t\t--output <file>   Write the results to a file instead of the standard output" << endl
+                    << "\t\t--min-time <seconds> Minimum time of every benchmark (default 0.5)" << endl
+                    << "\t\t--threads <number> Number of threads of the kernels (default OMP_NUM_THREADS)" << endl
+                    << "\t\t--filter <name>   Only run the benchmarks whose names contain this" << endl;
+            return (option == "--help" ? 0 : 1);
+        }
+    }
+
+    if (format != "csv" && format != "json") {
+        cout << "Error: Unknown format " << format << ". Please use csv or json." << endl;
+        return 1;
+    }
+
+    ExecutionContext::setCurrent(ExecutionContext(nthreads));
+
+    string csv_dir = data_dir + "/csv";
+    if (sizes.empty()) sizes = findSizes(csv_dir);
+
+    if (sizes.empty()) {
+        cout << "Error: No test data is found in " << csv_dir << endl;
+        return 1;
+    }
+
+    auto selected = [&filter](const string & name) {
+        return (filter.empty() || name.find(filter) != string::npos);
+    };
+
+    vector<BenchResult> results;
+
+    for (size_t n : sizes) {
+        ostringstream suffix;
+        suffix << n;
+        string A_file = csv_dir + "/A_" + suffix.str() + ".csv";
+        string b_file = csv_dir + "/b_" + suffix.str() + ".csv";
+
+        Matrix A;
+        Vector b;
+
+        try {
+            if (!A.readMatrix(A_file) || !b.readVector(b_file)) {
+                cout << "Error: " << A_file << " or " << b_file << " can't be read." << endl;
+                return 1;
+            }
+        } catch (const exception & e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+
+        if (A.nrows() != n || A.ncols() != n || b.size() != n) {
+            cout << "Error: " << A_file << " and " << b_file << " are not of size " << n << "." << endl;
+            return 1;
+        }
+
+        double matrix_bytes = (double) n * n * sizeof (double);
+
+        cerr << "Running the benchmarks of size " << n << endl;
+
+        if (selected("read_matrix")) {
+            results.push_back(timeKernel("read_matrix", "csv", n, 0.0,
+                    fileBytes(A_file), 1, min_time, [&A_file]() {
+                        Matrix A_read;
+                        A_read.readMatrix(A_file);
+                    }));
+
+            // Mapping the file does not read it, so the checksum is verified
+            // to touch every value. The file is a temporary file, so that no
+            // file of the user is overwritten.
+            //
+            const char *tmp_dir = getenv("TMPDIR");
+            string bin_file = string(tmp_dir && *tmp_dir ? tmp_dir : "/tmp") + "/benchMatrix_XXXXXX";
+            vector<char> bin_path(bin_file.begin(), bin_file.end());
+            bin_path.push_back('\0');
+
+            int bin_fd = mkstemp(bin_path.data());
+            if (bin_fd < 0) {
+                cout << "Error: The temporary file " << bin_file << " can't be created." << endl;
+                return 1;
+            }
+            close(bin_fd);
+            bin_file = bin_path.data();
+
+            A.writeBinary(bin_file);
+            results.push_back(timeKernel("read_matrix", "binary", n, 0.0,
+                    matrix_bytes, 1, min_time, [&bin_file]() {
+                        Matrix A_read;
+                        A_read.readBinary(bin_file, true);
+                    }));
+            remove(bin_file.c_str());
+
+#ifdef _USE_NETCDF
+            string nc_file = data_dir + "/ncdf4/" + suffix.str() + ".nc";
+            if (fileBytes(nc_file) > 0.0) {
+                results.push_back(timeKernel("read_matrix", "netcdf", n, 0.0,
+                        matrix_bytes, 1, min_time, [&nc_file]() {
+                            Matrix A_read;
+                            A_read.readMatrix(nc_file + ":A");
+                        }));
+            }
+#endif
+        }
+
+        benchKernels(A, b, n, min_time, filter, results);
+    }
+
+    ofstream file;
+    if (!output_file.empty()) {
+        file.open(output_file.c_str());
+        if (!file) {
+            cout << "Error: " << output_file << " can't be written." << endl;
+            return 1;
+        }
+    }
+
+    ostream & os = (output_file.empty() ? cout : file);
+    os << setprecision(6);
+
+    if (format == "json") writeJson(results, min_time, os);
+    else writeCsv(results, os);
+
+    return 0;
+}
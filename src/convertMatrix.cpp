@@ -0,0 +1,59 @@
+/* Copyright (c) 2018 Weiming Hu
+ *
+ * File:   convertMatrix.cpp
+ * Author: Weiming Hu
+ *
+ * Created on October 16, 2026, 11:20 AM
+ */
+
+#include "Matrix.h"
+
+#include <string>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+
+    if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+        Matrix mat;
+        mat.readBinary(argv[2], true);
+        cout << argv[2] << ": " << mat.nrows() << " x " << mat.ncols()
+                << ", checksum verified." << endl;
+        return 0;
+    }
+
+    if (argc != 3 && argc != 4) {
+        cout << "convertMatrix <input csv> <output binary>" << endl
+#ifdef _USE_NETCDF
+                << "convertMatrix <input NetCDF> <variable name> <output binary>" << endl
+#endif
+                << "convertMatrix --verify <binary>" << endl;
+        return 0;
+    }
+
+    Matrix mat;
+    string output_file;
+
+    if (argc == 3) {
+        mat.readMatrix(argv[1]);
+        output_file = argv[2];
+    } else {
+        // The first dimension of a 2-dimensional variable is the column and
+        // the second dimension is the row. Please see Matrix.h.
+        //
+        try {
+            mat.readNetCDF(argv[1], argv[2]);
+        } catch (const exception & e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+        output_file = argv[3];
+    }
+
+    mat.writeBinary(output_file);
+    cout << "Write " << mat.nrows() << " x " << mat.ncols() << " to " << output_file << endl;
+
+    return 0;
+}
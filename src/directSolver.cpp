@@ -7,7 +7,13 @@
  */
 
 #include "Matrix.h"
+#include "Vector.h"
+#include "Factorization.h"
+#include "ExecutionContext.h"
 
+#include <cstring>
+#include <vector>
+#include <string>
 #include <iomanip>
 
 #ifdef _PROFILE_TIME
@@ -17,46 +23,76 @@
 using namespace std;
 
 int main(int argc, char** argv) {
+
+    // The options can be anywhere. The other arguments are positional.
+    string output_file;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            // The threads of the dense kernels, OMP_NUM_THREADS by default
+            ExecutionContext::setCurrent(ExecutionContext(atoi(argv[++i])));
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
     
-    if (argc != 3 && argc != 4) {
-        cout << "directSolvers <matrix csv> <vector csv> [A verbose flag integer]" 
-             << endl << endl << "\tVerbose level specification: " << endl << "\t\t0 - Quiet" << endl
+    if (args.size() != 2 && args.size() != 3) {
+        cout << "directSolvers <matrix csv> <right-hand sides> [A verbose flag integer] [--output <csv>] [--threads <number>]"
+             << endl << endl << "\tThe right-hand sides are either a vector, a matrix with one right-hand side" << endl
+             << "\tper column, or a directory of vectors. They are solved with one factorization." << endl
+             << endl << "\tThe matrix, the right-hand sides, and the output can also be NetCDF variables" << endl
+             << "\tas <file>.nc:<variable>." << endl
+             << endl << "\tVerbose level specification: " << endl << "\t\t0 - Quiet" << endl
              << "\t\t1 - Result only" << endl << "\t\t2 - The about plus input" << endl;
         return 0; 
     }
 
     // Read verbose flag
     int verbose = 1;
-    if (argc == 4) {
-        verbose = atoi(argv[argc - 1]);
+    if (args.size() == 3) {
+        verbose = atoi(args[2].c_str());
     }
     
-    // I store the vector b in form of a matrix with only one column.
-    Matrix A, b;
+    Matrix A, B;
     
     // Read input files
-    A.readMatrix(argv[1]);
-    b.readMatrix(argv[2]);
+    A.readMatrix(args[0]);
+    B = readRightHandSides(args[1]);
     
     // Check the dimensions of input
-    if (A.nrows() != b.nrows()) 
+    if (A.nrows() != B.nrows()) 
         throw runtime_error("Matrix and vector do not have correct shapes.");
     
-    if (verbose >= 2) cout << "Input matrix A: " << A
-            << "Input vector b: " << b;
+    if (verbose >= 2) {
+        cout << "Input matrix A: " << A;
+        if (B.ncols() == 1) cout << "Input vector b: " << Vector(B);
+        else cout << "Input right-hand sides B: " << B;
+    }
 
 #ifdef _PROFILE_TIME
     clock_t time_start = clock();
 #endif
     
-    Matrix A_t(A);
-    A_t.transpose();
-    
-    // Solve the system with normal equation
-    //       t     t -1
-    //  x = A  (A A )   b
-    //
-    Matrix x = A_t * (A * A_t).inverse() * b;
+    Matrix X;
+
+    if (A.nrows() == A.ncols()) {
+        
+        // A square system is solved with the LU factors of A directly.
+        // All right-hand sides share the factorization.
+        //
+        LUFactorization lu(A);
+        X = lu.solve(B);
+
+    } else {
+        
+        // A rectangular system is solved in the least-squares sense with
+        // the QR factorization. The minimum norm solution is returned when
+        // there are fewer equations than unknowns.
+        //
+        X = A.leastSquares(B);
+    }
 
 #ifdef _PROFILE_TIME
     clock_t time_end = clock();
@@ -65,7 +101,12 @@ int main(int argc, char** argv) {
     cout << setprecision(4) << "Total time for the direct method: " << duration_total << "s" << endl;
 #endif
     
-    if (verbose >= 1) cout << "Result x is: " << x << endl;
+    if (verbose >= 1) {
+        if (X.ncols() == 1) cout << "Result x is: " << Vector(X) << endl;
+        else cout << "Result X is: " << X << endl;
+    }
+
+    if (!output_file.empty()) X.writeMatrix(output_file);
     
     return 0;
 }
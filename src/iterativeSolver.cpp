@@ -7,11 +7,24 @@
  */
 
 #include "Matrix.h"
+#include "Vector.h"
+#include "SparseMatrix.h"
+#include "GaussSeidel.h"
+#include "Jacobi.h"
+#include "Krylov.h"
+#include "Preconditioner.h"
+#include "SolutionCache.h"
+#include "MixedPrecision.h"
+#include "Convergence.h"
+#include "StreamedMatrix.h"
 
 #include <numeric>
 #include <iomanip>
 #include <cmath>
 #include <ctime>
+#include <memory>
+#include <vector>
+#include <algorithm>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -20,110 +33,129 @@
 
 using namespace std;
 
-#define _SMALL_VALUE 1.0e-3;
+#define _SMALL_VALUE 1.0e-3
 
-void runGauss(const Matrix & A, const Matrix & b, Matrix & solution,
-        size_t max_it, size_t initialize_func, int verbose) {
-    // Gauss-Seidel Method
-    //
-    // For the linear system Ax = b,
-    // let L and U be the strict lower and upper triangular portions of A and
-    // D be the diagonal matrix, so that A = L + U + D.
-    // We then define M = D + L and N = U so that A = M + N.
-    // The iteration scheme is x_k+1 = M^-1 * (b - N * x_k);
-    //
-
-    // D is the diagonal matrix
-    Matrix D(A.nrows(), A.ncols());
-    for (size_t i = 0; i < D.nrows(); i++) D[i][i] = A[i][i];
-
-    // L and U is the strict lower and upper part of the matrix A
-    Matrix L(A.nrows(), A.ncols()), U(A.nrows());
-    for (size_t i = 0; i < A.nrows(); i++) {
-        for (size_t j = 0; j < i; j++) {
-            L[i][j] = A[i][j];
-        }
-
-        for (size_t j = i + 1; j < A.nrows(); j++) {
-            U[i][j] = A[i][j];
-        }
-    }
-
-    // Define M_inv
-    Matrix M_inv = (D + L).inverse();
-
-    // Initialize the residual vector
-    Matrix resids;
-
-    // Initialize the residual metric
-    double resid_metric = 999;
-
-    // Initialize the residual threshold
-    double small_resid = _SMALL_VALUE;
-
-    // Initialize the solution
-    Matrix solution_new(b.nrows(), 1);
+// Initialize the solution. The guess uses the first row of A, which is
+// passed as a function so that dense and sparse matrices are both covered.
+//
+template <typename FirstRow>
+void initializeSolution(const Vector & b, Vector & solution,
+        size_t initialize_func, FirstRow first_row) {
+    solution.resize(b.size());
     if (initialize_func == 1) {
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = 1;
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = 1;
         }
     } else if (initialize_func == 2) {
         std::srand(std::time(nullptr));
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = rand();
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = rand();
         }
     } else if (initialize_func == 3) {
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = b[0][0] / A[0][i] / solution_new.nrows();
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = b[0] / first_row(i) / solution.size();
         }
     } else {
         throw runtime_error("Error: Unknow initialize_func.");
     }
+}
+
+// Copy column j of X into x, and x back into column j of X
+static void
+getColumn(const Matrix & X, size_t j, Vector & x) {
+    x.resize(X.nrows());
+    for (size_t i = 0; i < X.nrows(); i++) x[i] = X[i][j];
+}
+
+static void
+setColumn(const Vector & x, size_t j, Matrix & X) {
+    for (size_t i = 0; i < X.nrows(); i++) X[i][j] = x[i];
+}
+
+// Print the warning of a solve that has not converged
+static void
+warnStatus(const string & name, Convergence::Status status) {
+    if (status != Convergence::CONVERGED) {
+        cout << " Warning: " << name << " " << Convergence::name(status) << "." << endl;
+    }
+}
+
+// A batch with one column is printed as a vector, so that the output of a
+// single right-hand side is not changed.
+//
+static void
+printColumns(ostream & os, const Matrix & X) {
+    if (X.ncols() == 1) os << Vector(X);
+    else os << X;
+}
+
+void runGauss(const LinearOperator & A, const Matrix & B, Matrix & X,
+        size_t max_it, int verbose, const Convergence & criterion,
+        double omega, bool symmetric, size_t ncolors) {
+    // Gauss-Seidel Method
+    //
+    // For the linear system Ax = b,
+    // let L and U be the strict lower and upper triangular portions of A and
+    // D be the diagonal matrix, so that A = L + U + D.
+    // The iteration scheme is x_k+1 = (D + L)^-1 * (b - U * x_k).
+    //
+    // Instead of inverting D + L, the scheme is carried out as a forward
+    // sweep over A that updates x in place. Please see GaussSeidel.h.
+    //
+    // The coloring is set up once for all right-hand sides.
+    //
+    GaussSeidel gauss(A, omega, symmetric, ncolors);
 
     if (verbose >= 3) {
-        cout << "A is " << A << "b is " << b;
+        cout << "A is ";
+        A.print(cout);
+        cout << "b is ";
+        printColumns(cout, B);
     }
 
     if (verbose >= 4) {
-        cout << "D is " << D << "L is " << L << "U is " << U
-            << "Initialized solution: " << solution_new << endl;
+        cout << "Relaxation factor: " << gauss.omega() << endl
+            << "Symmetric sweeps: " << (gauss.symmetric() ? "yes" : "no") << endl
+            << "Number of colors: " << gauss.ncolors() << endl
+            << "Initialized solution: ";
+        printColumns(cout, X);
+        cout << endl;
     }
 
-    for (size_t i_it = 0; i_it < max_it && resid_metric > small_resid; i_it++) {
+    Convergence::Status status = Convergence::CONVERGED;
+    Vector b, solution;
+    for (size_t j = 0; j < B.ncols(); j++) {
+        if (B.ncols() > 1 && verbose >= 2) cout << "Right-hand side " << j << endl;
 
-        solution = solution_new;
-        solution_new = M_inv * (b - U * solution);
-
-        resids = A * solution_new - b;
-        resid_metric = accumulate(resids.begin(), resids.end(), 0.0, [](
-                const double lhs, const vector<double> rhs) {
-            return (lhs + abs(rhs[0]));
-        });
-
-        if (verbose >= 2) {
-            cout << "Iteration " << i_it + 1 << " residual: " << resid_metric << endl;
-        }
+        getColumn(B, j, b);
+        getColumn(X, j, solution);
+        gauss.solve(b, solution, max_it, criterion, verbose);
+        status = Convergence::worst(status, gauss.status());
+        setColumn(solution, j, X);
     }
 
+    warnStatus("Gauss-Seidel Method", status);
+
     if (!A.checkDominant()) {
         cout << "Warning: Input matrix is not diagonally dominant."
-                << " Jacobi Method might not converge." << endl;
-    }
-
-    if (verbose >= 4) {
-        cout << "The iteration matrix M_inv * N is: " << M_inv * U << endl;
+                << " Gauss-Seidel Method might not converge." << endl;
     }
 
     return;
 }
 
-void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
-        size_t max_it, size_t initialize_func, int verbose) {
+void runJacobi(const LinearOperator & A, const Matrix & B, Matrix & X,
+        size_t max_it, int verbose, const Convergence & criterion,
+        size_t check_every, bool chebyshev) {
     // Jacobi Method
     //
     // For the linear system Ax = b,
     // let D be the diagonal matrix and R = A - D, so that A = D + R.
     // The iteration scheme is x_k+1 = D^-1 * (b - R * x_k)
+    // which is carried out as x_k+1 = x_k + D^-1 * (b - A * x_k).
+    //
+    // A batch of right-hand sides is iterated together, so that A * X is
+    // one blocked product per iteration.
     //
 
 #ifdef _PROFILE_TIME
@@ -134,51 +166,27 @@ void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
     double wtime_start = omp_get_wtime();
 #endif
 
-    // D is the diagonal matrix
-    Matrix D(A.nrows(), A.ncols());
-    for (size_t i = 0; i < D.nrows(); i++) D[i][i] = A[i][i];
-
-    // Inverse matrix D
-    Matrix D_inv(D.inverse());
-
-    // Initialize the matrix R
-    Matrix R = A - D;
-
-    // Initialize the residual vector
-    Matrix resids;
-
-    // Initialize the residual metric
-    double resid_metric = 999;
-
-    // Initialize the residual threshold
-    double small_resid = _SMALL_VALUE;
-
-    // Initialize the solution
-    Matrix solution_new(b.nrows(), 1);
-    if (initialize_func == 1) {
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = 1;
-        }
-    } else if (initialize_func == 2) {
-        std::srand(std::time(nullptr));
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = rand();
-        }
-    } else if (initialize_func == 3) {
-        for (size_t i = 0; i < solution_new.nrows(); i++) {
-            solution_new[i][0] = b[0][0] / A[0][i] / solution_new.nrows();
-        }
-    } else {
-        throw runtime_error("Error: Unknow initialize_func.");
-    }
+    // Only the inverse of the diagonal is computed. Please see Jacobi.h.
+    Jacobi jacobi(A);
+    jacobi.setCheckInterval(check_every);
+    jacobi.setChebyshev(chebyshev);
 
     if (verbose >= 3) {
-        cout << "A is " << A << "b is " << b;
+        cout << "A is ";
+        A.print(cout);
+        cout << "b is ";
+        printColumns(cout, B);
     }
 
     if (verbose >= 4) {
-        cout  << "D is " << D << "R is " << R
-            << "Initialized solution: " << solution_new << endl;
+        cout  << "D_inv is " << jacobi.inverseDiagonal()
+            << "Initialized solution: ";
+        printColumns(cout, X);
+        cout << endl;
+
+        if (chebyshev) {
+            cout << "Spectral radius estimate: " << jacobi.spectralRadius() << endl;
+        }
     }
 
 #ifdef _PROFILE_TIME
@@ -188,65 +196,13 @@ void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
 #ifdef _WALL_TIME
     double wtime_end_of_preprocessing = omp_get_wtime();
 #endif
-    resids.resize(solution_new.nrows(), 1);
-
-#if defined(_OPENMP)
-#pragma omp parallel default(none) \
-shared(max_it, small_resid, D_inv, b, R, A, verbose, solution_new, resids, solution, resid_metric, cout)
-#endif
-    {
-        int thread_num = omp_get_thread_num();
-        for (size_t i_it = 0; i_it < max_it && resid_metric > small_resid; i_it++) {
 
-            if (thread_num == 0) {
-                solution = solution_new;
-            }
-
-#pragma omp barrier
-#pragma omp for schedule(static)
-            for (int i_row = 0; i_row < solution_new.nrows(); i_row++) {
-
-                double sum = 0.0;
-                for (int i_col = 0; i_col < R.ncols(); i_col++) {
-                    sum += R[i_row][i_col] * solution[i_col][0];
-                }
-                solution_new[i_row][0] = b[i_row][0] - sum;
-            }
-#pragma omp barrier
-#pragma omp for schedule(static)
-            for (int i_row = 0; i_row < solution_new.nrows(); i_row++) {
-                double sum = 0.0;
-                auto solution_old = solution_new;
-                for (int i_col = 0; i_col < D_inv.ncols(); i_col++) {
-                    sum += D_inv[i_row][i_col] * solution_old[i_col][0];
-                }
-                solution_new[i_row][0] = sum;
-            }
-            //solution_new = D_inv * (b - R * solution);
-#pragma omp barrier
-#pragma omp for schedule(static)
-            for (int i_row = 0; i_row < resids.nrows(); i_row++) {
-                double sum = 0.0;
-                for (int i_col = 0; i_col < R.ncols(); i_col++) {
-                    sum += A[i_row][i_col] * solution_new[i_col][0];
-                }
-                resids[i_row][0] = sum - b[i_row][0];
-            }
-            //resids = A * solution_new - b;
-#pragma omp barrier
-
-            if (thread_num == 0) {
-                resid_metric = accumulate(resids.begin(), resids.end(), 0.0, [](
-                            const double lhs, const vector<double> rhs) {
-                        return (lhs + abs(rhs[0]));
-                        });
-
-                if (verbose >= 2) {
-                    cout << "Iteration " << i_it + 1 << " residual: " << resid_metric << endl;
-                }
-            }
-#pragma omp barrier
-        }
+    if (B.ncols() == 1) {
+        Vector b(B), solution(X);
+        jacobi.solve(b, solution, max_it, criterion, verbose);
+        setColumn(solution, 0, X);
+    } else {
+        jacobi.solve(B, X, max_it, criterion, verbose);
     }
 
 #ifdef _PROFILE_TIME
@@ -257,17 +213,13 @@ shared(max_it, small_resid, D_inv, b, R, A, verbose, solution_new, resids, solut
     double wtime_end_of_loop = omp_get_wtime();
 #endif
 
-    if (resid_metric > small_resid) {
-        cout << " Warning: Jacobi Method did not converge." << endl;
+    if (jacobi.status() != Convergence::CONVERGED) {
+        warnStatus("Jacobi Method", jacobi.status());
 
         if (!A.checkDominant()) {
             cout << "Warning: Input matrix is not diagonally dominant.";
         }
     }
-
-    if (verbose >= 4) {
-        cout << "The iteration matrix D_inv * R is: " << D_inv * R << endl;
-    }
     
 #ifdef _WALL_TIME
     double wtime_end = omp_get_wtime();
@@ -303,6 +255,173 @@ shared(max_it, small_resid, D_inv, b, R, A, verbose, solution_new, resids, solut
     return;
 }
 
+template <typename MatrixType>
+void runKrylov(const MatrixType & A, const Matrix & B, Matrix & X,
+        size_t max_it, int verbose, const Convergence & criterion,
+        Krylov::Method method, size_t restart,
+        const string & preconditioner, size_t block_size) {
+    // Krylov Subspace Methods
+    //
+    // The solution is searched in the subspace spanned by the residual r_0
+    // and A * r_0, A^2 * r_0, ..., so that only the products with A are
+    // needed and A does not have to be diagonally dominant. CG needs a
+    // symmetric positive definite A. Please see Krylov.h.
+    //
+
+#ifdef _PROFILE_TIME
+    clock_t time_start = clock();
+#endif
+
+    Krylov krylov(A, method, restart);
+
+    // The preconditioner M approximates A. Please see Preconditioner.h.
+    // It is set up once for all right-hand sides.
+    //
+    unique_ptr<Preconditioner> M;
+    if (!preconditioner.empty()) {
+        M = makePreconditioner(preconditioner, A, block_size);
+        krylov.setPreconditioner(M.get());
+    }
+
+    if (verbose >= 3) {
+        cout << "A is ";
+        A.print(cout);
+        cout << "b is ";
+        printColumns(cout, B);
+    }
+
+    if (verbose >= 4) {
+        if (method == Krylov::GMRES) {
+            cout << "Restart: " << krylov.restart() << endl;
+        }
+        if (M) {
+            cout << "Preconditioner: " << M->name() << endl;
+        }
+        cout << "Initialized solution: ";
+        printColumns(cout, X);
+        cout << endl;
+    }
+
+#ifdef _PROFILE_TIME
+    clock_t time_end_of_setup = clock();
+#endif
+
+    Convergence::Status status = Convergence::CONVERGED;
+    Vector b, solution;
+    for (size_t j = 0; j < B.ncols(); j++) {
+        if (B.ncols() > 1 && verbose >= 2) cout << "Right-hand side " << j << endl;
+
+        getColumn(B, j, b);
+        getColumn(X, j, solution);
+        krylov.solve(b, solution, max_it, criterion, verbose);
+        status = Convergence::worst(status, krylov.status());
+        setColumn(solution, j, X);
+    }
+
+#ifdef _PROFILE_TIME
+    clock_t time_end_of_loop = clock();
+#endif
+
+    warnStatus(Krylov::name(method), status);
+
+#ifdef _PROFILE_TIME
+    clock_t time_end = clock();
+
+    double duration_total = (time_end - time_start) / (double) CLOCKS_PER_SEC;
+    double duration_setup = (time_end_of_setup - time_start) / (double) CLOCKS_PER_SEC;
+    double duration_loop = (time_end_of_loop - time_end_of_setup) / (double) CLOCKS_PER_SEC;
+    double duration_apply = (M ? M->applyTime() : 0.0);
+
+    cout << "(Krylov) Preconditioner setup: " << duration_setup << "s (" << 100 * duration_setup / duration_total << "%)" << endl
+        << "(Krylov) Loop: " << duration_loop << "s (" << 100 * duration_loop / duration_total << "%)" << endl
+        << "(Krylov) Preconditioner apply: " << duration_apply << "s (" << 100 * duration_apply / duration_total << "%) in "
+        << (M ? M->applications() : 0) << " applications" << endl
+        << "(Krylov) Total time: " << duration_total << "s (100%)" << endl;
+#endif
+
+    return;
+}
+
+template <typename MatrixType>
+void runRefinement(const MatrixType & A, const Matrix & B, Matrix & X,
+        size_t max_it, int verbose, const Convergence & criterion,
+        const string & function_str, double omega, size_t ncolors, size_t restart,
+        const string & preconditioner, size_t block_size, size_t check_every,
+        bool chebyshev) {
+    // Mixed-precision Iterative Refinement
+    //
+    // A is also stored in single precision, and the method solves the
+    // corrections A * d = r on it, so the mat-vec of the inner iterations
+    // reads half the bytes. The residuals r = b - A * x of the refinement
+    // steps use A in double. Please see MixedPrecision.h.
+    //
+    SingleMatrix A_single(A);
+
+    unique_ptr<Jacobi> jacobi;
+    unique_ptr<GaussSeidel> gauss;
+    unique_ptr<Krylov> krylov;
+    unique_ptr<Preconditioner> M;
+
+    if (function_str == "Jacobi" || function_str == "J") {
+        jacobi.reset(new Jacobi(A_single));
+        jacobi->setCheckInterval(check_every);
+        jacobi->setChebyshev(chebyshev);
+    } else if (function_str == "Gauss" || function_str == "G" ||
+            function_str == "SOR" || function_str == "S" || function_str == "SSOR") {
+        gauss.reset(new GaussSeidel(A_single, omega, function_str == "SSOR", ncolors));
+    } else {
+        krylov.reset(new Krylov(A_single, Krylov::method(function_str), restart));
+
+        // The preconditioner is an approximation anyway, so it is built on
+        // A in double as without the refinement
+        //
+        if (!preconditioner.empty()) {
+            M = makePreconditioner(preconditioner, A, block_size);
+            krylov->setPreconditioner(M.get());
+        }
+    }
+
+    // Every inner solve reduces the residual by REFINEMENT_INNER_TOLERANCE,
+    // which is a tolerance relative to r as the right-hand side
+    //
+    Convergence inner(REFINEMENT_INNER_TOLERANCE, criterion.norm(), true);
+    IterativeRefinement::Correction correct = [&](const Vector & r, Vector & d) {
+        int inner_verbose = (verbose >= 3 ? 2 : 0);
+
+        if (jacobi) jacobi->solve(r, d, max_it, inner, inner_verbose);
+        else if (gauss) gauss->solve(r, d, max_it, inner, inner_verbose);
+        else krylov->solve(r, d, max_it, inner, inner_verbose);
+    };
+
+    IterativeRefinement refinement(A, correct);
+
+    if (verbose >= 2) {
+        cout << "Single-precision matrix: " << A_single.bytes() << " bytes" << endl;
+    }
+
+    Convergence::Status status = Convergence::CONVERGED;
+    Vector b, solution;
+    for (size_t j = 0; j < B.ncols(); j++) {
+        if (B.ncols() > 1 && verbose >= 2) cout << "Right-hand side " << j << endl;
+
+        getColumn(B, j, b);
+        getColumn(X, j, solution);
+        refinement.solve(b, solution, criterion, verbose);
+        status = Convergence::worst(status, refinement.status());
+        setColumn(solution, j, X);
+    }
+
+    if (status != Convergence::CONVERGED) {
+        warnStatus("The mixed-precision refinement", status);
+
+        if (!A.checkDominant() && !krylov) {
+            cout << "Warning: Input matrix is not diagonally dominant." << endl;
+        }
+    }
+
+    return;
+}
+
 int main(int argc, char** argv) {
 
 #ifdef _WALL_TIME
@@ -313,28 +432,150 @@ int main(int argc, char** argv) {
     clock_t time_start = clock();
 #endif
 
-    if (argc != 6 && argc != 7) {
-        cout << "iterativeSolver <Jacobi,J|Gauss,G> <matrix csv> <vector csv> <maximum iteration> <initilization> [A verbose flag integer]"
+    if (argc < 6) {
+        cout << "iterativeSolver <Jacobi,J|Gauss,G|SOR,S|SSOR|CG|BiCGSTAB|GMRES> <matrix csv> <vector csv> <maximum iteration> <initilization> [A verbose flag integer] [options]"
              << endl << endl << "\tVerbose level specification: " << endl << "\t\t0 - Quiet" << endl
              << "\t\t1 - Result only" << endl << "\t\t2 - The above plus iteration information" << endl
              << "\t\t3 - The above plus input " << endl << "\t\t4 - The above plus transformed matrix" << endl
              << endl << "\tInitialization specification: " << endl << "\t\t1 - All 1s" << endl
-             << "\t\t2 - Random numbers" << endl << "\t\t3 - Guess" << endl;
+             << "\t\t2 - Random numbers" << endl << "\t\t3 - Guess" << endl
+             << endl << "\tOptions: " << endl
+             << "\t\t--omega <value>   Relaxation factor of Gauss-Seidel, SOR, and SSOR (default 1)" << endl
+             << "\t\t--colors <number> Largest number of colors of the multicolor ordering of the sweeps (default 1)" << endl
+             << "\t\t--restart <number> Number of GMRES iterations between restarts (default " << KRYLOV_RESTART << ")" << endl
+             << "\t\t--preconditioner <jacobi|ilu0|block> Preconditioner of CG, BiCGSTAB, and GMRES (default none)" << endl
+             << "\t\t--block-size <number> Number of rows in the blocks of the block preconditioner (default " << BLOCK_JACOBI_SIZE << ")" << endl
+             << "\t\t--check-every <number> Number of Jacobi iterations between the residual checks (default 1)" << endl
+             << "\t\t--chebyshev       Accelerate the Jacobi iterations with the Chebyshev semi-iteration" << endl
+             << "\t\t--tolerance <value> Tolerance of the norm of the residual (default " << _SMALL_VALUE << ")" << endl
+             << "\t\t--norm <l1|l2|inf> Norm of the residual (default l1)" << endl
+             << "\t\t--relative        The tolerance is relative to the norm of b" << endl
+             << "\t\t--stagnation <number> Stop when the residual has not decreased by 1% in this number of checks" << endl
+             << "\t\t--divergence <factor> Stop when the residual has grown by this factor from the first one" << endl
+             << "\t\t--sparse          Store the matrix in the CSR format without zeros" << endl
+             << "\t\t--sell            Use the SELL-C-sigma layout for the sparse mat-vec (implies --sparse)" << endl
+             << "\t\t--single          Iterate on a single-precision copy of the matrix with iterative refinement in double" << endl
+             << "\t\t--stream <MB>     Stream the binary matrix file in panels of this size instead of loading it" << endl
+             << "\t\t--output <csv>    Write the solutions to a csv file with one solution per column, or to a" << endl
+             << "\t\t                  NetCDF variable as <file>.nc:<variable>" << endl
+             << "\t\t--guess <csv>     Read the initial guess, which replaces the initialization" << endl
+             << "\t\t--cache <directory> Reuse the converged solutions of previous runs. The same system is" << endl
+             << "\t\t                  not solved again, and the closest system gives the initial guess." << endl
+             << endl << "\tThe vector csv can also be a matrix with one right-hand side per column, or a" << endl
+             << "\tdirectory of vectors. All right-hand sides are solved in one run." << endl
+             << endl << "\tThe matrix and the vectors can also be NetCDF variables as <file>.nc:<variable>." << endl;
         return 0;
     }
 
     // Read verbose flag
-    int verbose = 1;
-    if (argc == 7) {
-        verbose = atoi(argv[argc - 1]);
+    int verbose = 1, i_arg = 6;
+    if (argc > 6 && argv[6][0] != '-') {
+        verbose = atoi(argv[6]);
+        i_arg++;
+    }
+
+    // Read options
+    double omega = 1.0, tolerance = _SMALL_VALUE, divergence = 0.0;
+    size_t ncolors = 1, restart = KRYLOV_RESTART, block_size = BLOCK_JACOBI_SIZE, check_every = 1;
+    size_t stagnation = 0, stream_mb = 0;
+    string preconditioner, output_file, guess_file, cache_directory, norm_name = "l1";
+    bool sparse = false, sell = false, single = false, relative = false, chebyshev = false;
+
+    for (; i_arg < argc; i_arg++) {
+        string option(argv[i_arg]);
+
+        if (option == "--omega" && i_arg + 1 < argc) {
+            omega = atof(argv[++i_arg]);
+        } else if (option == "--colors" && i_arg + 1 < argc) {
+            ncolors = atoi(argv[++i_arg]);
+        } else if (option == "--restart" && i_arg + 1 < argc) {
+            restart = atoi(argv[++i_arg]);
+        } else if (option == "--preconditioner" && i_arg + 1 < argc) {
+            preconditioner = argv[++i_arg];
+        } else if (option == "--block-size" && i_arg + 1 < argc) {
+            block_size = atoi(argv[++i_arg]);
+        } else if (option == "--check-every" && i_arg + 1 < argc) {
+            check_every = atoi(argv[++i_arg]);
+        } else if (option == "--chebyshev") {
+            chebyshev = true;
+        } else if (option == "--tolerance" && i_arg + 1 < argc) {
+            tolerance = atof(argv[++i_arg]);
+        } else if (option == "--norm" && i_arg + 1 < argc) {
+            norm_name = argv[++i_arg];
+        } else if (option == "--relative") {
+            relative = true;
+        } else if (option == "--stagnation" && i_arg + 1 < argc) {
+            stagnation = atoi(argv[++i_arg]);
+        } else if (option == "--divergence" && i_arg + 1 < argc) {
+            divergence = atof(argv[++i_arg]);
+        } else if (option == "--output" && i_arg + 1 < argc) {
+            output_file = argv[++i_arg];
+        } else if (option == "--guess" && i_arg + 1 < argc) {
+            guess_file = argv[++i_arg];
+        } else if (option == "--cache" && i_arg + 1 < argc) {
+            cache_directory = argv[++i_arg];
+        } else if (option == "--sparse") {
+            sparse = true;
+        } else if (option == "--sell") {
+            sparse = sell = true;
+        } else if (option == "--single") {
+            single = true;
+        } else if (option == "--stream" && i_arg + 1 < argc) {
+            stream_mb = atoi(argv[++i_arg]);
+            if (stream_mb == 0) {
+                cout << "Error: The panel size of --stream should be positive." << endl;
+                return 1;
+            }
+        } else {
+            cout << "Error: Unknown option " << option << endl;
+            return 1;
+        }
+    }
+
+    // Read function name
+    string function_str(argv[1]);
+    bool is_jacobi = (function_str == "Jacobi" || function_str == "J");
+    bool is_gauss = (function_str == "Gauss" || function_str == "G" ||
+            function_str == "SOR" || function_str == "S" || function_str == "SSOR");
+    bool is_krylov = (function_str == "CG" || function_str == "BiCGSTAB" ||
+            function_str == "GMRES");
+
+    if (!is_jacobi && !is_gauss && !is_krylov) {
+        cout << "Error: Unknown function name " << function_str << endl;
+        return 1;
     }
 
-    // I store the vector b in form of a matrix with only one column.
-    Matrix A, b;
+    // The convergence criterion of all methods. Please see Convergence.h.
+    Convergence criterion(tolerance, Convergence::norm(norm_name), relative);
+    criterion.setStagnation(stagnation);
+    criterion.setDivergence(divergence);
 
-    // Read input files
-    A.readMatrix(argv[2]);
-    b.readMatrix(argv[3]);
+    bool stream = (stream_mb > 0);
+    if (stream && (sparse || single || !cache_directory.empty())) {
+        cout << "Error: --stream can't be used with --sparse, --sell, --single, or --cache." << endl;
+        return 1;
+    }
+
+    Matrix A_dense;
+    SparseMatrix A_sparse;
+    unique_ptr<StreamedMatrix> A_stream;
+    Matrix B;
+
+    // Read input files. The sparse matrix is read without the dense matrix,
+    // and the streamed matrix is never read as a whole.
+    //
+    if (stream) {
+        A_stream.reset(new StreamedMatrix(argv[2], stream_mb << 20));
+    } else if (sparse) {
+        A_sparse.readMatrix(argv[2]);
+        if (sell) A_sparse.setLayout(SparseMatrix::SELL);
+    } else {
+        A_dense.readMatrix(argv[2]);
+    }
+    B = readRightHandSides(argv[3]);
+
+    const LinearOperator & A = (stream ? *A_stream : sparse ?
+            static_cast<const LinearOperator &> (A_sparse) : A_dense);
 
     size_t max_it = atoi(argv[4]);
     size_t initialize_func = atoi(argv[5]);
@@ -347,30 +588,169 @@ int main(int argc, char** argv) {
     clock_t time_end_of_read = clock();
 #endif
 
-    // Define solution
-    Matrix solution;
+    // Define solutions. Every column is initialized from its own
+    // right-hand side.
+    //
+    Matrix X(B.nrows(), B.ncols());
+    Vector b, solution, first_row;
+    if (stream && initialize_func == 3) A_stream->readRow(0, first_row);
+
+    for (size_t j = 0; j < B.ncols(); j++) {
+        getColumn(B, j, b);
+
+        if (stream) {
+            initializeSolution(b, solution, initialize_func,
+                    [&first_row](size_t i) { return (first_row[i]); });
+        } else if (sparse) {
+            initializeSolution(b, solution, initialize_func,
+                    [&A_sparse](size_t i) { return (A_sparse.value(0, i)); });
+        } else {
+            initializeSolution(b, solution, initialize_func,
+                    [&A_dense](size_t i) { return (A_dense[0][i]); });
+        }
 
-    // Read function name
-    string function_str(argv[1]);
-    if (function_str == "Jacobi" || function_str == "J") {
-        runJacobi(A, b, solution, max_it, initialize_func, verbose);
+        setColumn(solution, j, X);
+    }
+
+    // The initial guess replaces the initialization
+    if (!guess_file.empty()) {
+        X = readRightHandSides(guess_file);
+        if (X.nrows() != B.nrows() || X.ncols() != B.ncols()) {
+            throw runtime_error("Error: The initial guess does not have the shape of the right-hand sides.");
+        }
+    }
+
+    // Look up the solutions in the cache. A system that has been solved
+    // is not solved again, and otherwise the solution of the closest
+    // system is the initial guess.
+    //
+    unique_ptr<SolutionCache> cache;
+    vector<unsigned long long> keys(B.ncols());
+    vector<size_t> unsolved;
+
+    for (size_t j = 0; j < B.ncols(); j++) {
+        if (cache_directory.empty()) {
+            unsolved.push_back(j);
+            continue;
+        }
+
+        if (!cache) cache.reset(new SolutionCache(cache_directory));
+
+        getColumn(B, j, b);
+        getColumn(X, j, solution);
+        keys[j] = (sparse ? fingerprint(A_sparse, b) : fingerprint(A_dense, b));
+
+        double distance = 0.0;
+        SolutionCache::Match match = cache->lookup(keys[j], A, b, solution, distance);
+        setColumn(solution, j, X);
+
+        if (match == SolutionCache::EXACT) {
+            if (verbose >= 1) cout << "Solution of right-hand side " << j << " is found in the cache." << endl;
+        } else {
+            if (match == SolutionCache::CLOSEST && verbose >= 1) {
+                cout << "Initial guess of right-hand side " << j << " is from the cache (distance "
+                        << distance << ")." << endl;
+            }
+            unsolved.push_back(j);
+        }
+    }
+
+    // Only the columns that are not in the cache are solved
+    bool all_columns = (unsolved.size() == B.ncols());
+    Matrix B_solve, X_solve;
+    if (!all_columns) {
+        B_solve.resize(B.nrows(), unsolved.size());
+        X_solve.resize(X.nrows(), unsolved.size());
+        for (size_t k = 0; k < unsolved.size(); k++) {
+            getColumn(B, unsolved[k], b);
+            setColumn(b, k, B_solve);
+            getColumn(X, unsolved[k], solution);
+            setColumn(solution, k, X_solve);
+        }
+    }
+
+    const Matrix & B_run = (all_columns ? B : B_solve);
+    Matrix & X_run = (all_columns ? X : X_solve);
+
+    if (unsolved.empty()) {
+        // Every solution is from the cache
 
-    } else if (function_str == "Gauss" || function_str == "G") {
-        runGauss(A, b, solution,  max_it, initialize_func, verbose);
+    } else if (single && sparse) {
+        runRefinement(A_sparse, B_run, X_run, max_it, verbose, criterion, function_str,
+                omega, ncolors, restart, preconditioner, block_size, check_every, chebyshev);
+    } else if (single) {
+        runRefinement(A_dense, B_run, X_run, max_it, verbose, criterion, function_str,
+                omega, ncolors, restart, preconditioner, block_size, check_every, chebyshev);
 
+    } else if (is_jacobi) {
+        runJacobi(A, B_run, X_run, max_it, verbose, criterion, check_every, chebyshev);
+
+    } else if (is_gauss) {
+        runGauss(A, B_run, X_run,  max_it, verbose, criterion,
+                omega, function_str == "SSOR", ncolors);
+
+    } else if (stream) {
+        runKrylov(*A_stream, B_run, X_run, max_it, verbose, criterion,
+                Krylov::method(function_str), restart, preconditioner, block_size);
+    } else if (sparse) {
+        runKrylov(A_sparse, B_run, X_run, max_it, verbose, criterion,
+                Krylov::method(function_str), restart, preconditioner, block_size);
     } else {
-        cout << "Error: Unknown function name " << function_str << endl;
-        return 1;
+        runKrylov(A_dense, B_run, X_run, max_it, verbose, criterion,
+                Krylov::method(function_str), restart, preconditioner, block_size);
+    }
+
+    if (!all_columns) {
+        for (size_t k = 0; k < unsolved.size(); k++) {
+            getColumn(X_solve, k, solution);
+            setColumn(solution, unsolved[k], X);
+        }
+    }
+
+    // The converged solutions are saved to the cache. The residuals are
+    // measured in the norm of the criterion.
+    //
+    Matrix R;
+    Vector resids, r;
+    if (cache || X.ncols() > 1) {
+        residuals(A, X, B, R);
+        resids.resize(X.ncols());
+        for (size_t j = 0; j < X.ncols(); j++) {
+            resids[j] = criterion.finish(criterion.accumulate(R[0] + j, R.nrows(), R.stride()));
+        }
+    }
+
+    if (cache) {
+        for (size_t j : unsolved) {
+            getColumn(B, j, b);
+            getColumn(R, j, r);
+            if (!criterion.satisfied(r, b)) continue;
+
+            getColumn(X, j, solution);
+            cache->store(keys[j], A, b, solution);
+        }
     }
 
     if (verbose >= 1) {
-        if (function_str == "Jacobi" || function_str == "J") {
-            cout << "Result from Jacobi x is " << endl << solution << endl;
-        } else if (function_str == "Gauss" || function_str == "G") {
-            cout << "Result from Gauss-Seidel x is " << endl << solution << endl;
+        string name = function_str;
+        if (is_jacobi) name = "Jacobi";
+        else if (function_str == "Gauss" || function_str == "G") name = "Gauss-Seidel";
+        else if (function_str == "SOR" || function_str == "S") name = "SOR";
+
+        // The residual of every right-hand side of a batch
+        if (X.ncols() > 1) {
+            for (size_t j = 0; j < resids.size(); j++) {
+                cout << "Residual of right-hand side " << j << ": " << resids[j] << endl;
+            }
         }
+
+        cout << "Result from " << name << (X.ncols() == 1 ? " x is " : " X is ") << endl;
+        printColumns(cout, X);
+        cout << endl;
     }
 
+    if (!output_file.empty()) X.writeMatrix(output_file);
+
 #ifdef _WALL_TIME
     double wtime_end = omp_get_wtime();
 #endif
@@ -7,6 +7,9 @@
  */
 
 #include "Matrix.h"
+#include "Vector.h"
+#include "DistributedJacobi.h"
+#include "DistributedKrylov.h"
 
 #include <algorithm>
 #include <numeric>
@@ -16,13 +19,73 @@
 
 #include <mpi.h>
 #include <iterator>
+#include <string>
+#include <cstdio>
+#include <memory>
+#include <functional>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 using namespace std;
 
 #define _SMALL_VALUE 1.0e-3;
 
-void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
-        size_t max_it, size_t initialize_func, int verbose) {
+// The matrix of generate:<N>
+//
+// The off-diagonal values are spread over (0, 1] like the sampled values
+// of data/csv/generate_test.R, and a_ii = 1 + sum_j!=i a_ij makes every row
+// diagonally dominant. The entries are computed wherever they are needed,
+// so the matrix is never stored as a whole. The diagonal is stored for
+// the rows [begin, end), which are all the rows whose entries are used.
+//
+FunctionOperator::EntryFunction
+generatedMatrix(size_t n, size_t begin, size_t end) {
+    auto off_diagonal = [](size_t i, size_t j) {
+        return (((i * 7919 + j * 104729) % 1000 + 1) / 1000.0);
+    };
+
+    shared_ptr<Vector> diag(new Vector(end - begin, 1.0));
+    for (size_t i = begin; i < end; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (j != i) (*diag)[i - begin] += off_diagonal(i, j);
+        }
+    }
+
+    return ([off_diagonal, diag, begin](size_t i, size_t j) {
+        return (i == j ? (*diag)[i - begin] : off_diagonal(i, j));
+    });
+}
+
+// Initialize the solution on rank 0. The guess uses the first row of A,
+// which is passed as a function so that generated matrices are covered.
+//
+void initializeSolution(size_t n, const Vector & b, Vector & solution,
+        size_t initialize_func, const function<double(size_t)> & first_row) {
+    solution.resize(n);
+
+    if (initialize_func == 1) {
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = 1;
+        }
+    } else if (initialize_func == 2) {
+        std::srand(std::time(nullptr));
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = rand();
+        }
+    } else if (initialize_func == 3) {
+        for (size_t i = 0; i < solution.size(); i++) {
+            solution[i] = b[0] / first_row(i) / solution.size();
+        }
+    } else {
+        throw runtime_error("Error: Unknown initialize_func.");
+    }
+}
+
+void runJacobi(DistributedJacobi & jacobi, const Matrix & A, const Vector & b,
+        Vector & solution, size_t max_it, size_t initialize_func, int verbose,
+        bool pipelined, bool chebyshev, const function<double(size_t)> & first_row) {
     // Jacobi Method
     //
     // We have our serial system set up as x_k+1 = D^-1 * (b - R * x_k)
@@ -30,243 +93,119 @@ void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
     // D * Δx = b - A * x_k, where the error term Δx = x_k+1 - x_k
     //
     // By doing this transformation, we separate the error term which 
-    // makes the parallelization easier.
+    // makes the parallelization easier. Each process owns a block of A
+    // and updates its part of the solution. Please see DistributedJacobi.h.
     //
 
     int world_size = -1, world_rank = -1;
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
-    Matrix D, D_inv, part_error;
-    double resid = 999, small_resid = _SMALL_VALUE;
-    
+    double small_resid = _SMALL_VALUE;
 
-    if (world_rank == 0) {
-        D.resize(A.nrows(), A.ncols());
-        for (size_t i = 0; i < D.nrows(); i++) D[i][i] = A[i][i];
-
-        D_inv = D.inverse();
-        
-        solution.resize(A.ncols(), 1);
+    // The blocks of A and b are distributed, or computed, by the caller
+    jacobi.setPipelined(pipelined);
+    jacobi.setChebyshev(chebyshev);
 
-        if (initialize_func == 1) {
-            for (size_t i = 0; i < solution.nrows(); i++) {
-                solution[i][0] = 1;
-            }
-        } else if (initialize_func == 2) {
-            std::srand(std::time(nullptr));
-            for (size_t i = 0; i < solution.nrows(); i++) {
-                solution[i][0] = rand();
-            }
-        } else if (initialize_func == 3) {
-            for (size_t i = 0; i < solution.nrows(); i++) {
-                solution[i][0] = b[0][0] / A[0][i] / solution.nrows();
-            }
-        } else {
-            throw runtime_error("Error: Unknown initialize_func.");
-        }
+    if (world_rank == 0) {
+        initializeSolution(jacobi.grid().rows().nrows(), b, solution, initialize_func, first_row);
 
-        if (verbose >= 3) {
+        if (verbose >= 3 && A.nrows() > 0) {
             cout << "A is " << A << "b is " << b;
         }
 
         if (verbose >= 4) {
-            cout << "D is " << D << "Initialized solution: "
-                    << solution << endl;
+            cout << "Process grid is " << jacobi.grid().nprows() << " x " << jacobi.grid().npcols()
+#if defined(_OPENMP)
+                    << " with " << omp_get_max_threads() << " threads per process"
+#endif
+                    << endl
+                    << "Inverse diagonal of the first block is " << jacobi.localInverseDiagonal()
+                    << "Initialized solution: " << solution << endl;
         }
     }
 
-    // Collectively declare memory as remotely accessible
-    MPI_Win win_A_data, win_A_nrows, win_A_ncols, win_solution_data,
-            win_errors_data, win_b_data, win_resid;
-    
-    struct continuousMatrix *p_cm_A = NULL, *p_cm_b = NULL, 
-            *p_cm_errors = NULL, *p_cm_solution = NULL;
+    // The initial solution is broadcast from rank 0
+    jacobi.solve(solution, max_it, small_resid, verbose);
 
+    // All ranks check the dominance of their own rows together
+    if (!jacobi.matrix().checkDominant() && world_rank == 0) {
+        cout << "Warning: Input matrix is not diagonally dominant."
+                << " Jacobi Method might not converge." << endl;
+    }
 
-    if (world_rank == 0) {
-        // Add A to remote memory
-        p_cm_A = A.toContinuousMatrix();
-        
-        MPI_Win_create(p_cm_A->data, p_cm_A->length * sizeof (double), sizeof (double),
-                MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_data);
-        MPI_Win_create(&(p_cm_A->nrows), sizeof (int), sizeof (int),
-                MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_nrows);
-        MPI_Win_create(&(p_cm_A->ncols), sizeof (int), sizeof (int),
-                MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_ncols);
-        
-        // Add errors to remote memory
-        p_cm_errors = (struct continuousMatrix *) malloc(sizeof(struct continuousMatrix));
-        p_cm_errors->ncols = 1;
-        p_cm_errors->length = A.ncols();
-        p_cm_errors->nrows = p_cm_errors->length;
-        p_cm_errors->data = (double *) malloc(p_cm_errors->nrows * sizeof (double));
-
-        MPI_Win_create(p_cm_errors->data, p_cm_errors->length * sizeof(double),
-                sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &win_errors_data);
-        
-        // Add solution to remote memory
-        p_cm_solution = solution.toContinuousMatrix();
-        
-        MPI_Win_create(p_cm_solution->data, p_cm_solution->length * sizeof(double),
-                sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &win_solution_data);
-        
-        // Add b to remote memory
-        p_cm_b = b.toContinuousMatrix();
+    return;
+}
 
-        MPI_Win_create(p_cm_b->data, p_cm_b->length * sizeof(double), sizeof(double),
-                MPI_INFO_NULL, MPI_COMM_WORLD, &win_b_data);
-        
-        // Add residuals to remote memory
-        MPI_Win_create(&resid, sizeof(double), sizeof(double),
-                MPI_INFO_NULL, MPI_COMM_WORLD, &win_resid);
-        
-    } else {
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_data);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_nrows);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_A_ncols);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_errors_data);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_solution_data);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_b_data);
-        MPI_Win_create(MPI_BOTTOM, 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &win_resid);
-    }
+void runKrylov(const DistributedMatrix & A_dist, const Matrix & A, const Vector & b,
+        Vector & solution, size_t max_it, size_t initialize_func, int verbose,
+        Krylov::Method method, size_t restart, const string & preconditioner,
+        size_t block_size, const function<double(size_t)> & first_row) {
+    // Krylov Subspace Methods
+    //
+    // The vectors are split over the processes as the solution of the
+    // Jacobi Method, and the inner products are added up with
+    // MPI_Allreduce. Please see DistributedKrylov.h.
+    //
+
+    int world_rank = -1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
-    int nrows = -1, ncols = -1, nrows_to_read = -1, row_start = -1, row_end = -1;
+    double small_resid = _SMALL_VALUE;
 
-    // Get number of rows from remote memory
-    MPI_Win_fence(0, win_A_nrows);
-    MPI_Get(&nrows, 1, MPI_INT, 0, 0, 1, MPI_INT, win_A_nrows);
-    MPI_Win_fence(0, win_A_nrows);
+    // The blocks of A are distributed, or computed, by the caller
+    DistributedKrylov krylov(A_dist, method, restart);
 
-    // Define rows for each process that should be read
-    nrows_to_read = nrows / world_size;
-    row_start = world_rank * nrows_to_read;
-    row_end = (world_rank + 1) * nrows_to_read - 1;
+#ifdef _PROFILE_TIME
+    double wtime_start_of_setup = MPI_Wtime();
+#endif
 
-    if (world_rank == world_size - 1) {
-        // The last process deals with the case when the number of rows cannot
-        // be divided using the number of processes.
-        //
-        nrows_to_read = nrows - nrows_to_read * (world_size - 1);
-        row_end = row_start + nrows_to_read - 1;
+    // The preconditioner only uses the diagonal block of every process
+    unique_ptr<Preconditioner> M;
+    if (!preconditioner.empty()) {
+        M = makeDistributedPreconditioner(preconditioner, A_dist, block_size);
+        krylov.setPreconditioner(M.get());
     }
 
-    // Get the number of columns from remote memory
-    MPI_Win_fence(0, win_A_ncols);
-    MPI_Get(&ncols, 1, MPI_INT, 0, 0, 1, MPI_INT, win_A_ncols);
-    MPI_Win_fence(0, win_A_ncols);
-
-    // Convert rows to matrix
-    struct continuousMatrix * p_cm_part_A;
-    p_cm_part_A = (struct continuousMatrix *) malloc(sizeof (struct continuousMatrix));
-    p_cm_part_A->data = (double *) malloc(nrows_to_read * ncols * sizeof (double));
-    p_cm_part_A->length = nrows_to_read * ncols;
-    p_cm_part_A->ncols = ncols;
-    p_cm_part_A->nrows = nrows_to_read;
-
-    // Get the rows of data A
-    MPI_Win_fence(0, win_A_data);
-    MPI_Get(p_cm_part_A->data, p_cm_part_A->length, MPI_DOUBLE, 0,
-            row_start * ncols, p_cm_part_A->length, MPI_DOUBLE, win_A_data);
-    MPI_Win_fence(0, win_A_data);
-
-    Matrix part_A;
-    part_A.fromContinuousMatrix(p_cm_part_A);
-    deleteContinuousMatrix(p_cm_part_A);
-    
-    // Get the rows of data b
-    struct continuousMatrix * p_cm_part_b;
-    p_cm_part_b = (struct continuousMatrix *) malloc(sizeof (struct continuousMatrix));
-    p_cm_part_b->data = (double *) malloc(nrows_to_read * 1 * sizeof (double));
-    p_cm_part_b->length = nrows_to_read * 1;
-    p_cm_part_b->ncols = 1;
-    p_cm_part_b->nrows = nrows_to_read;
-    
-    MPI_Win_fence(0, win_b_data);
-    MPI_Get(p_cm_part_b->data, p_cm_part_b->length, MPI_DOUBLE, 0,
-            row_start * 1, p_cm_part_b->length, MPI_DOUBLE, win_b_data);
-    MPI_Win_fence(0, win_b_data);
-
-    Matrix part_b;
-    part_b.fromContinuousMatrix(p_cm_part_b);
-    deleteContinuousMatrix(p_cm_part_b);
-    
-    struct continuousMatrix * p_cm_part_error = NULL;
-    double * solution_data = (double *) malloc(ncols * sizeof (double));
-    
-    if (world_rank != 0) solution.resize(ncols, 1);
-    
-    for (size_t i_it = 0; i_it < max_it && resid > small_resid; i_it++) {
-        
-        // Update solution
-        MPI_Win_fence(0, win_solution_data);
-        MPI_Get(solution_data, ncols, MPI_DOUBLE, 0,
-                0, ncols, MPI_DOUBLE, win_solution_data);
-        MPI_Win_fence(0, win_solution_data);
-        for (size_t i = 0; i < ncols; i++) solution[i][0] = solution_data[i];
-        
-        // Compute errors
-        part_error = part_b - part_A * solution;
-
-        // Write errors
-        p_cm_part_error = part_error.toContinuousMatrix();
-        MPI_Win_fence(0, win_errors_data);
-        MPI_Put(p_cm_part_error->data, p_cm_part_error->length, MPI_DOUBLE,
-                0, row_start * 1, p_cm_part_error->length, MPI_DOUBLE, win_errors_data);
-        MPI_Win_fence(0, win_errors_data);
-        deleteContinuousMatrix(p_cm_part_error);
-
-        // Evaluate errors
-        MPI_Barrier(MPI_COMM_WORLD);
-        if (world_rank == 0) {
-            resid = accumulate(p_cm_errors->data, p_cm_errors->data + p_cm_errors->length, 0.0, [](
-                    const double lhs, const double rhs) {
-                return (lhs + abs(rhs));
-            });
+#ifdef _PROFILE_TIME
+    double wduration_setup = MPI_Wtime() - wtime_start_of_setup;
+#endif
 
-            if (verbose >= 2) {
-                cout << "Iteration " << i_it + 1 << " residual: " << resid << endl;
-            }
-        }
-        
-        MPI_Barrier(MPI_COMM_WORLD);
-        MPI_Win_fence(0, win_resid);
-        MPI_Get(&resid, 1, MPI_DOUBLE, 0, 0, 1, MPI_DOUBLE, win_resid);
-        MPI_Win_fence(0, win_resid);
+    Vector b_own, x_own;
+    A_dist.scatter(b, b_own);
 
-        // Compute new solution
-        if (world_rank == 0) {
-            Matrix tmp_error;
-            tmp_error.fromContinuousMatrix(p_cm_errors);
-            solution = D_inv * tmp_error + solution;
-            for (size_t i = 0; i < ncols; i++) p_cm_solution->data[i] = solution[i][0];
+    if (world_rank == 0) {
+        initializeSolution(A_dist.grid().rows().nrows(), b, solution, initialize_func, first_row);
+
+        if (verbose >= 3 && A.nrows() > 0) {
+            cout << "A is " << A << "b is " << b;
         }
 
-        MPI_Barrier(MPI_COMM_WORLD);
+        if (verbose >= 4) {
+            cout << "Process grid is " << A_dist.grid().nprows() << " x " << A_dist.grid().npcols()
+#if defined(_OPENMP)
+                    << " with " << omp_get_max_threads() << " threads per process"
+#endif
+                    << endl << "Initialized solution: " << solution << endl;
+        }
     }
-    
-
-    if (world_rank == 0) {
 
-        if (!A.checkDominant()) {
-            cout << "Warning: Input matrix is not diagonally dominant."
-                    << " Jacobi Method might not converge." << endl;
-        }
+    // The initial solution is scattered from rank 0
+    A_dist.scatter(solution, x_own);
+    double resid = krylov.solve(b_own, x_own, max_it, small_resid, verbose);
+    A_dist.allgather(x_own, solution);
 
-        deleteContinuousMatrix(p_cm_A);
-        deleteContinuousMatrix(p_cm_b);
-        deleteContinuousMatrix(p_cm_errors);
-        deleteContinuousMatrix(p_cm_solution);
+    if (world_rank == 0 && resid > small_resid) {
+        cout << " Warning: " << Krylov::name(method) << " did not converge." << endl;
     }
 
-    free(solution_data);
-    MPI_Win_free(&win_A_data);
-    MPI_Win_free(&win_A_nrows);
-    MPI_Win_free(&win_A_ncols);
-    MPI_Win_free(&win_solution_data);
-    MPI_Win_free(&win_errors_data);
-    MPI_Win_free(&win_b_data);
-    MPI_Win_free(&win_resid);
+#ifdef _PROFILE_TIME
+    if (world_rank == 0 && M) {
+        cout << setprecision(4) << "Preconditioner setup: " << wduration_setup << "s" << endl
+                << "Preconditioner apply: " << M->applyTime() << "s in "
+                << M->applications() << " applications" << endl;
+    }
+#endif
 
     return;
 }
@@ -274,25 +213,120 @@ void runJacobi(const Matrix & A, const Matrix & b, Matrix & solution,
 int main(int argc, char** argv) {
 
     int world_size = -1, world_rank = -1, verbose = 1;
-    MPI_Init(&argc, &argv);
+    // The threads of a process only compute, and all MPI calls are made by
+    // the main thread outside of the parallel regions
+    //
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
-    if (argc != 5 && argc != 6) {
+    if (provided < MPI_THREAD_FUNNELED && world_rank == 0) {
+        cout << "Warning: The MPI library does not support threads. Please set OMP_NUM_THREADS=1." << endl;
+    }
+
+    if (argc < 5) {
         if (world_rank == 0) {
-            cout << "parallelJacobi <matrix csv> <vector csv> <maximum iteration> <initilization> [A verbose flag integer]"
+            cout << "parallelJacobi <matrix csv> <vector csv> <maximum iteration> <initilization> [A verbose flag integer] [options]"
                     << endl << endl << "\tVerbose level specification: " << endl << "\t\t0 - Quiet" << endl
                     << "\t\t1 - Result only" << endl << "\t\t2 - The above plus iteration information" << endl
                     << "\t\t3 - The above plus input " << endl << "\t\t4 - The above plus transformed matrix" << endl
                     << endl << "\tInitialization specification: " << endl << "\t\t1 - All 1s" << endl
-                    << "\t\t2 - Random numbers" << endl << "\t\t3 - Guess" << endl;
+                    << "\t\t2 - Random numbers" << endl << "\t\t3 - Guess" << endl
+                    << endl << "\tOptions: " << endl
+                    << "\t\t--pipelined       Overlap the collectives with the computation" << endl
+                    << "\t\t--chebyshev       Accelerate the Jacobi Method with the Chebyshev semi-iteration" << endl
+                    << "\t\t--grid <P>x<Q>    Distribute A over a P x Q process grid, or auto for a square grid" << endl
+                    << "\t\t--krylov <method> Use CG, BiCGSTAB, or GMRES instead of the Jacobi Method" << endl
+                    << "\t\t--restart <number> Number of GMRES iterations between restarts (default " << KRYLOV_RESTART << ")" << endl
+                    << "\t\t--preconditioner <jacobi|ilu0|block> Preconditioner of the Krylov methods on the diagonal block of every process" << endl
+                    << "\t\t--block-size <number> Number of rows in the blocks of the block preconditioner (default all rows of a process)" << endl
+                    << "\t\t--output <file>   Write the solution to a csv file, or to a NetCDF variable as <file>.nc:<variable>" << endl
+                    << "\t\t--verify         With a generated matrix, also solve with the matrix assembled on rank 0 and" << endl
+                    << "\t\t                  compare the solutions" << endl
+                    << endl << "\tThe matrix csv can be generate:<N> for an N x N test matrix that every process computes" << endl
+                    << "\tfrom its entries, so the matrix is neither read nor sent." << endl;
         }
         MPI_Finalize();
         return 0;
     }
 
-    // I store the vector b in form of a matrix with only one column.
-    Matrix A, b;
+    // Read verbose flag
+    int i_arg = 5;
+    if (argc > 5 && argv[5][0] != '-') {
+        if (world_rank == 0) verbose = atoi(argv[5]);
+        i_arg++;
+    }
+
+    // Read options. The default is the row decomposition.
+    bool pipelined = false, krylov = false, chebyshev = false, verify = false;
+    int nprows = 0, npcols = 1;
+    Krylov::Method method = Krylov::GMRES;
+    size_t restart = KRYLOV_RESTART, block_size = 0;
+    string preconditioner, output_file;
+
+    for (; i_arg < argc; i_arg++) {
+        string option(argv[i_arg]);
+
+        if (option == "--pipelined") {
+            pipelined = true;
+        } else if (option == "--chebyshev") {
+            chebyshev = true;
+        } else if (option == "--krylov" && i_arg + 1 < argc) {
+            try {
+                method = Krylov::method(argv[++i_arg]);
+                krylov = true;
+            } catch (const exception & e) {
+                if (world_rank == 0) cout << e.what() << endl;
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (option == "--restart" && i_arg + 1 < argc) {
+            restart = atoi(argv[++i_arg]);
+        } else if (option == "--preconditioner" && i_arg + 1 < argc) {
+            preconditioner = argv[++i_arg];
+        } else if (option == "--output" && i_arg + 1 < argc) {
+            output_file = argv[++i_arg];
+        } else if (option == "--verify") {
+            verify = true;
+        } else if (option == "--block-size" && i_arg + 1 < argc) {
+            block_size = atoi(argv[++i_arg]);
+        } else if (option == "--grid" && i_arg + 1 < argc) {
+            string grid(argv[++i_arg]);
+            if (grid == "auto") {
+                nprows = npcols = 0;
+            } else if (sscanf(grid.c_str(), "%dx%d", &nprows, &npcols) != 2) {
+                if (world_rank == 0) cout << "Error: Unknown process grid " << grid << endl;
+                MPI_Finalize();
+                return 1;
+            }
+        } else {
+            if (world_rank == 0) cout << "Error: Unknown option " << option << endl;
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    // generate:<N> is a matrix that is computed instead of read
+    string matrix_file(argv[1]);
+    size_t n_generated = 0;
+    if (matrix_file.compare(0, 9, "generate:") == 0) {
+        n_generated = atol(matrix_file.c_str() + 9);
+        if (n_generated == 0) {
+            if (world_rank == 0) cout << "Error: The size of " << matrix_file << " should be positive." << endl;
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    if (verify && n_generated == 0) {
+        if (world_rank == 0) cout << "Error: --verify needs a generated matrix." << endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    Matrix A;
+    Vector b;
     size_t max_it = 1000, initialize_func = 0;
     
     max_it = atoi(argv[3]);
@@ -300,19 +334,54 @@ int main(int argc, char** argv) {
     if (world_rank == 0) {
         // Tasks for rank 0
 
-        // Read verbose flag
-        if (argc == 6) {
-            verbose = atoi(argv[argc - 1]);
-        }
-
         // Read input files
-        A.readMatrix(argv[1]);
-        b.readMatrix(argv[2]);
+        if (n_generated == 0) A.readMatrix(argv[1]);
+        b.readVector(argv[2]);
         
         // Read other command line arguments
         initialize_func = atoi(argv[4]);
     }
 
+    // The blocks of a generated matrix are computed on every rank, which
+    // needs the rows of b there
+    //
+    unsigned long long b_length = b.size();
+    MPI_Bcast(&b_length, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    if (n_generated > 0 && b_length != n_generated) {
+        if (world_rank == 0) cout << "Error: The vector does not have " << n_generated << " values." << endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    unique_ptr<ProcessGrid> grid;
+    FunctionOperator::EntryFunction entry;
+    Vector b_rows;
+
+    if (n_generated > 0) {
+        grid.reset(new ProcessGrid(n_generated, nprows, npcols));
+        entry = generatedMatrix(n_generated, grid->rows().begin(), grid->rows().end());
+
+        Vector b_all(b);
+        b_all.resize(n_generated);
+        MPI_Bcast(b_all.data(), n_generated, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        b_rows.resize(grid->rows().size());
+        copy(b_all.data() + grid->rows().begin(), b_all.data() + grid->rows().end(), b_rows.data());
+    }
+
+    // Only rank 0 needs the first row, for the guess
+    function<double(size_t)> first_row = [&A](size_t j) {
+        return (A[0][j]);
+    };
+    FunctionOperator::EntryFunction first_entries;
+    if (n_generated > 0 && world_rank == 0) {
+        first_entries = generatedMatrix(n_generated, 0, 1);
+        first_row = [&first_entries](size_t j) {
+            return (first_entries(0, j));
+        };
+    }
+
 #ifdef _PROFILE_TIME
     clock_t time_start = clock();
 #endif
@@ -322,10 +391,22 @@ int main(int argc, char** argv) {
 #endif
 
     // Define solution
-    Matrix solution;
+    Vector solution;
 
     // Read function name
-    runJacobi(A, b, solution, max_it, initialize_func, verbose);
+    if (krylov) {
+        unique_ptr<DistributedMatrix> A_dist(n_generated > 0 ?
+                new DistributedMatrix(*grid, entry) :
+                new DistributedMatrix(A, MPI_COMM_WORLD, 0, nprows, npcols));
+        runKrylov(*A_dist, A, b, solution, max_it, initialize_func, verbose,
+                method, restart, preconditioner, block_size, first_row);
+    } else {
+        unique_ptr<DistributedJacobi> jacobi(n_generated > 0 ?
+                new DistributedJacobi(*grid, entry, b_rows) :
+                new DistributedJacobi(A, b, MPI_COMM_WORLD, 0, nprows, npcols));
+        runJacobi(*jacobi, A, b, solution, max_it, initialize_func, verbose,
+                pipelined, chebyshev, first_row);
+    }
 
 #ifdef _WALL_TIME
     double wtime_end = MPI_Wtime();
@@ -349,11 +430,59 @@ int main(int argc, char** argv) {
     }
 #endif
 
+    // The solution is gathered on all ranks, and rank 0 writes it
+    if (!output_file.empty() && world_rank == 0) {
+        solution.toMatrix().writeMatrix(output_file);
+    }
+
     if (verbose >= 1 & world_rank == 0) {
-        cout << "Result from Jacobi x is " << endl << solution << endl;
+        cout << "Result from " << (krylov ? Krylov::name(method) : "Jacobi")
+                << " x is " << endl << solution << endl;
+    }
+
+    // The generated matrix is assembled on rank 0 and solved again through
+    // the distribution of a dense matrix. Both take the same iterations on
+    // the same blocks, so the solutions have to be the same.
+    //
+    int status = 0;
+    if (verify) {
+        FunctionOperator::EntryFunction all_entries;
+        if (world_rank == 0) {
+            all_entries = generatedMatrix(n_generated, 0, n_generated);
+            A.resize(n_generated, n_generated);
+            for (size_t i = 0; i < n_generated; i++) {
+                for (size_t j = 0; j < n_generated; j++) A[i][j] = all_entries(i, j);
+            }
+        }
+
+        Vector solution_dense;
+        if (krylov) {
+            DistributedMatrix A_dist(A, MPI_COMM_WORLD, 0, nprows, npcols);
+            runKrylov(A_dist, Matrix(), b, solution_dense, max_it, initialize_func, 0,
+                    method, restart, preconditioner, block_size, first_row);
+        } else {
+            DistributedJacobi jacobi(A, b, MPI_COMM_WORLD, 0, nprows, npcols);
+            runJacobi(jacobi, Matrix(), b, solution_dense, max_it, initialize_func, 0,
+                    pipelined, chebyshev, first_row);
+        }
+
+        if (world_rank == 0) {
+            double difference = 0.0;
+            for (size_t i = 0; i < n_generated; i++) {
+                difference = max(difference, abs(solution[i] - solution_dense[i]));
+            }
+
+            cout << "Difference from the assembled matrix: " << difference << endl;
+            if (difference > 1.0e-12) {
+                cout << "Error: The generated matrix does not give the solution of the assembled matrix." << endl;
+                status = 1;
+            }
+        }
+
+        MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
     }
 
     MPI_Finalize();
-    return 0;
+    return (status);
 }
 
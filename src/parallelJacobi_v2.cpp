@@ -5,11 +5,18 @@
  *
  * Created on November 26, 2018, 5:38 PM
  */
+#include "Matrix.h"
+#include "Vector.h"
+#include "DistributedJacobi.h"
+#include "DistributedKrylov.h"
+
 #include <string>
+#include <cstdio>
 #include <ctime>
 #include <numeric>
 #include <algorithm>
 #include <iterator>
+#include <memory>
 
 #include <mpi.h>
 #include <stdio.h>
@@ -27,39 +34,107 @@ using namespace std;
 int main(int argc, char **argv) {
     
     double wtime_start, wtime_end_of_preprocess, wtime_end_of_computation;
+    double wtime_start_of_setup = 0, wtime_end_of_setup = 0;
 
     // Initialize the MPI world
     int world_size = -1, world_rank = -1;
-    MPI_Init(&argc, &argv);
+    // The threads of a process only compute, and all MPI calls are made by
+    // the main thread outside of the parallel regions
+    //
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
+    if (provided < MPI_THREAD_FUNNELED && world_rank == 0) {
+        cout << "Warning: The MPI library does not support threads. Please set OMP_NUM_THREADS=1." << endl;
+    }
+
 #ifdef _PROFILE_TIME
     if (world_rank == 0)
         wtime_start = MPI_Wtime();
 #endif
 
     // Parse arguments
-    string nc_file;
-    double resid = 999;
+    string nc_file, output_file;
     size_t start[NDIMS], count[NDIMS];
     int initialize_method = 1, max_it = 10,
             master_rank = 0, opt = -1, verbose = 0;
+    bool pipelined = false, use_krylov = false, chebyshev = false;
+    Krylov::Method method = Krylov::GMRES;
+    size_t restart = KRYLOV_RESTART, block_size = 0;
+    string preconditioner;
+
+    // The tolerance of the relative error to the answer in the file. A
+    // negative value means no check.
+    //
+    double check_tolerance = -1.0;
+
+    // The default is the row decomposition
+    int nprows = 0, npcols = 1;
     
     if (argc >= 4) {
         nc_file = argv[1];
         max_it = atoi(argv[2]);
         initialize_method = atoi(argv[3]);
         
-        if (argc == 5) {
+        int i_arg = 4;
+        if (argc > 4 && argv[4][0] != '-') {
            verbose = atoi(argv[4]); 
+           i_arg++;
+        }
+
+        for (; i_arg < argc; i_arg++) {
+            string option(argv[i_arg]);
+
+            if (option == "--pipelined") {
+                pipelined = true;
+            } else if (option == "--chebyshev") {
+                chebyshev = true;
+            } else if (option == "--krylov" && i_arg + 1 < argc) {
+                try {
+                    method = Krylov::method(argv[++i_arg]);
+                    use_krylov = true;
+                } catch (const exception & e) {
+                    if (world_rank == 0) cout << e.what() << endl;
+                    MPI_Finalize();
+                    return 1;
+                }
+            } else if (option == "--restart" && i_arg + 1 < argc) {
+                restart = atoi(argv[++i_arg]);
+            } else if (option == "--preconditioner" && i_arg + 1 < argc) {
+                preconditioner = argv[++i_arg];
+            } else if (option == "--block-size" && i_arg + 1 < argc) {
+                block_size = atoi(argv[++i_arg]);
+            } else if (option == "--output" && i_arg + 1 < argc) {
+                output_file = argv[++i_arg];
+            } else if (option == "--check" && i_arg + 1 < argc) {
+                check_tolerance = atof(argv[++i_arg]);
+            } else if (option == "--grid" && i_arg + 1 < argc) {
+                string grid(argv[++i_arg]);
+                if (grid == "auto") {
+                    nprows = npcols = 0;
+                } else if (sscanf(grid.c_str(), "%dx%d", &nprows, &npcols) != 2) {
+                    if (world_rank == 0) cout << "Error: Unknown process grid " << grid << endl;
+                    MPI_Finalize();
+                    return 1;
+                }
+            } else {
+                if (world_rank == 0) cout << "Error: Unknown option " << option << endl;
+                MPI_Finalize();
+                return 1;
+            }
         }
         
     } else {
         if (world_rank == 0) {
             cout << "parallelJacobi_v2 <netcdf file> <max iteration> "
-                    << "<initialization> [verbose level]" << endl;
+                    << "<initialization> [verbose level] [--pipelined] [--chebyshev] [--grid <P>x<Q>|auto] [--check <tolerance>]"
+                    << " [--output <netcdf file>[:variable]]"
+                    << " [--krylov <CG|BiCGSTAB|GMRES>] [--restart <number>]"
+                    << " [--preconditioner <jacobi|ilu0|block>] [--block-size <number>]" << endl;
         }
+        MPI_Finalize();
         return 0;
     }
 
@@ -72,52 +147,51 @@ int main(int argc, char **argv) {
     res = nc_inq_dimid(ncid, "size", &dimid); ERR;
     res = nc_inq_dimlen(ncid, dimid, &size); ERR;
 
-    // Define the rows to read for this process
-    // Note that the first dimension is column and the second dimension is row.
+    // Define the block to read for this process. Only the columns of the
+    // process column are read, which are all columns with one process
+    // column. Note that the first dimension is column and the second
+    // dimension is row.
     //
-    start[1] = world_rank * size / world_size;
-    count[1] = world_rank == world_size - 1 ? size - (world_rank * size / world_size) : size / world_size;
-
-    // Master process should know about how each process is reading data
-    int *recvcounts = nullptr, *displs = nullptr;
-    if (world_rank == master_rank) {
-        recvcounts = new int[world_size]();
-        displs = new int[world_size]();
-
-        for (size_t i = 0; i < world_size; i++) {
-
-            recvcounts[i] = i == world_size - 1 ? size - (i * size / world_size) : size / world_size;
-            displs[i] = i * size / world_size;
-        }
-    }
-
-    // Always read the full columns
-    start[0] = 0;
-    count[0] = size;
+    ProcessGrid grid(size, nprows, npcols, MPI_COMM_WORLD);
+    start[1] = grid.rows().begin();
+    count[1] = grid.rows().size();
+    start[0] = grid.cols().begin();
+    count[0] = grid.cols().size();
 
     // Read the sampled data
     ptrdiff_t stride[2] = {1, 1};
-    double *pA = new double[count[0] * count[1]]();
-    double *pb = new double[count[1]]();
-    double *px_correct;
+    Matrix A_slab(count[0], count[1]);
+    Vector b_local(count[1]), x_correct, A_first_row;
 
     res = nc_inq_varid(ncid, "A", &varid); ERR;
-    res = nc_get_vars_double(ncid, varid, start, count, stride, pA); ERR;
+    res = nc_get_vars_double(ncid, varid, start, count, stride, A_slab.data()); ERR;
 
     res = nc_inq_varid(ncid, "b", &varid); ERR;
-    res = nc_get_vars_double(ncid, varid, start + 1, count + 1, stride + 1, pb); ERR;
-
+    res = nc_get_vars_double(ncid, varid, start + 1, count + 1, stride + 1, b_local.data()); ERR;
 
     if (world_rank == master_rank) {
-        px_correct = new double[size]();
+        x_correct.resize(size);
         res = nc_inq_varid(ncid, "x", &varid); ERR;
-        res = nc_get_var_double(ncid, varid, px_correct); ERR;
+        res = nc_get_var_double(ncid, varid, x_correct.data()); ERR;
+
+        // The first row is needed for the initial guess
+        size_t row_start[NDIMS] = {0, 0}, row_count[NDIMS] = {size, 1};
+        A_first_row.resize(size);
+        res = nc_inq_varid(ncid, "A", &varid); ERR;
+        res = nc_get_vars_double(ncid, varid, row_start, row_count, stride, A_first_row.data()); ERR;
     }
 
     res = nc_close(ncid); ERR;
 
+    // The slab is stored column by column, so each row of A_slab is a
+    // column of the block. It is transposed once so that the local
+    // products run along contiguous rows.
+    //
+    Matrix A_local = A_slab.transpose();
+    A_slab.resize(0, 0);
+
     // Initialize the solution x
-    double *px = new double[size]();
+    Vector x(size);
 
     if (world_rank == master_rank) {
         // Only the first process initialize the solution.
@@ -125,16 +199,16 @@ int main(int argc, char **argv) {
         //
         if (initialize_method == 1) {
             for (size_t i = 0; i < size; i++) {
-                px[i] = 1;
+                x[i] = 1;
             }
         } else if (initialize_method == 2) {
             std::srand(std::time(nullptr));
             for (size_t i = 0; i < size; i++) {
-                px[i] = rand();
+                x[i] = rand();
             }
         } else if (initialize_method == 3) {
             for (size_t i = 0; i < size; i++) {
-                px[i] = pb[0] / pA[i * count[1]] / size;
+                x[i] = b_local[0] / A_first_row[i] / size;
             }
         } else {
             MPI_Finalize();
@@ -142,16 +216,48 @@ int main(int argc, char **argv) {
         }
     }
 
-    // Calculate the inverse of the diagonal matrix of A
-    double *D_inv = new double[count[1]]();
-    size_t index = 0;
-    for (size_t i = 0; i < count[1]; i++) {
-        index = (i + start[1]) * count[1] + i;
-        if (pA[index] >= SMALLVAL) {
-            D_inv[i] = 1 / pA[index];
-        } else {
-            throw runtime_error("Error: The inverse diagonal matrix of A cannot be found.");
+    unique_ptr<DistributedJacobi> jacobi;
+    unique_ptr<DistributedMatrix> A_dist;
+    unique_ptr<DistributedKrylov> krylov;
+    unique_ptr<Preconditioner> M;
+    Vector b_own, x_own;
+
+    if (use_krylov) {
+        // The Krylov methods work on the parts of b and x owned by this
+        // process. The residual b - A * x is checked for convergence.
+        //
+        A_dist.reset(new DistributedMatrix(grid, A_local));
+        krylov.reset(new DistributedKrylov(*A_dist, method, restart));
+
+#ifdef _PROFILE_TIME
+        if (world_rank == 0)
+            wtime_start_of_setup = MPI_Wtime();
+#endif
+
+        // The preconditioner only uses the rows and columns owned by this
+        // process. By default, block-Jacobi factorizes them as one block.
+        //
+        if (!preconditioner.empty()) {
+            M = makeDistributedPreconditioner(preconditioner, *A_dist, block_size);
+            krylov->setPreconditioner(M.get());
         }
+
+#ifdef _PROFILE_TIME
+        if (world_rank == 0)
+            wtime_end_of_setup = MPI_Wtime();
+#endif
+
+        size_t offset = grid.ownBegin() - grid.rows().begin();
+        b_own.resize(grid.ownSize());
+        copy(b_local.data() + offset, b_local.data() + offset + b_own.size(), b_own.data());
+    } else {
+        // Calculate the inverse of the diagonal matrix of A. The error term
+        // D^-1 * (b - A * x_k) is checked for convergence.
+        //
+        jacobi.reset(new DistributedJacobi(grid, A_local, b_local));
+        jacobi->setMetric(DistributedJacobi::CORRECTION);
+        jacobi->setPipelined(pipelined);
+        jacobi->setChebyshev(chebyshev);
     }
 
 #ifdef _PROFILE_TIME
@@ -166,58 +272,58 @@ int main(int argc, char **argv) {
     // Δx = D^-1 * (b - A * x_k), where the error term Δx = x_k+1 - x_k
     //
     // By doing this transformation, we separate the error term which 
-    // makes the parallelization easier.
+    // makes the parallelization easier. Please see DistributedJacobi.h.
     //
-    double *ptmp = new double[count[1]]();
-    double *pdeltax = nullptr;
-    if (world_rank == master_rank)
-        pdeltax = new double[size]();
-
-    for (size_t i_it = 0; i_it < max_it && resid > SMALLVAL; i_it++) {
-
-        MPI_Bcast(px, size, MPI_DOUBLE, master_rank, MPI_COMM_WORLD);
+    // The Krylov methods are used instead when they are chosen. Please see
+    // DistributedKrylov.h.
+    //
+    if (use_krylov) {
+        A_dist->scatter(x, x_own, master_rank);
+        krylov->solve(b_own, x_own, max_it, SMALLVAL, verbose);
+        A_dist->allgather(x_own, x);
+    } else {
+        jacobi->solve(x, max_it, SMALLVAL, verbose);
+    }
 
-        // Each process carries out their own computation
-        for (size_t i = 0; i < count[1]; i++) {
-            for (size_t j = 0; j < count[0]; j++) {
-                ptmp[i] += pA[j * count[1] + i] * px[j];
-            }
+    int status = 0;
 
-            ptmp[i] = D_inv[i] * (pb[i] - ptmp[i]);
+    if (world_rank == master_rank && (verbose || check_tolerance >= 0)) {
+        double dif = 0, norm = 0;
+        for (size_t i = 0; i < size; i++) {
+            dif += abs(x_correct[i] - x[i]);
+            norm += abs(x_correct[i]);
         }
 
-        MPI_Gatherv(ptmp, count[1], MPI_DOUBLE, pdeltax, recvcounts, displs,
-                MPI_DOUBLE, master_rank, MPI_COMM_WORLD);
-
-        if (world_rank == master_rank) {
-            // Print the sum of residuals
-            resid = accumulate(pdeltax, pdeltax + size, 0.0, [](
-                    const double lhs, const double rhs) {
-                return (lhs + abs(rhs));
-            });
-            
-            if (verbose >= 2)
-                cout << "Iteration # " << i_it + 1 << " residual: " << resid << endl;
-
-            // Calculate the new solution
-            transform(px, px + size, pdeltax, px, plus<double>());
+        if (verbose) {
+            cout << "The absolute error sum to the answer is " << dif << "." << endl;
         }
 
-        MPI_Bcast(&resid, 1, MPI_DOUBLE, master_rank, MPI_COMM_WORLD);
-        
-    }
-
-    if (world_rank == master_rank && verbose) {
-        cout << "The absolute error sum to the answer is ";
-        double dif = 0;
-        for (size_t i = 0; i < size; i++) {
-            dif += abs(px_correct[i] - px[i]);
+        if (check_tolerance >= 0 && dif > check_tolerance * norm) {
+            cout << "Error: The relative error " << dif / norm
+                    << " is larger than " << check_tolerance << "." << endl;
+            status = 1;
         }
-        cout << dif << "." << endl;
     }
 
-    delete [] pA, pb, px, ptmp, D_inv;
-    if (world_rank == master_rank) delete [] pdeltax, px_correct, recvcounts, displs;
+    // Every rank writes the part of the solution that it owns with one
+    // collective call. The variable is x by default.
+    //
+    if (!output_file.empty()) {
+        string out_file(output_file), out_var("x");
+        netcdfVariable(output_file, out_file, out_var);
+
+        int out_ncid = -1, out_dimid = -1, out_varid = -1;
+        res = nc_create_par(out_file.c_str(), NC_NETCDF4|NC_MPIIO|NC_CLOBBER,
+                MPI_COMM_WORLD, MPI_INFO_NULL, &out_ncid); ERR;
+        res = nc_def_dim(out_ncid, "size", size, &out_dimid); ERR;
+        res = nc_def_var(out_ncid, out_var.c_str(), NC_DOUBLE, 1, &out_dimid, &out_varid); ERR;
+        res = nc_enddef(out_ncid); ERR;
+        res = nc_var_par_access(out_ncid, out_varid, NC_COLLECTIVE); ERR;
+
+        size_t out_start = grid.ownBegin(), out_count = grid.ownSize();
+        res = nc_put_vara_double(out_ncid, out_varid, &out_start, &out_count, x.data() + out_start); ERR;
+        res = nc_close(out_ncid); ERR;
+    }
 
 #ifdef _PROFILE_TIME
     if (world_rank == 0) {
@@ -232,11 +338,20 @@ int main(int argc, char **argv) {
             << "Computation: " << wduration_comp << "s ("
             << 100 * wduration_comp / wduration_total << "%)" << endl
             << "Total time: " << wduration_total << "s (100%)" << endl;
+
+        if (M) {
+            double wduration_setup = wtime_end_of_setup - wtime_start_of_setup;
+            cout << "Preconditioner setup: " << wduration_setup << "s ("
+                << 100 * wduration_setup / wduration_total << "%)" << endl
+                << "Preconditioner apply: " << M->applyTime() << "s ("
+                << 100 * M->applyTime() / wduration_total << "%) in "
+                << M->applications() << " applications" << endl;
+        }
     }
 #endif
 
     // Housekeeping
     MPI_Finalize();
 
-    return 0;
+    return (status);
 }
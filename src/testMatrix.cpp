@@ -7,8 +7,34 @@
  */
 
 #include "Matrix.h"
+#include "Vector.h"
+#include "GaussSeidel.h"
+#include "Jacobi.h"
+#include "Factorization.h"
+#include "SparseMatrix.h"
+#include "Krylov.h"
+#include "Preconditioner.h"
+#include "ExecutionContext.h"
+#include "SolutionCache.h"
+#include "MixedPrecision.h"
+#include "Convergence.h"
+#include "StreamedMatrix.h"
+#include "FunctionOperator.h"
+#include "CsvParser.h"
 
 #include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <utility>
+
+#include <unistd.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -56,5 +82,1431 @@ int main() {
     
     deleteContinuousMatrix(cm);
     
+    cout << "---------------------" << endl
+            << "Test continuous storage and views" << endl
+            << "---------------------" << endl;
+
+    Matrix mat_rect(3, 4);
+    for (size_t i = 0; i < mat_rect.nrows(); i++) {
+        for (size_t j = 0; j < mat_rect.ncols(); j++) {
+            mat_rect[i][j] = i * 10 + j;
+        }
+    }
+
+    if (reinterpret_cast<size_t> (mat_rect.data()) % MATRIX_ALIGNMENT != 0 ||
+            mat_rect.data()[1 * mat_rect.stride() + 2] != 12 ||
+            mat_rect.row(2)[3] != 23 || mat_rect.col(1)[2] != 21) {
+        cout << "Error: Continuous storage or views are not correct." << endl;
+        return 1;
+    }
+
+    mat_rect.resize(4, 2);
+    if (mat_rect[2][1] != 21 || mat_rect[3][1] != 0) {
+        cout << "Error: Resize does not keep the overlapping values." << endl;
+        return 1;
+    }
+
+    cout << "Resized matrix: " << endl << mat_rect << endl;
+
+    cout << "---------------------" << endl
+            << "Test binary matrix files" << endl
+            << "---------------------" << endl;
+
+    const char *bin_file = "testMatrix.bin";
+    mat_rect.writeBinary(bin_file);
+
+    Matrix mat_bin;
+    mat_bin.readMatrix(bin_file);
+    mat_bin.readBinary(bin_file, true);
+    remove(bin_file);
+
+    if (!mat_bin.isMapped() || mat_bin.nrows() != 4 || mat_bin.ncols() != 2 ||
+            mat_bin[2][1] != 21 || reinterpret_cast<size_t> (mat_bin.data()) % MATRIX_ALIGNMENT != 0) {
+        cout << "Error: Binary matrix file is not read correctly." << endl;
+        return 1;
+    }
+
+    // Changes to a mapped matrix are private
+    mat_bin[0][0] = -1;
+    mat_bin.resize(5, 2);
+    if (mat_bin.isMapped() || mat_bin[0][0] != -1 || mat_bin[2][1] != 21 || mat_bin[4][1] != 0) {
+        cout << "Error: Mapped matrix can't be modified." << endl;
+        return 1;
+    }
+
+    // A file whose checksum does not match leaves the matrix unchanged
+    mat_rect.writeBinary(bin_file);
+    FILE *corrupt = fopen(bin_file, "r+b");
+    fseek(corrupt, -1, SEEK_END);
+    fputc(0x7f, corrupt);
+    fclose(corrupt);
+
+    bool corrupt_thrown = false;
+    try {
+        mat_bin.readBinary(bin_file, true);
+    } catch (const exception &) {
+        corrupt_thrown = true;
+    }
+    remove(bin_file);
+
+    if (!corrupt_thrown || mat_bin.isMapped() || mat_bin.nrows() != 5 || mat_bin[0][0] != -1) {
+        cout << "Error: A corrupt binary matrix file changes the matrix." << endl;
+        return 1;
+    }
+
+    // Headers with a misaligned data offset, with nrows * ncols that
+    // overflows, and of a truncated file are rejected before the values
+    // are read. The header has nrows at byte 24 and data_offset at 40.
+    //
+    uint64_t bad_fields[][2] = {{40, 65}, {24, (uint64_t) 1 << 62}, {24, 5}};
+    for (size_t k = 0; k < 3; k++) {
+        mat_rect.writeBinary(bin_file);
+        corrupt = fopen(bin_file, "r+b");
+        fseek(corrupt, bad_fields[k][0], SEEK_SET);
+        fwrite(&bad_fields[k][1], sizeof (uint64_t), 1, corrupt);
+        fclose(corrupt);
+
+        bool header_thrown = false, layout_thrown = false;
+        try {
+            mat_bin.readBinary(bin_file);
+        } catch (const exception &) {
+            header_thrown = true;
+        }
+
+        size_t layout_rows, layout_cols, layout_offset;
+        try {
+            binaryLayout(bin_file, layout_rows, layout_cols, layout_offset);
+        } catch (const exception &) {
+            layout_thrown = true;
+        }
+        remove(bin_file);
+
+        if (!header_thrown || !layout_thrown || mat_bin.isMapped() || mat_bin.nrows() != 5) {
+            cout << "Error: A corrupt header of a binary matrix file is not rejected." << endl;
+            return 1;
+        }
+    }
+
+    cout << "Matrix read from the binary file: " << endl << mat_bin << endl;
+
+    cout << "---------------------" << endl
+            << "Test csv files" << endl
+            << "---------------------" << endl;
+
+    // The fast path of parseDouble gives the same values as strtod, also
+    // for the cases that fall back to it
+    //
+    vector<string> numbers = {"0", "-0.0", "+7", ".5", "5.", "0.1", "-2.5E-3", "1e22", "1e23",
+        "9007199254740992", "9007199254740993", "123456789012345678901234", "3.14159265358979323846",
+        "0.000000000000000000000001", "4.9e-324", "1.7976931348623157e308", "1e400", "inf", "-nan"};
+    char number_buffer[32];
+    for (int k = 0; k < 1000; k++) {
+        double random_value = (rand() - RAND_MAX / 2) * pow(10.0, rand() % 40 - 20) / RAND_MAX;
+        snprintf(number_buffer, sizeof (number_buffer), (k % 2 ? "%.17g" : "%.6f"), random_value);
+        numbers.push_back(number_buffer);
+    }
+
+    size_t parse_mismatches = 0;
+    for (const string & number : numbers) {
+        double parsed = 0.0, expected = strtod(number.c_str(), nullptr);
+        const char *parse_end = parseDouble(number.data(), number.data() + number.size(), parsed);
+        bool same = (std::isnan(expected) ? std::isnan(parsed) :
+                memcmp(&parsed, &expected, sizeof (double)) == 0);
+        if (parse_end != number.data() + number.size() || !same) parse_mismatches++;
+    }
+
+    // CRLF line endings, blank lines, and no final newline
+    const char *csv_text = "testMatrix_text.csv";
+    {
+        ofstream csv(csv_text, ios::binary);
+        csv << "1.5, -2\r\n\r\n3e-1,4\r\n  \t\n5, 0.125";
+    }
+
+    Matrix mat_text;
+    SparseMatrix sp_text;
+    mat_text.readMatrix(csv_text);
+    sp_text.readMatrix(csv_text);
+
+    bool text_read = (mat_text.nrows() == 3 && mat_text.ncols() == 2 && mat_text[0][0] == 1.5 &&
+            mat_text[0][1] == -2 && mat_text[1][0] == 0.3 && mat_text[2][1] == 0.125 &&
+            sp_text.nrows() == 3 && sp_text.value(2, 1) == 0.125 && sp_text.value(1, 0) == 0.3);
+
+    // A ragged row and an invalid value are errors of both readers
+    const char *bad_texts[] = {"1, 2\n3\n4, 5\n", "1, 2\n3, x\n"};
+    size_t bad_rejected = 0;
+    for (const char *bad_text : bad_texts) {
+        {
+            ofstream csv(csv_text, ios::binary);
+            csv << bad_text;
+        }
+
+        try {
+            Matrix mat_bad;
+            mat_bad.readMatrix(csv_text);
+        } catch (const exception &) {
+            bad_rejected++;
+        }
+
+        try {
+            SparseMatrix sp_bad;
+            sp_bad.readMatrix(csv_text);
+        } catch (const exception &) {
+            bad_rejected++;
+        }
+    }
+
+    // A file that is split into chunks for 4 threads, whose ragged row
+    // is reported with its row in the whole file
+    //
+    size_t n_big = 3000, ncols_big = 8;
+    Matrix mat_big_expected(n_big, ncols_big);
+    {
+        ofstream csv(csv_text);
+        for (size_t i = 0; i < n_big; i++) {
+            for (size_t j = 0; j < ncols_big; j++) {
+                mat_big_expected[i][j] = (rand() - RAND_MAX / 2) / 1000.0 + 1.0 / (j + 1);
+                snprintf(number_buffer, sizeof (number_buffer), "%.17g", mat_big_expected[i][j]);
+                csv << (j ? "," : "") << number_buffer;
+            }
+            csv << (i % 2 ? "\r\n" : "\n");
+        }
+    }
+
+    struct stat csv_stat;
+    stat(csv_text, &csv_stat);
+
+    ExecutionContext::setCurrent(ExecutionContext(4));
+    Matrix mat_big;
+    SparseMatrix sp_big;
+    mat_big.readMatrix(csv_text);
+    sp_big.readMatrix(csv_text);
+
+    double max_big = (mat_big.nrows() == n_big && sp_big.nrows() == n_big ? 0.0 : 1.0);
+    for (size_t i = 0; i < n_big && max_big == 0.0; i++) {
+        for (size_t j = 0; j < ncols_big; j++) {
+            max_big = max(max_big, abs(mat_big[i][j] - mat_big_expected[i][j]));
+            max_big = max(max_big, abs(sp_big.value(i, j) - mat_big_expected[i][j]));
+        }
+    }
+
+    {
+        ofstream csv(csv_text, ios::app);
+        for (size_t i = 0; i < n_big; i++) csv << (i == n_big / 2 ? "1,2" : "1,2,3,4,5,6,7,8") << "\n";
+    }
+
+    string big_message, big_sparse_message;
+    try {
+        mat_big.readMatrix(csv_text);
+    } catch (const exception & e) {
+        big_message = e.what();
+    }
+    try {
+        sp_big.readMatrix(csv_text);
+    } catch (const exception & e) {
+        big_sparse_message = e.what();
+    }
+    ExecutionContext::setCurrent(ExecutionContext());
+    remove(csv_text);
+
+    ostringstream big_expected;
+    big_expected << "Error: Row " << n_big + n_big / 2 << " of the csv file has 2 values but 8 are expected.";
+
+    cout << "Parsed numbers: " << numbers.size() << " mismatches: " << parse_mismatches << endl
+            << "Chunked file of " << csv_stat.st_size << " bytes, maximum difference: " << max_big << endl;
+    if (parse_mismatches != 0 || !text_read || bad_rejected != 4 || max_big != 0.0 ||
+            big_message != big_expected.str() || big_sparse_message != big_expected.str()) {
+        cout << "Error: The csv files are not read correctly." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test NetCDF variables" << endl
+            << "---------------------" << endl;
+
+    string nc_path, nc_var;
+    if (!netcdfVariable("data/100.nc:A", nc_path, nc_var) || nc_path != "data/100.nc" ||
+            nc_var != "A" || netcdfVariable("A_100.csv", nc_path, nc_var) ||
+            netcdfVariable("100.nc:", nc_path, nc_var)) {
+        cout << "Error: Paths of NetCDF variables are not split correctly." << endl;
+        return 1;
+    }
+
+#ifdef _USE_NETCDF
+    // A compressed matrix and a vector, which is a 1-dimensional variable
+    const char *nc_file = "testMatrix.nc";
+    Matrix mat_nc, vec_nc;
+    mat_rect.writeNetCDF(nc_file, "A", 4);
+    mat_nc.readMatrix(string(nc_file) + ":A");
+
+    Matrix col_rect(4, 1);
+    for (size_t i = 0; i < 4; i++) col_rect[i][0] = mat_rect[i][1];
+    col_rect.writeMatrix(string(nc_file) + ":x");
+    vec_nc = readRightHandSides(string(nc_file) + ":x");
+    remove(nc_file);
+
+    for (size_t i = 0; i < 4; i++) {
+        if (mat_nc.nrows() != 4 || mat_nc.ncols() != 2 || mat_nc[i][0] != mat_rect[i][0] ||
+                mat_nc[i][1] != mat_rect[i][1] || vec_nc.ncols() != 1 || vec_nc[i][0] != mat_rect[i][1]) {
+            cout << "Error: NetCDF variables are not read or written correctly." << endl;
+            return 1;
+        }
+    }
+
+    cout << "Matrix read from the NetCDF file: " << endl << mat_nc << endl;
+#endif
+
+    cout << "---------------------" << endl
+            << "Test matrix multiplication (" << gemmKernelName() << ")" << endl
+            << "---------------------" << endl;
+
+    // The sizes are not multiples of the tiles to test the edge cases
+    Matrix lhs(131, 293), rhs(293, 77), vec(293, 1);
+    for (size_t i = 0; i < lhs.nrows(); i++) {
+        for (size_t j = 0; j < lhs.ncols(); j++) {
+            lhs[i][j] = (rand() % 1000) / 100.0 - 5;
+        }
+    }
+    for (size_t i = 0; i < rhs.nrows(); i++) {
+        for (size_t j = 0; j < rhs.ncols(); j++) {
+            rhs[i][j] = (rand() % 1000) / 100.0 - 5;
+        }
+        vec[i][0] = (rand() % 1000) / 100.0 - 5;
+    }
+
+    Matrix mat_mul = lhs * rhs, mat_vec = lhs * vec;
+    double max_diff = 0.0;
+
+    for (size_t i = 0; i < lhs.nrows(); i++) {
+        for (size_t j = 0; j < rhs.ncols(); j++) {
+            double sum = 0.0;
+            for (size_t k = 0; k < lhs.ncols(); k++) sum += lhs[i][k] * rhs[k][j];
+            max_diff = max(max_diff, abs(sum - mat_mul[i][j]));
+        }
+
+        double sum = 0.0;
+        for (size_t k = 0; k < lhs.ncols(); k++) sum += lhs[i][k] * vec[k][0];
+        max_diff = max(max_diff, abs(sum - mat_vec[i][0]));
+    }
+
+    cout << "Maximum difference to the reference: " << max_diff << endl;
+    if (max_diff > 1.0e-8) {
+        cout << "Error: Matrix multiplication is not correct." << endl;
+        return 1;
+    }
+
+    // The threaded kernels give the same results, and they run on the
+    // calling thread within a parallel region
+    //
+    ExecutionContext context(3, 1);
+    ExecutionContext::setCurrent(context);
+    Matrix mat_threaded = lhs * rhs, mat_diff = lhs - lhs;
+    Matrix mat_sum = mat_threaded + mat_threaded;
+    int threads_nested = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(2) default(none) shared(context, threads_nested)
+#endif
+    {
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+        threads_nested = context.threads(1 << 30);
+    }
+    ExecutionContext::setCurrent(ExecutionContext());
+
+    bool same_threaded = (threads_nested == 1 && context.threads(0) == 1);
+    for (size_t i = 0; i < mat_mul.nrows(); i++) {
+        for (size_t j = 0; j < mat_mul.ncols(); j++) {
+            if (mat_threaded[i][j] != mat_mul[i][j] ||
+                    mat_sum[i][j] != 2 * mat_mul[i][j]) same_threaded = false;
+        }
+        for (size_t j = 0; j < mat_diff.ncols(); j++) {
+            if (mat_diff[i][j] != 0.0) same_threaded = false;
+        }
+    }
+
+    cout << "Threads of the kernels: " << context.nthreads() << endl;
+    if (!same_threaded) {
+        cout << "Error: Threaded kernels are not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test vector kernels" << endl
+            << "---------------------" << endl;
+
+    Vector x(vec), y(lhs.nrows(), 2.0), r;
+
+    // y = 0.5 * lhs * x - y
+    gemv(0.5, lhs, x, -1.0, y);
+
+    max_diff = 0.0;
+    for (size_t i = 0; i < y.size(); i++) {
+        max_diff = max(max_diff, abs(0.5 * mat_vec[i][0] - 2.0 - y[i]));
+    }
+
+    // residual of lhs * x = mat_vec should be 0
+    double resid = residual(lhs, x, Vector(mat_vec), r);
+    
+    Vector u(3, 1.0), v(3);
+    v[0] = 3; v[1] = -4; v[2] = 0;
+    axpy(2.0, u, v);
+
+    cout << "Maximum difference of gemv: " << max_diff << endl
+            << "Residual: " << resid << endl
+            << "axpy result: " << v << endl;
+
+    if (max_diff > 1.0e-8 || resid > 1.0e-8 || dot(u, v) != 5 ||
+            norm1(v) != 9 || normInf(v) != 5 || abs(norm2(v) - sqrt(33.0)) > 1.0e-12) {
+        cout << "Error: Vector kernels are not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test vector expressions" << endl
+            << "---------------------" << endl;
+
+    // The expressions are evaluated lazily into the destination, which
+    // keeps its storage when it has the size
+    //
+    Vector b_expr(mat_vec), y_expr = lhs * x, r_expr = b_expr - lhs * x;
+    const double *r_storage = r_expr.data();
+    r_expr = 2.0 * (b_expr - y_expr) + b_expr - r_expr;
+
+    max_diff = 0.0;
+    for (size_t i = 0; i < b_expr.size(); i++) {
+        max_diff = max(max_diff, abs(y_expr[i] - mat_vec[i][0]));
+        max_diff = max(max_diff, abs(r_expr[i] - b_expr[i]));
+    }
+
+    // A product that reads the destination is not computed in place
+    Matrix mat_expr(3);
+    mat_expr[0][0] = 2; mat_expr[0][1] = 1; mat_expr[1][1] = 3;
+    mat_expr[2][0] = -1; mat_expr[2][2] = 1;
+
+    Vector w(u);
+    w = mat_expr * w;
+    w = w - mat_expr * w;
+
+    // Moves take over the storage
+    Vector w_moved(std::move(w));
+    Matrix mat_moved(std::move(mat_expr));
+
+    cout << "Maximum difference of the expressions: " << max_diff << endl
+            << "Result of w - A * w: " << w_moved << endl;
+
+    if (max_diff > 1.0e-8 || r_expr.data() != r_storage || w_moved[0] != -6 ||
+            w_moved[1] != -6 || w_moved[2] != 3 || w.size() != 0 ||
+            mat_expr.nrows() != 0 || mat_moved[1][1] != 3) {
+        cout << "Error: Vector expressions are not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test Gauss-Seidel sweeps" << endl
+            << "---------------------" << endl;
+
+    // A diagonally dominant system with the solution of all 1s
+    Matrix mat_gs(20);
+    Vector b_gs(20), x_gs;
+    for (size_t i = 0; i < mat_gs.nrows(); i++) {
+        for (size_t j = 0; j < mat_gs.ncols(); j++) {
+            mat_gs[i][j] = (i == j ? 40.0 : (rand() % 100) / 100.0);
+            b_gs[i] += mat_gs[i][j];
+        }
+    }
+
+    for (size_t ncolors = 1; ncolors <= 2; ncolors++) {
+        for (int symmetric = 0; symmetric <= 1; symmetric++) {
+            GaussSeidel gauss(mat_gs, 1.1, symmetric, ncolors);
+            x_gs = Vector(mat_gs.nrows(), 0.0);
+            double resid_gs = gauss.solve(b_gs, x_gs, 100, 1.0e-10);
+
+            cout << "Colors " << ncolors << " symmetric " << symmetric
+                    << " residual: " << resid_gs << endl;
+
+            if (resid_gs > 1.0e-10 || abs(x_gs[7] - 1) > 1.0e-10) {
+                cout << "Error: Gauss-Seidel does not converge." << endl;
+                return 1;
+            }
+
+            if (gauss.ncolors() != 1) {
+                cout << "Error: The dense matrix should not be colored." << endl;
+                return 1;
+            }
+        }
+    }
+
+    // The 5-point stencil on a 2-D grid gets the red-black ordering, and a
+    // sweep of the colors is the sweep of the rows of one color after the
+    // other
+    //
+    size_t nx = 7, n_grid = nx * nx;
+    vector<size_t> grid_rows, grid_cols;
+    vector<double> grid_values;
+    for (size_t i = 0; i < n_grid; i++) {
+        size_t neighbors[] = {i - nx, i - 1, i + 1, i + nx};
+        bool inside[] = {i >= nx, i % nx > 0, i % nx + 1 < nx, i + nx < n_grid};
+        grid_rows.push_back(i);
+        grid_cols.push_back(i);
+        grid_values.push_back(4.5);
+        for (size_t k = 0; k < 4; k++) {
+            if (!inside[k]) continue;
+            grid_rows.push_back(i);
+            grid_cols.push_back(neighbors[k]);
+            grid_values.push_back(-1.0);
+        }
+    }
+    SparseMatrix sp_grid(n_grid, n_grid, grid_rows, grid_cols, grid_values);
+    Matrix mat_grid = sp_grid.toMatrix();
+    Vector b_grid(n_grid, 1.0), x_colored(n_grid, 0.0), x_ordered(n_grid, 0.0);
+
+    ExecutionContext::setCurrent(ExecutionContext(4, 0));
+    GaussSeidel gauss_grid(sp_grid, 1.1, false, 2);
+    gauss_grid.sweep(b_grid, x_colored);
+    ExecutionContext::setCurrent(ExecutionContext());
+
+    for (size_t red = 0; red < 2; red++) {
+        for (size_t i = 0; i < n_grid; i++) {
+            if ((i / nx + i % nx) % 2 != red) continue;
+            double resid = b_grid[i] - mat_grid.rowProduct(i, x_ordered.data());
+            x_ordered[i] += 1.1 * resid / mat_grid[i][i];
+        }
+    }
+
+    double max_colored = 0.0;
+    for (size_t i = 0; i < n_grid; i++) max_colored = max(max_colored, abs(x_colored[i] - x_ordered[i]));
+
+    cout << "Colors of the grid: " << gauss_grid.ncolors()
+            << " maximum difference from the red-black sweep: " << max_colored << endl;
+    if (gauss_grid.ncolors() != 2 || max_colored > 1.0e-14 ||
+            GaussSeidel(sp_grid, 1.1, false, 1).ncolors() != 1) {
+        cout << "Error: The red-black ordering is not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test Jacobi iterations" << endl
+            << "---------------------" << endl;
+
+    Jacobi jacobi(mat_gs);
+    x_gs = Vector(mat_gs.nrows(), 0.0);
+    double resid_jacobi = jacobi.solve(b_gs, x_gs, 100, 1.0e-10);
+
+    cout << "Residual: " << resid_jacobi << endl;
+    if (resid_jacobi > 1.0e-10 || abs(x_gs[7] - 1) > 1.0e-10 ||
+            jacobi.inverseDiagonal()[3] != 1 / 40.0) {
+        cout << "Error: Jacobi does not converge." << endl;
+        return 1;
+    }
+
+    // Fewer residual checks, and a team of threads that own the blocks of
+    // rows, give the same iterates. The last iteration is always checked.
+    //
+    Vector x_once(mat_gs.nrows(), 0.0), x_every(mat_gs.nrows(), 0.0);
+    double resid_once = jacobi.solve(b_gs, x_once, 5, 1.0e-10);
+
+    ExecutionContext::setCurrent(ExecutionContext(4, 0));
+    jacobi.setCheckInterval(3);
+    double resid_every = jacobi.solve(b_gs, x_every, 5, 1.0e-10);
+    ExecutionContext::setCurrent(ExecutionContext());
+
+    cout << "Residual after 5 iterations with checks every 3: " << resid_every << endl;
+    for (size_t i = 0; i < x_once.size(); i++) {
+        if (x_once[i] != x_every[i] || abs(resid_once - resid_every) > 1.0e-12) {
+            cout << "Error: Jacobi with fewer checks is not correct." << endl;
+            return 1;
+        }
+    }
+
+    cout << "---------------------" << endl
+            << "Test LU and Cholesky factorizations" << endl
+            << "---------------------" << endl;
+
+    // A matrix with a zero diagonal needs row pivoting. The size is larger
+    // than the block size so that the trailing updates are covered.
+    //
+    size_t n_lu = 2 * FACTORIZATION_NB + 11;
+    Matrix mat_lu(n_lu), rhs_lu(n_lu, 3);
+    for (size_t i = 0; i < n_lu; i++) {
+        for (size_t j = 0; j < n_lu; j++) {
+            mat_lu[i][j] = (i == j ? 0.0 : (rand() % 200) / 100.0 - 1.0);
+        }
+        for (size_t j = 0; j < rhs_lu.ncols(); j++) {
+            rhs_lu[i][j] = (rand() % 200) / 100.0 - 1.0;
+        }
+    }
+
+    LUFactorization lu(mat_lu);
+    Matrix x_lu = lu.solve(rhs_lu), r_lu = mat_lu * x_lu;
+    Vector b_lu(n_lu), xv_lu;
+    for (size_t i = 0; i < n_lu; i++) b_lu[i] = rhs_lu[i][1];
+    xv_lu = lu.solve(b_lu);
+
+    double max_lu = 0.0;
+    for (size_t i = 0; i < n_lu; i++) {
+        for (size_t j = 0; j < rhs_lu.ncols(); j++) {
+            max_lu = max(max_lu, abs(r_lu[i][j] - rhs_lu[i][j]));
+        }
+        max_lu = max(max_lu, abs(xv_lu[i] - x_lu[i][1]));
+    }
+
+    // A * A^t is symmetric positive definite
+    Matrix mat_chol = mat_lu * mat_lu.transpose();
+    CholeskyFactorization chol(mat_chol);
+    Vector x_chol = chol.solve(b_lu), r_chol;
+    double resid_chol = residual(mat_chol, x_chol, b_lu, r_chol);
+
+    cout << "Maximum residual of LU: " << max_lu << endl
+            << "Residual of Cholesky: " << resid_chol << endl;
+
+    if (max_lu > 1.0e-8 || resid_chol > 1.0e-6) {
+        cout << "Error: Factorizations are not correct." << endl;
+        return 1;
+    }
+
+    bool thrown = false;
+    try {
+        CholeskyFactorization chol_bad(mat_lu);
+    } catch (const exception & e) {
+        thrown = true;
+    }
+
+    if (!thrown) {
+        cout << "Error: Cholesky should fail on an indefinite matrix." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test QR least squares" << endl
+            << "---------------------" << endl;
+
+    // An overdetermined system. The residual of the least-squares solution
+    // is orthogonal to the columns of A.
+    //
+    Matrix mat_tall(2 * FACTORIZATION_NB + 57, FACTORIZATION_NB + 13);
+    Vector b_tall(mat_tall.nrows());
+    for (size_t i = 0; i < mat_tall.nrows(); i++) {
+        for (size_t j = 0; j < mat_tall.ncols(); j++) {
+            mat_tall[i][j] = (rand() % 200) / 100.0 - 1.0;
+        }
+        b_tall[i] = (rand() % 200) / 100.0 - 1.0;
+    }
+
+    Vector x_tall = mat_tall.leastSquares(b_tall), r_tall;
+    residual(mat_tall, x_tall, b_tall, r_tall);
+    double max_orth = normInf(mat_tall.transpose() * r_tall);
+
+    // An underdetermined system. The minimum norm solution is A^t y.
+    Matrix mat_wide = mat_tall.transpose();
+    Vector b_wide(mat_wide.nrows());
+    for (size_t i = 0; i < b_wide.size(); i++) b_wide[i] = b_tall[i];
+
+    Vector x_wide = mat_wide.leastSquares(b_wide), r_wide;
+    double resid_wide = residual(mat_wide, x_wide, b_wide, r_wide);
+    Vector x_normal = mat_tall * CholeskyFactorization(
+            mat_wide * mat_tall).solve(b_wide);
+
+    // A square system with multiple right-hand sides agrees with LU
+    Matrix x_square = mat_lu.leastSquares(rhs_lu), x_square_lu = lu.solve(rhs_lu);
+    double max_qr = normInf(x_wide - x_normal);
+    for (size_t i = 0; i < n_lu; i++) {
+        for (size_t j = 0; j < rhs_lu.ncols(); j++) {
+            max_qr = max(max_qr, abs(x_square[i][j] - x_square_lu[i][j]));
+        }
+    }
+
+    cout << "Orthogonality of the residual: " << max_orth << endl
+            << "Residual of the minimum norm solution: " << resid_wide << endl
+            << "Maximum difference from other solvers: " << max_qr << endl;
+
+    if (x_tall.size() != mat_tall.ncols() || x_wide.size() != mat_wide.ncols() ||
+            max_orth > 1.0e-10 || resid_wide > 1.0e-10 || max_qr > 1.0e-8) {
+        cout << "Error: QR least squares is not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test matrix inverse" << endl
+            << "---------------------" << endl;
+
+    // The matrix with a zero diagonal can only be inverted with pivoting
+    Matrix mat_inv = mat_lu.inverse(), mat_eye = mat_lu * mat_inv;
+    double max_eye = 0.0;
+    for (size_t i = 0; i < n_lu; i++) {
+        for (size_t j = 0; j < n_lu; j++) {
+            max_eye = max(max_eye, abs(mat_eye[i][j] - (i == j ? 1.0 : 0.0)));
+        }
+    }
+
+    cout << "Maximum difference from the identity: " << max_eye << endl;
+    if (max_eye > 1.0e-8) {
+        cout << "Error: Matrix inverse is not correct." << endl;
+        return 1;
+    }
+
+    // A singular matrix throws after the parallel region has finished
+    Matrix mat_singular(mat_lu);
+    for (size_t j = 0; j < n_lu; j++) {
+        mat_singular[n_lu - 1][j] = mat_singular[0][j] + mat_singular[1][j];
+    }
+
+    thrown = false;
+    try {
+        mat_singular.inverse();
+    } catch (const exception & e) {
+        thrown = true;
+    }
+
+    if (!thrown) {
+        cout << "Error: Inverse should fail on a singular matrix." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test matrix transpose" << endl
+            << "---------------------" << endl;
+
+    // The shape is not a multiple of the tile size
+    Matrix mat_tile(70, 45), mat_tile_t;
+    for (size_t i = 0; i < mat_tile.nrows(); i++) {
+        for (size_t j = 0; j < mat_tile.ncols(); j++) {
+            mat_tile[i][j] = i * 100.0 + j;
+        }
+    }
+
+    mat_tile_t = mat_tile.transpose();
+    bool transposed = (mat_tile_t.nrows() == 45 && mat_tile_t.ncols() == 70);
+    for (size_t i = 0; transposed && i < mat_tile.nrows(); i++) {
+        for (size_t j = 0; j < mat_tile.ncols(); j++) {
+            if (mat_tile_t[j][i] != mat_tile[i][j]) transposed = false;
+        }
+    }
+
+    if (!transposed) {
+        cout << "Error: Matrix transpose is not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test sparse matrices" << endl
+            << "---------------------" << endl;
+
+    // A banded system with rows of different lengths. The size is not a
+    // multiple of the chunk size of SELL-C-sigma.
+    //
+    size_t n_sp = 4 * SPARSE_SELL_C + 3;
+    Matrix mat_band(n_sp);
+    Vector b_sp(n_sp), x_sp(n_sp), y_dense, y_sparse;
+    for (size_t i = 0; i < n_sp; i++) {
+        mat_band[i][i] = 10.0;
+        for (size_t j = (i > i % 4 ? i - i % 4 : 0); j < i; j++) {
+            mat_band[i][j] = mat_band[j][i] = -(rand() % 100) / 100.0;
+        }
+        x_sp[i] = (rand() % 100) / 10.0;
+    }
+
+    SparseMatrix sp_band(mat_band);
+    mat_band.multiply(x_sp, y_dense);
+
+    double max_sp = 0.0;
+    for (int use_sell = 0; use_sell <= 1; use_sell++) {
+        sp_band.setLayout(use_sell ? SparseMatrix::SELL : SparseMatrix::CSR, 4);
+        sp_band.multiply(x_sp, y_sparse);
+        for (size_t i = 0; i < n_sp; i++) {
+            max_sp = max(max_sp, abs(y_sparse[i] - y_dense[i]));
+        }
+
+        // Ranges of rows, which are aligned to the chunks or not
+        size_t align = sp_band.rowAlignment();
+        size_t bounds[] = {0, align, align + 1, 3 * align, n_sp};
+        y_sparse = Vector(n_sp, 0.0);
+        for (size_t k = 0; k + 1 < sizeof (bounds) / sizeof (bounds[0]); k++) {
+            sp_band.multiplyRows(bounds[k], bounds[k + 1], x_sp.data(), y_sparse.data());
+        }
+        for (size_t i = 0; i < n_sp; i++) {
+            max_sp = max(max_sp, abs(y_sparse[i] - y_dense[i]));
+        }
+    }
+
+    Matrix mat_back = sp_band.toMatrix();
+    for (size_t i = 0; i < n_sp; i++) {
+        for (size_t j = 0; j < n_sp; j++) {
+            max_sp = max(max_sp, abs(mat_back[i][j] - mat_band[i][j]));
+        }
+    }
+
+    cout << "Stored values: " << sp_band.nnz() << " of " << n_sp * n_sp << endl
+            << "Maximum difference from the dense matrix: " << max_sp << endl;
+
+    if (max_sp > 1.0e-12 || sp_band.diagonal(5) != 10.0 || sp_band.value(0, n_sp - 1) != 0.0) {
+        cout << "Error: Sparse matrix is not correct." << endl;
+        return 1;
+    }
+
+    // Duplicates of the triplets are added up
+    SparseMatrix sp_triplets(2, 3, {1, 0, 1}, {2, 1, 2}, {1.5, 2.0, 0.5});
+    if (sp_triplets.nnz() != 2 || sp_triplets.value(1, 2) != 2.0 ||
+            sp_triplets.value(0, 1) != 2.0 || sp_triplets.rowPointers()[1] != 1) {
+        cout << "Error: Sparse matrix from triplets is not correct." << endl;
+        return 1;
+    }
+
+    // The solvers work on the sparse matrix as on the dense matrix
+    SparseMatrix sp_gs(mat_gs);
+    sp_gs.setLayout(SparseMatrix::SELL);
+
+    Jacobi jacobi_sp(sp_gs);
+    x_gs = Vector(mat_gs.nrows(), 0.0);
+    double resid_sp = jacobi_sp.solve(b_gs, x_gs, 100, 1.0e-10);
+
+    GaussSeidel gauss_sp(sp_gs, 1.1, true, 2);
+    Vector x_gs_sp(mat_gs.nrows(), 0.0);
+    resid_sp = max(resid_sp, gauss_sp.solve(b_gs, x_gs_sp, 100, 1.0e-10));
+
+    cout << "Residual of the sparse solvers: " << resid_sp << endl;
+    if (resid_sp > 1.0e-10 || abs(x_gs[7] - 1) > 1.0e-10 || abs(x_gs_sp[7] - 1) > 1.0e-10) {
+        cout << "Error: Solvers do not converge on the sparse matrix." << endl;
+        return 1;
+    }
+
+    // The readers of Matrix Market and dense csv files
+    const char *mm_file = "testMatrix.mtx", *csv_file = "testMatrix.csv";
+    {
+        ofstream mm(mm_file), csv(csv_file);
+        mm << "%%MatrixMarket matrix coordinate real symmetric" << endl
+                << "% The lower triangle" << endl
+                << "3 3 4" << endl << "1 1 4.0" << endl << "2 1 -1.5" << endl
+                << "2 2 4.0" << endl << "3 3 2.5e-1" << endl;
+        csv << "4, -1.5, 0" << endl << "-1.5, 4, 0" << endl << "0, 0, 0.25" << endl;
+    }
+
+    SparseMatrix sp_mm, sp_csv;
+    sp_mm.readMatrix(mm_file);
+    sp_csv.readMatrix(csv_file);
+    remove(mm_file);
+    remove(csv_file);
+
+    bool same = (sp_mm.nnz() == 5 && sp_csv.nnz() == 5);
+    for (size_t i = 0; same && i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            if (sp_mm.value(i, j) != sp_csv.value(i, j)) same = false;
+        }
+    }
+
+    if (!same || sp_mm.value(0, 1) != -1.5 || sp_mm.value(2, 2) != 0.25) {
+        cout << "Error: Sparse matrix files are not read correctly." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test Krylov solvers" << endl
+            << "--------------------" << endl;
+
+    // CG needs a symmetric positive definite matrix, and the other methods
+    // are tested on the nonsymmetric matrices. With the diagonal of 4, the
+    // matrix is not diagonally dominant. The solutions are all 1s.
+    //
+    Matrix mat_spd(mat_gs.nrows()), mat_weak(mat_gs);
+    Vector b_spd(mat_gs.nrows()), b_weak(mat_gs.nrows());
+    for (size_t i = 0; i < mat_gs.nrows(); i++) {
+        mat_weak[i][i] = 4.0;
+        for (size_t j = 0; j < mat_gs.ncols(); j++) {
+            mat_spd[i][j] = mat_gs[i][j] + mat_gs[j][i];
+            b_spd[i] += mat_spd[i][j];
+            b_weak[i] += mat_weak[i][j];
+        }
+    }
+
+    struct {
+        const LinearOperator & A;
+        const Vector & b;
+        Krylov::Method method;
+        size_t restart;
+    } krylov_cases[] = {
+        {mat_spd, b_spd, Krylov::CG, KRYLOV_RESTART},
+        {sp_gs, b_gs, Krylov::BICGSTAB, KRYLOV_RESTART},
+        {sp_gs, b_gs, Krylov::GMRES, 3},
+        {mat_weak, b_weak, Krylov::GMRES, KRYLOV_RESTART}
+    };
+
+    for (const auto & test : krylov_cases) {
+        Krylov krylov(test.A, test.method, test.restart);
+        Vector x_krylov(test.b.size(), 0.0);
+        double resid_krylov = krylov.solve(test.b, x_krylov, 100, 1.0e-10);
+
+        double max_error = 0.0;
+        for (size_t i = 0; i < x_krylov.size(); i++) {
+            max_error = max(max_error, abs(x_krylov[i] - 1));
+        }
+
+        cout << Krylov::name(test.method) << " residual: " << resid_krylov
+                << " maximum error: " << max_error << endl;
+
+        if (resid_krylov > 1.0e-10 || max_error > 1.0e-10) {
+            cout << "Error: " << Krylov::name(test.method) << " does not converge." << endl;
+            return 1;
+        }
+    }
+
+    if (Krylov::method("bicgstab") != Krylov::BICGSTAB) {
+        cout << "Error: Krylov methods are not parsed correctly." << endl;
+        return 1;
+    }
+
+    // GMRES does not normalize a residual of the L2 norm 0, which is that
+    // of an exact guess, or of a right-hand side whose squares underflow
+    //
+    Krylov gmres_zero(sp_gs, Krylov::GMRES);
+    Vector b_tiny(b_gs.size(), 1.0e-170), x_zero(b_gs.size(), 0.0), x_exact(b_gs.size(), 0.0);
+    gmres_zero.solve(b_tiny, x_zero, 10, Convergence(0.0));
+    Convergence::Status status_tiny = gmres_zero.status();
+
+    Vector b_exact = sp_gs * Vector(b_gs.size(), 1.0);
+    x_exact.fill(1.0);
+    gmres_zero.solve(b_exact, x_exact, 10, Convergence(0.0));
+
+    bool zero_finite = true;
+    for (size_t i = 0; i < b_gs.size(); i++) {
+        if (!std::isfinite(x_zero[i]) || x_exact[i] != 1.0) zero_finite = false;
+    }
+
+    if (status_tiny != Convergence::CONVERGED || gmres_zero.status() != Convergence::CONVERGED ||
+            !zero_finite) {
+        cout << "Error: GMRES does not stop at a zero residual." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test preconditioners" << endl
+            << "--------------------" << endl;
+
+    // ILU(0) has no fill-in on a tridiagonal matrix, and block-Jacobi with
+    // one block is the LU factorization, so both are exact there
+    //
+    size_t n_tri = 50;
+    vector<size_t> tri_rows, tri_cols;
+    vector<double> tri_values;
+    for (size_t i = 0; i < n_tri; i++) {
+        for (size_t j = (i == 0 ? 0 : i - 1); j <= min(i + 1, n_tri - 1); j++) {
+            tri_rows.push_back(i);
+            tri_cols.push_back(j);
+            tri_values.push_back(i == j ? 2.5 : -1.0 - 0.01 * i);
+        }
+    }
+
+    SparseMatrix sp_tri(n_tri, n_tri, tri_rows, tri_cols, tri_values);
+    Vector x_tri(n_tri), b_tri, z_tri;
+    for (size_t i = 0; i < n_tri; i++) x_tri[i] = sin(i + 1.0);
+    sp_tri.multiply(x_tri, b_tri);
+
+    ILU0Preconditioner ilu(sp_tri);
+    BlockJacobiPreconditioner block_lu(sp_tri.toMatrix(), 0);
+
+    double max_pc = 0.0;
+    for (const Preconditioner * M : {(const Preconditioner *) &ilu, (const Preconditioner *) &block_lu}) {
+        M->apply(b_tri, z_tri);
+        for (size_t i = 0; i < n_tri; i++) max_pc = max(max_pc, abs(z_tri[i] - x_tri[i]));
+    }
+
+    cout << "Maximum error of the exact preconditioners: " << max_pc << endl;
+    if (max_pc > 1.0e-12 || block_lu.nblocks() != 1 || ilu.applications() != 1) {
+        cout << "Error: Preconditioners are not correct." << endl;
+        return 1;
+    }
+
+    // The preconditioned methods converge to the same solution in fewer
+    // iterations
+    //
+    for (const char *name : {"jacobi", "ilu0", "block"}) {
+        unique_ptr<Preconditioner> M = makePreconditioner(name, sp_gs, 6);
+
+        for (Krylov::Method method : {Krylov::BICGSTAB, Krylov::GMRES}) {
+            Krylov krylov(sp_gs, method);
+            krylov.setPreconditioner(M.get());
+
+            Vector x_pc(b_gs.size(), 0.0);
+            double resid_pc = krylov.solve(b_gs, x_pc, 100, 1.0e-10);
+
+            double max_error = 0.0;
+            for (size_t i = 0; i < x_pc.size(); i++) max_error = max(max_error, abs(x_pc[i] - 1));
+
+            cout << Krylov::name(method) << " with " << M->name() << " residual: " << resid_pc
+                    << " maximum error: " << max_error << endl;
+
+            if (resid_pc > 1.0e-10 || max_error > 1.0e-10) {
+                cout << "Error: Preconditioned " << Krylov::name(method) << " does not converge." << endl;
+                return 1;
+            }
+        }
+    }
+
+    JacobiPreconditioner jacobi_pc(mat_spd);
+    Krylov pcg(mat_spd, Krylov::CG);
+    pcg.setPreconditioner(&jacobi_pc);
+    Vector x_pcg(b_spd.size(), 0.0);
+    if (pcg.solve(b_spd, x_pcg, 100, 1.0e-10) > 1.0e-10 || abs(x_pcg[3] - 1) > 1.0e-10) {
+        cout << "Error: Preconditioned CG does not converge." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test batches of right-hand sides" << endl
+            << "--------------------" << endl;
+
+    // The blocked products agree with the products of the single columns
+    size_t n_rhs = 3;
+    Matrix X_rhs(n_sp, n_rhs), Y_dense, Y_sparse, Y_default;
+    for (size_t i = 0; i < n_sp; i++) {
+        for (size_t j = 0; j < n_rhs; j++) X_rhs[i][j] = x_sp[i] * (j + 1) - j;
+    }
+
+    mat_band.multiplyBlock(X_rhs, Y_dense);
+    sp_band.multiplyBlock(X_rhs, Y_sparse);
+    sp_band.LinearOperator::multiplyBlock(X_rhs, Y_default);
+
+    double max_block = 0.0;
+    for (size_t i = 0; i < n_sp; i++) {
+        for (size_t j = 0; j < n_rhs; j++) {
+            max_block = max(max_block, abs(Y_dense[i][j] - Y_default[i][j]));
+            max_block = max(max_block, abs(Y_sparse[i][j] - Y_default[i][j]));
+        }
+        max_block = max(max_block, abs(Y_dense[i][0] - y_dense[i]));
+    }
+
+    cout << "Maximum difference of the blocked products: " << max_block << endl;
+    if (max_block > 1.0e-12 || Y_sparse.ncols() != n_rhs) {
+        cout << "Error: Blocked products are not correct." << endl;
+        return 1;
+    }
+
+    // The blocked Jacobi iterations take as many iterations as the single
+    // solves, so the solutions are the same
+    //
+    Matrix B_gs(mat_gs.nrows(), n_rhs), X_gs(mat_gs.nrows(), n_rhs);
+    for (size_t i = 0; i < mat_gs.nrows(); i++) {
+        for (size_t j = 0; j < n_rhs; j++) B_gs[i][j] = b_gs[i] * (j + 1);
+        B_gs[i][2] = b_gs[i] * 1.0e-6;
+    }
+
+    double resid_batch = jacobi_sp.solve(B_gs, X_gs, 100, 1.0e-10);
+
+    double max_batch = 0.0;
+    for (size_t j = 0; j < n_rhs; j++) {
+        Vector b_j(mat_gs.nrows()), x_j(mat_gs.nrows(), 0.0);
+        for (size_t i = 0; i < b_j.size(); i++) b_j[i] = B_gs[i][j];
+        jacobi_sp.solve(b_j, x_j, 100, 1.0e-10);
+        for (size_t i = 0; i < x_j.size(); i++) max_batch = max(max_batch, abs(X_gs[i][j] - x_j[i]));
+    }
+
+    Matrix R_gs;
+    Vector resids_gs = residuals(sp_gs, X_gs, B_gs, R_gs);
+
+    cout << "Residual of the batch: " << resid_batch
+            << " maximum difference from the single solves: " << max_batch << endl;
+    if (resid_batch > 1.0e-10 || max_batch > 1.0e-12 || normInf(resids_gs) != resid_batch) {
+        cout << "Error: Jacobi does not solve the batch correctly." << endl;
+        return 1;
+    }
+
+    // The solutions are written and read back exactly. A directory of
+    // vectors is read in the order of the file names.
+    //
+    const char *rhs_file = "testMatrix_rhs.csv", *rhs_dir = "testMatrix_rhs";
+    X_gs.writeMatrix(rhs_file);
+    Matrix X_read = readRightHandSides(rhs_file);
+    remove(rhs_file);
+
+    mkdir(rhs_dir, 0755);
+    {
+        ofstream b1(string(rhs_dir) + "/b1.csv"), b0(string(rhs_dir) + "/b0.csv");
+        b0 << "1" << endl << "2" << endl;
+        b1 << "3,4" << endl;
+    }
+    Matrix B_dir = readRightHandSides(rhs_dir);
+    remove((string(rhs_dir) + "/b0.csv").c_str());
+    remove((string(rhs_dir) + "/b1.csv").c_str());
+    rmdir(rhs_dir);
+
+    bool same_read = (X_read.nrows() == X_gs.nrows() && X_read.ncols() == n_rhs);
+    for (size_t i = 0; same_read && i < X_gs.nrows(); i++) {
+        for (size_t j = 0; j < n_rhs; j++) {
+            if (X_read[i][j] != X_gs[i][j]) same_read = false;
+        }
+    }
+
+    if (!same_read || B_dir.nrows() != 2 || B_dir.ncols() != 2 ||
+            B_dir[1][0] != 2 || B_dir[0][1] != 3) {
+        cout << "Error: Right-hand sides are not read correctly." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test the solution cache" << endl
+            << "--------------------" << endl;
+
+    // The solution of b_gs is found again exactly, and it is the initial
+    // guess of a slightly different system
+    //
+    const char *cache_dir = "testMatrix_cache";
+    SolutionCache cache(cache_dir);
+    Vector b_near(b_gs), x_cache, x_small(3, 0.0);
+    b_near[4] *= 1.001;
+
+    unsigned long long key_gs = fingerprint(mat_gs, b_gs), key_near = fingerprint(mat_gs, b_near);
+    x_gs = Vector(mat_gs.nrows(), 1.0);
+    cache.store(key_gs, mat_gs, b_gs, x_gs);
+
+    double distance_exact = -1, distance_near = -1, distance_none = -1;
+    SolutionCache::Match match_exact = cache.lookup(key_gs, sp_gs, b_gs, x_cache, distance_exact);
+    SolutionCache::Match match_near = cache.lookup(key_near, mat_gs, b_near, x_small, distance_near);
+    SolutionCache::Match match_none = cache.lookup(key_near, mat_spd, b_near, x_small, distance_none, 1.0e-6);
+
+    remove(cache.file(key_gs).c_str());
+    rmdir(cache_dir);
+
+    cout << "Distance of the close system: " << distance_near << endl;
+    if (match_exact != SolutionCache::EXACT || distance_exact != 0.0 || x_cache[5] != 1.0 ||
+            match_near != SolutionCache::CLOSEST || distance_near <= 0.0 || x_small[2] != 1.0 ||
+            match_none != SolutionCache::NONE || key_gs == key_near ||
+            key_gs == fingerprint(sp_gs, b_gs)) {
+        cout << "Error: The solution cache is not correct." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test mixed-precision refinement" << endl
+            << "--------------------" << endl;
+
+    // The values of mat_gs are not exact in float. Jacobi on the copy in
+    // single precision alone stops at the precision of float, and the
+    // refinement goes on to the precision of double.
+    //
+    SingleMatrix single_gs(mat_gs), single_sp(sp_gs);
+    Jacobi jacobi_single(single_gs);
+
+    Vector x_single(mat_gs.nrows(), 0.0), r_single;
+    jacobi_single.solve(b_gs, x_single, 100, 1.0e-12);
+    r_single = b_gs - mat_gs * x_single;
+    double resid_single = norm1(r_single);
+
+    IterativeRefinement refinement(mat_gs, [&jacobi_single](const Vector & r, Vector & d) {
+        jacobi_single.solve(r, d, 100, REFINEMENT_INNER_TOLERANCE * norm1(r));
+    });
+    Vector x_refined(mat_gs.nrows(), 0.0);
+    double resid_refined = refinement.solve(b_gs, x_refined, 1.0e-12);
+
+    Vector y_single, y_single_sp;
+    single_gs.multiply(b_gs, y_single);
+    single_sp.multiply(b_gs, y_single_sp);
+    double max_single = 0.0;
+    for (size_t i = 0; i < y_single.size(); i++) {
+        max_single = max(max_single, abs(y_single[i] - y_single_sp[i]));
+    }
+
+    cout << "Residual in single precision: " << resid_single << endl
+            << "Residual after " << refinement.steps() << " refinements: " << resid_refined << endl;
+    if (resid_single < 1.0e-10 || resid_refined > 1.0e-12 || abs(x_refined[7] - 1) > 1.0e-12 ||
+            max_single > 1.0e-12 || single_gs.bytes() != mat_gs.nrows() * mat_gs.ncols() * sizeof (float) ||
+            single_sp.diagonal(3) != 40.0) {
+        cout << "Error: Mixed-precision refinement is not correct." << endl;
+        return 1;
+    }
+
+    cout << "--------------------" << endl
+            << "Test convergence criteria" << endl
+            << "--------------------" << endl;
+
+    Vector r_norms(3, 0.0);
+    r_norms[0] = 3.0;
+    r_norms[1] = -4.0;
+
+    Convergence criterion_l1, criterion_l2(1.0e-3, Convergence::L2),
+            criterion_inf(1.0e-3, Convergence::LINF, true);
+    if (criterion_l1.measure(r_norms) != 7.0 || criterion_l2.measure(r_norms) != 5.0 ||
+            criterion_inf.measure(r_norms) != 4.0 || criterion_inf.threshold(10.0) != 1.0e-2 ||
+            Convergence::norm("INF") != Convergence::LINF) {
+        cout << "Error: Norms of the criteria are not correct." << endl;
+        return 1;
+    }
+
+    // Stagnation after 3 checks without 1% of progress, and divergence
+    // above 10 times the first residual
+    //
+    Convergence criterion_stop(1.0);
+    criterion_stop.setStagnation(3);
+    criterion_stop.setDivergence(10.0);
+
+    ConvergenceMonitor monitor_stagnation(criterion_stop, 0.0), monitor_divergence(criterion_stop, 0.0);
+    vector<Convergence::Status> statuses;
+    for (double resid : {5.0, 4.99, 4.98, 4.97}) statuses.push_back(monitor_stagnation.check(resid));
+    for (double resid : {5.0, 60.0}) statuses.push_back(monitor_divergence.check(resid));
+
+    if (statuses[2] != Convergence::ITERATING || statuses[3] != Convergence::STAGNATED ||
+            statuses[4] != Convergence::ITERATING || statuses[5] != Convergence::DIVERGED ||
+            ConvergenceMonitor(criterion_stop, 0.0).check(0.5) != Convergence::CONVERGED) {
+        cout << "Error: The convergence monitor is not correct." << endl;
+        return 1;
+    }
+
+    // The solvers stop at a relative L-inf tolerance and return the norm of
+    // the residual of x. Gauss-Seidel only estimates it during the sweeps.
+    //
+    Convergence criterion_rel(1.0e-8, Convergence::LINF, true);
+    double threshold_rel = criterion_rel.threshold(criterion_rel.measure(b_gs));
+
+    GaussSeidel gauss_rel(mat_gs);
+    Krylov krylov_rel(mat_gs, Krylov::BICGSTAB);
+    Jacobi jacobi_rel(mat_gs);
+
+    for (int solver = 0; solver < 3; solver++) {
+        Vector x_rel(mat_gs.nrows(), 0.0), r_rel;
+        double resid_rel;
+        Convergence::Status status_rel;
+
+        if (solver == 0) {
+            resid_rel = jacobi_rel.solve(b_gs, x_rel, 100, criterion_rel);
+            status_rel = jacobi_rel.status();
+        } else if (solver == 1) {
+            resid_rel = gauss_rel.solve(b_gs, x_rel, 100, criterion_rel);
+            status_rel = gauss_rel.status();
+        } else {
+            resid_rel = krylov_rel.solve(b_gs, x_rel, 100, criterion_rel);
+            status_rel = krylov_rel.status();
+        }
+
+        r_rel = b_gs - mat_gs * x_rel;
+        double resid_true = criterion_rel.measure(r_rel);
+
+        cout << "Solver " << solver << " L-inf residual: " << resid_true << endl;
+        if (status_rel != Convergence::CONVERGED || resid_true > 1.01 * threshold_rel ||
+                abs(resid_rel - resid_true) > 1.0e-3 * threshold_rel) {
+            cout << "Error: Solver " << solver << " does not stop with the criterion." << endl;
+            return 1;
+        }
+    }
+
+    cout << "--------------------" << endl
+            << "Test Chebyshev acceleration" << endl
+            << "--------------------" << endl;
+
+    // A symmetric tridiagonal system, whose Jacobi iteration matrix has the
+    // spectral radius 2 / 2.2 * cos(pi / 51)
+    //
+    size_t n_cheb = 50;
+    Matrix mat_cheb(n_cheb);
+    Vector b_cheb(n_cheb, 0.0);
+    for (size_t i = 0; i < n_cheb; i++) {
+        mat_cheb[i][i] = 2.2;
+        if (i > 0) mat_cheb[i][i - 1] = -1.0;
+        if (i + 1 < n_cheb) mat_cheb[i][i + 1] = -1.0;
+        for (size_t j = 0; j < n_cheb; j++) b_cheb[i] += mat_cheb[i][j];
+    }
+
+    Jacobi jacobi_cheb(mat_cheb);
+    double rho_exact = 2.0 / 2.2 * cos(acos(-1.0) / 51.0);
+    double rho_cheb = jacobiRadius(mat_cheb, jacobi_cheb.inverseDiagonal(), 200);
+    cout << "Spectral radius: " << rho_cheb << " (exact " << rho_exact << ")" << endl;
+
+    if (abs(rho_cheb - rho_exact) > 1.0e-3) {
+        cout << "Error: The spectral radius estimate is not correct." << endl;
+        return 1;
+    }
+
+    // The plain iterations do not converge in 100 iterations, and the
+    // accelerated ones do with the estimate of the radius, also in a team
+    // of threads
+    //
+    Vector x_plain(n_cheb, 0.0);
+    jacobi_cheb.solve(b_cheb, x_plain, 100, 1.0e-10);
+    Convergence::Status status_plain = jacobi_cheb.status();
+
+    jacobi_cheb.setChebyshev(true);
+    for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+        ExecutionContext::setCurrent(ExecutionContext(nthreads, 0));
+        Vector x_cheb(n_cheb, 0.0);
+        double resid_cheb = jacobi_cheb.solve(b_cheb, x_cheb, 100, 1.0e-10);
+        ExecutionContext::setCurrent(ExecutionContext());
+
+        cout << "Threads " << nthreads << " accelerated residual: " << resid_cheb << endl;
+        if (status_plain != Convergence::ITERATING || jacobi_cheb.status() != Convergence::CONVERGED ||
+                abs(x_cheb[7] - 1) > 1.0e-9) {
+            cout << "Error: The Chebyshev acceleration is not correct." << endl;
+            return 1;
+        }
+    }
+
+    // A batch takes the accelerated iterations and the checks of the
+    // single solves, also when its columns converge at different steps
+    //
+    jacobi_cheb.setCheckInterval(3);
+    Matrix B_cheb(n_cheb, 2), X_cheb(n_cheb, 2);
+    for (size_t i = 0; i < n_cheb; i++) {
+        B_cheb[i][0] = b_cheb[i];
+        B_cheb[i][1] = b_cheb[i] * (i % 3);
+    }
+
+    double resid_cheb_batch = jacobi_cheb.solve(B_cheb, X_cheb, 100, 1.0e-10);
+    Convergence::Status status_cheb_batch = jacobi_cheb.status();
+
+    double max_cheb = 0.0;
+    for (size_t j = 0; j < 2; j++) {
+        Vector b_j(n_cheb), x_j(n_cheb, 0.0);
+        for (size_t i = 0; i < n_cheb; i++) b_j[i] = B_cheb[i][j];
+        jacobi_cheb.solve(b_j, x_j, 100, 1.0e-10);
+        for (size_t i = 0; i < n_cheb; i++) max_cheb = max(max_cheb, abs(X_cheb[i][j] - x_j[i]));
+    }
+    jacobi_cheb.setCheckInterval(1);
+
+    cout << "Accelerated batch residual: " << resid_cheb_batch
+            << " maximum difference from the single solves: " << max_cheb << endl;
+    if (status_cheb_batch != Convergence::CONVERGED || max_cheb > 1.0e-12) {
+        cout << "Error: The accelerated batch is not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test streamed matrices" << endl
+            << "---------------------" << endl;
+
+    // Panels of 3 rows, which do not divide the 20 rows, with one thread
+    // and with a thread that reads while the others multiply
+    //
+    const char *stream_file = "testMatrix_stream.bin";
+    mat_gs.writeBinary(stream_file);
+    StreamedMatrix mat_stream(stream_file, 3 * mat_gs.ncols() * sizeof (double));
+
+    Matrix X_stream(mat_gs.nrows(), 3), Y_stream, Y_memory;
+    for (size_t i = 0; i < X_stream.nrows(); i++) {
+        for (size_t j = 0; j < X_stream.ncols(); j++) X_stream[i][j] = i + 0.5 * j;
+    }
+    Y_memory = mat_gs * X_stream;
+
+    for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+        ExecutionContext::setCurrent(ExecutionContext(nthreads, 0));
+        Vector x_col(X_stream.nrows()), y_stream, y_rows(mat_gs.nrows());
+        for (size_t i = 0; i < X_stream.nrows(); i++) x_col[i] = X_stream[i][1];
+        mat_stream.multiply(x_col, y_stream);
+        mat_stream.multiplyBlock(X_stream, Y_stream);
+        mat_stream.multiplyRows(5, 17, x_col.data(), y_rows.data());
+        ExecutionContext::setCurrent(ExecutionContext());
+
+        for (size_t i = 0; i < mat_gs.nrows(); i++) {
+            for (size_t j = 0; j < X_stream.ncols(); j++) {
+                if (abs(Y_stream[i][j] - Y_memory[i][j]) > 1.0e-10) {
+                    cout << "Error: The streamed block product is not correct." << endl;
+                    return 1;
+                }
+            }
+
+            if (abs(y_stream[i] - Y_memory[i][1]) > 1.0e-10 ||
+                    (i >= 5 && i < 17 && abs(y_rows[i] - Y_memory[i][1]) > 1.0e-10)) {
+                cout << "Error: The streamed product is not correct." << endl;
+                return 1;
+            }
+        }
+    }
+
+    // The Jacobi iterations on the streamed matrix are the same
+    Jacobi jacobi_stream(mat_stream);
+    Vector x_stream(mat_gs.nrows(), 0.0), x_memory(mat_gs.nrows(), 0.0);
+    double resid_stream = jacobi_stream.solve(b_gs, x_stream, 100, 1.0e-10);
+    jacobi.setCheckInterval(1);
+    jacobi.solve(b_gs, x_memory, 100, 1.0e-10);
+    double row_stream = mat_stream.rowProduct(4, x_memory.data());
+
+    // With more threads than rows in a panel, and with the symmetric
+    // Gauss-Seidel sweeps, which read the panels forwards and backwards
+    //
+    ExecutionContext::setCurrent(ExecutionContext(4, 0));
+    Vector x_stream4(mat_gs.nrows(), 0.0);
+    jacobi_stream.solve(b_gs, x_stream4, 100, 1.0e-10);
+    ExecutionContext::setCurrent(ExecutionContext());
+
+    GaussSeidel ssor_stream(mat_stream, 1.2, true), ssor_memory(mat_gs, 1.2, true);
+    Vector x_ssor_stream(mat_gs.nrows(), 0.0), x_ssor_memory(mat_gs.nrows(), 0.0);
+    ssor_stream.solve(b_gs, x_ssor_stream, 20, 1.0e-10);
+    ssor_memory.solve(b_gs, x_ssor_memory, 20, 1.0e-10);
+    remove(stream_file);
+
+    double max_stream = 0.0;
+    for (size_t i = 0; i < mat_gs.nrows(); i++) {
+        max_stream = max(max_stream, abs(x_stream4[i] - x_memory[i]));
+        max_stream = max(max_stream, abs(x_ssor_stream[i] - x_ssor_memory[i]));
+    }
+
+    cout << "Panels of " << mat_stream.panelRows() << " rows, Jacobi residual: " << resid_stream << endl;
+    if (mat_stream.diagonal(7) != 40.0 || !mat_stream.checkDominant() || max_stream > 1.0e-12 ||
+            abs(x_stream[7] - x_memory[7]) > 1.0e-12 || abs(row_stream - b_gs[4]) > 1.0e-8) {
+        cout << "Error: The streamed matrix is not correct." << endl;
+        return 1;
+    }
+
+    cout << "---------------------" << endl
+            << "Test matrix-free operators" << endl
+            << "---------------------" << endl;
+
+    // The tridiagonal system of the Chebyshev test from its entries, and
+    // from a stencil that only computes the products
+    //
+    FunctionOperator op_entries(n_cheb, n_cheb, [](size_t i, size_t j) {
+        return (i == j ? 2.2 : (i == j + 1 || j == i + 1 ? -1.0 : 0.0));
+    });
+
+    FunctionOperator op_stencil(n_cheb, n_cheb, [n_cheb](size_t begin, size_t end,
+            const double * x, double * y) {
+        for (size_t i = begin; i < end; i++) {
+            y[i - begin] = 2.2 * x[i] - (i > 0 ? x[i - 1] : 0.0) - (i + 1 < n_cheb ? x[i + 1] : 0.0);
+        }
+    }, [](size_t) {
+        return (2.2);
+    }, true);
+
+    Vector x_ones(n_cheb, 1.0), y_entries, y_stencil;
+    for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+        ExecutionContext::setCurrent(ExecutionContext(nthreads, 0));
+        op_entries.multiply(x_ones, y_entries);
+        op_stencil.multiply(x_ones, y_stencil);
+        ExecutionContext::setCurrent(ExecutionContext());
+
+        for (size_t i = 0; i < n_cheb; i++) {
+            if (abs(y_entries[i] - b_cheb[i]) > 1.0e-12 || abs(y_stencil[i] - b_cheb[i]) > 1.0e-12 ||
+                    abs(op_stencil.rowProduct(i, x_ones.data()) - b_cheb[i]) > 1.0e-12) {
+                cout << "Error: The matrix-free product is not correct." << endl;
+                return 1;
+            }
+        }
+    }
+
+    if (!op_entries.checkDominant() || !op_stencil.checkDominant() || op_entries.diagonal(3) != 2.2) {
+        cout << "Error: The matrix-free diagonal is not correct." << endl;
+        return 1;
+    }
+
+    // The solvers take the operators like matrices
+    for (int solver = 0; solver < 3; solver++) {
+        const LinearOperator & op = (solver == 1 ? (const LinearOperator &) op_entries : op_stencil);
+        Vector x_free(n_cheb, 0.0);
+        double resid_free;
+
+        if (solver == 0) {
+            Jacobi jacobi_free(op);
+            jacobi_free.setChebyshev(true);
+            resid_free = jacobi_free.solve(b_cheb, x_free, 200, 1.0e-10);
+        } else if (solver == 1) {
+            GaussSeidel gauss_free(op, 1.5);
+            resid_free = gauss_free.solve(b_cheb, x_free, 200, 1.0e-10);
+        } else {
+            Krylov krylov_free(op, Krylov::CG);
+            resid_free = krylov_free.solve(b_cheb, x_free, 100, 1.0e-10);
+        }
+
+        cout << "Solver " << solver << " matrix-free residual: " << resid_free << endl;
+        if (resid_free > 1.0e-10 || abs(x_free[7] - 1) > 1.0e-9) {
+            cout << "Error: The matrix-free solve is not correct." << endl;
+            return 1;
+        }
+    }
+
     return 0;
 }